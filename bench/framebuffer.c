@@ -0,0 +1,116 @@
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <SDL2/SDL.h>
+
+#include "../src/conf.h"
+#include "../src/framebuffer.h"
+
+
+/**
+ * Number of frames drawn by every benchmark.
+ */
+#define FRAMES 200
+
+
+static const Uint32 ceil_color = 0xFF0A0A14;
+static const Uint32 floor_color = 0xFF000000;
+
+
+/**
+ * @brief Computes the wall stripe of a column of a synthetic frame, which is as tall as the screen at most.
+ */
+static void wall_of(const int x, int *const top, int *const bottom, Uint32 *const color) {
+    const int height = (int) ((float) SCREEN_HEIGHT * (0.2F + 0.8F * fabsf(sinf((float) x * 0.005F))));
+
+    *top = (SCREEN_HEIGHT - height) / 2;
+    *bottom = *top + height;
+    *color = 0xFF000000 | (Uint32) (x & 0xFF) << 16;
+}
+
+/**
+ * @brief Fills the rows [top, bottom) of a column of a row-major image, one cache line per pixel.
+ */
+static void fill_rows(Uint32 *const pixels, const int x, const int top, const int bottom, const Uint32 color) {
+    for (int y = top; y < bottom; y++) {
+        pixels[(size_t) y * SCREEN_WIDTH + (size_t) x] = color;
+    }
+}
+
+static void draw_rows(Uint32 *const pixels) {
+    for (int x = 0; x < SCREEN_WIDTH; x++) {
+        int top, bottom;
+        Uint32 color;
+
+        wall_of(x, &top, &bottom, &color);
+        fill_rows(pixels, x, 0, top, ceil_color);
+        fill_rows(pixels, x, top, bottom, color);
+        fill_rows(pixels, x, bottom, SCREEN_HEIGHT, floor_color);
+    }
+}
+
+static void draw_columns(const struct framebuffer_t *const framebuffer) {
+    for (int x = 0; x < SCREEN_WIDTH; x++) {
+        int top, bottom;
+        Uint32 color;
+
+        wall_of(x, &top, &bottom, &color);
+        framebuffer_fill_column(framebuffer, x, 0, top, ceil_color);
+        framebuffer_fill_column(framebuffer, x, top, bottom, color);
+        framebuffer_fill_column(framebuffer, x, bottom, SCREEN_HEIGHT, floor_color);
+    }
+}
+
+static double elapsed_ms(const Uint64 start) {
+    return (double) (SDL_GetPerformanceCounter() - start) / (double) SDL_GetPerformanceFrequency() * 1000;
+}
+
+int main(void) {
+    static struct framebuffer_t framebuffer;
+    Uint32 *const pixels = malloc((size_t) SCREEN_WIDTH * SCREEN_HEIGHT * sizeof *pixels);
+
+    if (pixels == NULL || framebuffer_create(&framebuffer, NULL, SCREEN_WIDTH, SCREEN_HEIGHT) != 0) {
+        fprintf(stderr, "unable to allocate a %d x %d frame\n", SCREEN_WIDTH, SCREEN_HEIGHT);
+        free(pixels);
+        return EXIT_FAILURE;
+    }
+
+    /* touch every page once, so that the first benchmark does not pay for the page faults */
+    draw_rows(pixels);
+    draw_columns(&framebuffer);
+
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    for (int i = 0; i < FRAMES; i++) {
+        draw_rows(pixels);
+    }
+
+    const double rows = elapsed_ms(start) / FRAMES;
+    start = SDL_GetPerformanceCounter();
+
+    for (int i = 0; i < FRAMES; i++) {
+        draw_columns(&framebuffer);
+    }
+
+    const double columns = elapsed_ms(start) / FRAMES;
+    start = SDL_GetPerformanceCounter();
+
+    for (int i = 0; i < FRAMES; i++) {
+        framebuffer_transpose(&framebuffer, pixels, SCREEN_WIDTH, 0, SCREEN_HEIGHT);
+    }
+
+    const double transpose = elapsed_ms(start) / FRAMES;
+
+    printf("frame: %d x %d px, %d frames, single thread\n", SCREEN_WIDTH, SCREEN_HEIGHT, FRAMES);
+    printf("row-major writes:              %8.3f ms/frame\n", rows);
+    printf("column-major writes:           %8.3f ms/frame\n", columns);
+    printf("transpose:                     %8.3f ms/frame\n", transpose);
+    printf("column-major writes+transpose: %8.3f ms/frame (%.2fx)\n", columns + transpose,
+           rows / (columns + transpose));
+
+    framebuffer_destroy(&framebuffer);
+    free(pixels);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,60 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "logger.h"
+
+#include "arena.h"
+
+
+int arena_create(struct arena_t *const arena, const size_t size) {
+    memset(arena, 0, sizeof *arena);
+
+    arena->base = malloc(size > 0 ? size : 1);
+
+    if (arena->base == NULL) {
+        logger_perror("malloc");
+        return -1;
+    }
+
+    arena->size = size;
+    return 0;
+}
+
+void arena_destroy(struct arena_t *const arena) {
+    free(arena->base);
+    memset(arena, 0, sizeof *arena);
+}
+
+void *arena_alloc(struct arena_t *const arena, const size_t size) {
+    const size_t offset = (arena->used + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+
+    if (offset > arena->size || size > arena->size - offset) {
+        return NULL;
+    }
+
+    arena->used = offset + size;
+    arena->last = arena->base + offset;
+
+    return arena->last;
+}
+
+void *arena_grow(struct arena_t *const arena, void *const block, const size_t old_size, const size_t new_size) {
+    if (block != NULL && block == arena->last) {
+        const size_t offset = (size_t) ((char *) block - arena->base);
+
+        if (new_size > arena->size - offset) {
+            return NULL;
+        }
+
+        arena->used = offset + new_size;
+        return block;
+    }
+
+    void *const new_block = arena_alloc(arena, new_size);
+
+    if (new_block != NULL && block != NULL) {
+        memcpy(new_block, block, old_size);
+    }
+
+    return new_block;
+}
@@ -0,0 +1,66 @@
+#ifndef RAY_ARENA_H
+#define RAY_ARENA_H
+
+
+#include <stddef.h>
+
+
+/**
+ * @brief Alignment of every block in bytes, enough for any scalar or SSE type; a power of two.
+ */
+#define ARENA_ALIGN ((size_t) 16)
+
+
+/**
+ * @brief A bump allocator carving blocks out of a single allocation of fixed size.
+ *
+ * Blocks are never freed on their own; the whole arena is released at once, so the number of bytes used is also
+ * the peak usage. The block allocated last can grow in place, which lets a pool that is filled without
+ * interruption extend without copying.
+ */
+struct arena_t {
+    char *base; /**< The memory of the arena. */
+    size_t size; /**< The size of the arena in bytes, its memory budget. */
+    size_t used; /**< The number of bytes handed out so far, including padding and abandoned blocks. */
+    void *last; /**< The block allocated last, or NULL. */
+};
+
+
+/**
+ * @brief Allocates the memory of an arena.
+ *
+ * @param arena The arena to initialize.
+ * @param size The size of the arena in bytes.
+ * @return 0 on success, -1 on error.
+ */
+int arena_create(struct arena_t *arena, size_t size);
+
+/**
+ * @brief Frees the memory of an arena, and with it all blocks allocated from it.
+ * @param arena The arena to destroy.
+ */
+void arena_destroy(struct arena_t *arena);
+
+/**
+ * @brief Allocates a block from an arena, aligned to ARENA_ALIGN bytes.
+ *
+ * @param arena The arena.
+ * @param size The size of the block in bytes.
+ * @return The block, or NULL if it does not fit into the arena.
+ */
+void *arena_alloc(struct arena_t *arena, size_t size);
+
+/**
+ * @brief Grows a block of an arena. The block is extended in place if it was allocated last, otherwise its
+ *        contents are copied into a new block and the old block is abandoned.
+ *
+ * @param arena The arena.
+ * @param block The block, or NULL to allocate a new block.
+ * @param old_size The current size of the block in bytes.
+ * @param new_size The new size of the block in bytes, at least @p old_size.
+ * @return The grown block, or NULL if it does not fit into the arena (@p block is left unchanged in this case).
+ */
+void *arena_grow(struct arena_t *arena, void *block, size_t old_size, size_t new_size);
+
+
+#endif //RAY_ARENA_H
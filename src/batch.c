@@ -0,0 +1,270 @@
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "logger.h"
+#include "math.h"
+
+#include "batch.h"
+
+
+/**
+ * Maximum number of distinct line colors grouped in linear time; beyond that the lines are sorted.
+ */
+#define BATCH_COLORS_MAX 32
+
+
+/**
+ * @brief Grows the quad buffers to hold at least one more quad.
+ * @return 0 on success, -1 on error.
+ */
+static int grow_quads(struct batch_t *const batch) {
+    const size_t capacity = SDL_max(2 * batch->quad_capacity, 256);
+
+    if (capacity > INT_MAX / 6) {
+        logger_print(LOG_LEVEL_ERROR, "too many quads in batch");
+        return -1;
+    }
+
+    SDL_Vertex *const vertices = realloc(batch->vertices, 4 * capacity * sizeof *vertices);
+
+    if (vertices == NULL) {
+        logger_perror("realloc");
+        return -1;
+    }
+
+    batch->vertices = vertices;
+
+    int *const indices = realloc(batch->indices, 6 * capacity * sizeof *indices);
+
+    if (indices == NULL) {
+        logger_perror("realloc");
+        return -1;
+    }
+
+    /* the triangles never change, only the corners they refer to do */
+    for (size_t i = batch->quad_capacity; i < capacity; i++) {
+        const int base = (int) (4 * i);
+
+        indices[6 * i] = base;
+        indices[6 * i + 1] = base + 1;
+        indices[6 * i + 2] = base + 2;
+        indices[6 * i + 3] = base + 2;
+        indices[6 * i + 4] = base + 3;
+        indices[6 * i + 5] = base;
+    }
+
+    batch->indices = indices;
+    batch->quad_capacity = capacity;
+    return 0;
+}
+
+/**
+ * @brief Grows the line buffers to hold at least one more line.
+ * @return 0 on success, -1 on error.
+ */
+static int grow_lines(struct batch_t *const batch) {
+    const size_t capacity = SDL_max(2 * batch->line_capacity, 256);
+
+    if (capacity > INT_MAX / 2) {
+        logger_print(LOG_LEVEL_ERROR, "too many lines in batch");
+        return -1;
+    }
+
+    struct batch_line_t *const lines = realloc(batch->lines, capacity * sizeof *lines);
+
+    if (lines == NULL) {
+        logger_perror("realloc");
+        return -1;
+    }
+
+    batch->lines = lines;
+
+    struct batch_line_t *const sorted = realloc(batch->sorted, capacity * sizeof *sorted);
+
+    if (sorted == NULL) {
+        logger_perror("realloc");
+        return -1;
+    }
+
+    batch->sorted = sorted;
+
+    /* a polyline has at most one more vertex than lines */
+    SDL_FPoint *const points = realloc(batch->points, (capacity + 1) * sizeof *points);
+
+    if (points == NULL) {
+        logger_perror("realloc");
+        return -1;
+    }
+
+    batch->points = points;
+    batch->line_capacity = capacity;
+    return 0;
+}
+
+void batch_destroy(struct batch_t *const batch) {
+    free(batch->vertices);
+    free(batch->indices);
+    free(batch->lines);
+    free(batch->sorted);
+    free(batch->points);
+    *batch = (struct batch_t) {0};
+}
+
+void batch_fill_rect(struct batch_t *const restrict batch, const SDL_FRect *const restrict rect,
+                     const SDL_Color color) {
+    batch_fill_trapezoid(batch, rect->x, rect->y, rect->y + rect->h, color,
+                         rect->x + rect->w, rect->y, rect->y + rect->h, color);
+}
+
+void batch_fill_trapezoid(struct batch_t *const batch,
+                          const float x1, const float top1, const float bottom1, const SDL_Color color1,
+                          const float x2, const float top2, const float bottom2, const SDL_Color color2) {
+    if (batch->nquads == batch->quad_capacity && grow_quads(batch) != 0) {
+        return;
+    }
+
+    SDL_Vertex *const corners = &batch->vertices[4 * batch->nquads++];
+
+    corners[0] = (SDL_Vertex) {.position = {x1, top1}, .color = color1};
+    corners[1] = (SDL_Vertex) {.position = {x2, top2}, .color = color2};
+    corners[2] = (SDL_Vertex) {.position = {x2, bottom2}, .color = color2};
+    corners[3] = (SDL_Vertex) {.position = {x1, bottom1}, .color = color1};
+}
+
+void batch_draw_line(struct batch_t *const batch, const float x1, const float y1, const float x2, const float y2,
+                     const SDL_Color color) {
+    if (batch->nlines == batch->line_capacity && grow_lines(batch) != 0) {
+        return;
+    }
+
+    batch->lines[batch->nlines] = (struct batch_line_t) {
+            .a = {x1, y1},
+            .b = {x2, y2},
+            .color = color,
+            .order = batch->nlines
+    };
+    batch->nlines++;
+}
+
+static inline Uint32 color_key(const SDL_Color color) {
+    return (Uint32) color.r << 24 | (Uint32) color.g << 16 | (Uint32) color.b << 8 | (Uint32) color.a;
+}
+
+static int compare_lines(const void *const a, const void *const b) {
+    const struct batch_line_t *const x = a;
+    const struct batch_line_t *const y = b;
+    const Uint32 kx = color_key(x->color);
+    const Uint32 ky = color_key(y->color);
+
+    if (kx != ky) {
+        return kx < ky ? -1 : 1;
+    }
+
+    return (x->order > y->order) - (x->order < y->order);
+}
+
+/**
+ * @brief Groups the queued lines by color into the sorted buffer, keeping their order within each group.
+ *
+ * Frames usually use a handful of colors, which are counted and scattered in linear time; the lines are only
+ * sorted if there are too many colors.
+ */
+static void group_lines(struct batch_t *const batch) {
+    Uint32 keys[BATCH_COLORS_MAX];
+    size_t starts[BATCH_COLORS_MAX + 1] = {0};
+    size_t ncolors = 0;
+
+    for (size_t i = 0, last = 0; i < batch->nlines; i++) {
+        const Uint32 key = color_key(batch->lines[i].color);
+
+        if (ncolors == 0 || keys[last] != key) {
+            for (last = 0; last < ncolors && keys[last] != key; last++) {}
+
+            if (last == ncolors) {
+                if (ncolors == BATCH_COLORS_MAX) {
+                    memcpy(batch->sorted, batch->lines, batch->nlines * sizeof *batch->sorted);
+                    qsort(batch->sorted, batch->nlines, sizeof *batch->sorted, compare_lines);
+                    return;
+                }
+
+                keys[ncolors++] = key;
+            }
+        }
+
+        starts[last + 1]++;
+    }
+
+    for (size_t c = 0; c < ncolors; c++) {
+        starts[c + 1] += starts[c];
+    }
+
+    for (size_t i = 0, last = 0; i < batch->nlines; i++) {
+        const Uint32 key = color_key(batch->lines[i].color);
+
+        for (; keys[last] != key; last = (last + 1) % ncolors) {}
+
+        batch->sorted[starts[last]++] = batch->lines[i];
+    }
+}
+
+static inline bool points_equal(const SDL_FPoint a, const SDL_FPoint b) {
+    return isclose(a.x, b.x) && isclose(a.y, b.y);
+}
+
+/**
+ * @brief Submits the queued lines, one polyline per run of lines of the same color continuing each other.
+ */
+static void flush_lines(struct batch_t *const restrict batch, SDL_Renderer *const restrict renderer) {
+    const struct batch_line_t *const lines = batch->sorted;
+
+    group_lines(batch);
+
+    for (size_t i = 0; i < batch->nlines;) {
+        const SDL_Color color = lines[i].color;
+        int npoints = 0;
+
+        SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
+        batch->calls++;
+
+        for (; i < batch->nlines && color_key(lines[i].color) == color_key(color); i++) {
+            const struct batch_line_t *const line = &lines[i];
+
+            if (npoints > 0 && !points_equal(batch->points[npoints - 1], line->a)) {
+                SDL_RenderDrawLinesF(renderer, batch->points, npoints);
+                batch->calls++;
+                npoints = 0;
+            }
+
+            if (npoints == 0) {
+                batch->points[npoints++] = line->a;
+            }
+
+            batch->points[npoints++] = line->b;
+        }
+
+        SDL_RenderDrawLinesF(renderer, batch->points, npoints);
+        batch->calls++;
+    }
+}
+
+void batch_flush(struct batch_t *const restrict batch, SDL_Renderer *const restrict renderer) {
+    batch->calls = 0;
+
+    if (batch->nquads > 0) {
+        SDL_RenderGeometry(renderer, NULL, batch->vertices, (int) (4 * batch->nquads), batch->indices,
+                           (int) (6 * batch->nquads));
+        batch->calls++;
+    }
+
+    if (batch->nlines > 0) {
+        SDL_Color old;
+
+        SDL_GetRenderDrawColor(renderer, &old.r, &old.g, &old.b, &old.a);
+        flush_lines(batch, renderer);
+        SDL_SetRenderDrawColor(renderer, old.r, old.g, old.b, old.a);
+    }
+
+    batch->nquads = 0;
+    batch->nlines = 0;
+}
@@ -0,0 +1,96 @@
+#ifndef RAY_BATCH_H
+#define RAY_BATCH_H
+
+
+#include <stddef.h>
+
+#include <SDL2/SDL.h>
+
+
+/**
+ * @brief A line queued for drawing.
+ */
+struct batch_line_t {
+    SDL_FPoint a; /**< The first endpoint. */
+    SDL_FPoint b; /**< The second endpoint. */
+    SDL_Color color; /**< The color of the line. */
+    size_t order; /**< The position of the line in the queue, to keep the order of lines with the same color. */
+};
+
+/**
+ * @brief A command buffer collecting the filled quads and lines of a frame, to submit them with as few
+ *        renderer calls as possible.
+ *
+ * The rectangles and trapezoids are submitted as a single SDL_RenderGeometry() call with per-vertex colors. The
+ * lines are grouped by color, so that the draw color is only set once per group, and lines continuing each other
+ * are joined into a single SDL_RenderDrawLinesF() call. The buffers grow as needed and are reused across frames.
+ */
+struct batch_t {
+    SDL_Vertex *vertices; /**< The corners of the queued quads, four per quad. */
+    int *indices; /**< The two triangles of every quad, six indices per quad. */
+    size_t nquads; /**< The number of queued quads. */
+    size_t quad_capacity; /**< The number of quads the buffers can hold. */
+    struct batch_line_t *lines; /**< The queued lines. */
+    struct batch_line_t *sorted; /**< The queued lines grouped by color. */
+    SDL_FPoint *points; /**< The vertices of the polyline being submitted. */
+    size_t nlines; /**< The number of queued lines. */
+    size_t line_capacity; /**< The number of lines the buffers can hold. */
+    size_t calls; /**< The number of renderer calls made by the last flush. */
+};
+
+
+/**
+ * @brief Frees the buffers of a command buffer.
+ * @param batch The command buffer to destroy.
+ */
+void batch_destroy(struct batch_t *batch);
+
+/**
+ * @brief Queues a filled rectangle.
+ *
+ * @param batch The command buffer.
+ * @param rect The rectangle.
+ * @param color The color of the rectangle.
+ */
+void batch_fill_rect(struct batch_t *batch, const SDL_FRect *rect, SDL_Color color);
+
+/**
+ * @brief Queues a filled trapezoid with vertical left and right edges, whose color is interpolated from the left
+ *        edge to the right edge.
+ *
+ * @param batch The command buffer.
+ * @param x1 The x-coordinate of the left edge.
+ * @param top1 The top of the left edge.
+ * @param bottom1 The bottom of the left edge.
+ * @param color1 The color of the left edge.
+ * @param x2 The x-coordinate of the right edge.
+ * @param top2 The top of the right edge.
+ * @param bottom2 The bottom of the right edge.
+ * @param color2 The color of the right edge.
+ */
+void batch_fill_trapezoid(struct batch_t *batch, float x1, float top1, float bottom1, SDL_Color color1,
+                          float x2, float top2, float bottom2, SDL_Color color2);
+
+/**
+ * @brief Queues a line.
+ *
+ * @param batch The command buffer.
+ * @param x1 The x-coordinate of the first endpoint.
+ * @param y1 The y-coordinate of the first endpoint.
+ * @param x2 The x-coordinate of the second endpoint.
+ * @param y2 The y-coordinate of the second endpoint.
+ * @param color The color of the line.
+ */
+void batch_draw_line(struct batch_t *batch, float x1, float y1, float x2, float y2, SDL_Color color);
+
+/**
+ * @brief Submits the queued quads, then the queued lines, and empties the command buffer. The draw color
+ *        of the renderer is restored afterwards.
+ *
+ * @param batch The command buffer.
+ * @param renderer The renderer to draw with.
+ */
+void batch_flush(struct batch_t *batch, SDL_Renderer *renderer);
+
+
+#endif //RAY_BATCH_H
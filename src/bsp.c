@@ -0,0 +1,453 @@
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include "conf.h"
+#include "logger.h"
+#include "math.h"
+
+#include "bsp.h"
+
+
+/**
+ * Distance from a partition line within which a point is considered to lie on the line.
+ */
+#define BSP_EPSILON 0.001F
+
+
+/**
+ * @brief A piece of a wall, which lies entirely on one side of every partition line above it.
+ */
+struct fragment_t {
+    struct vec_t a; /**< The first endpoint of the fragment. */
+    struct vec_t b; /**< The second endpoint of the fragment. */
+    float lo; /**< The parameter of @p a along the wall, from 0 at its first endpoint to 1 at its second. */
+    float hi; /**< The parameter of @p b along the wall. */
+    const struct wall_t *wall; /**< The wall the fragment was cut from. */
+    uint32_t id; /**< The index of the wall the fragment was cut from. */
+};
+
+/**
+ * @brief A growable array of fragments.
+ */
+struct fragment_list_t {
+    struct fragment_t *items; /**< The fragments. */
+    size_t count; /**< The number of fragments. */
+    size_t capacity; /**< The number of fragments which fit into @p items. */
+};
+
+/**
+ * @brief The state of a BSP build.
+ */
+struct build_t {
+    struct bsp_node_t *nodes; /**< The nodes built so far. */
+    size_t capacity; /**< The number of nodes which fit into @p nodes. */
+    struct fragment_list_t out; /**< The fragments of the nodes built so far, in the order of the nodes. */
+    struct bsp_stats_t stats; /**< Statistics of the build. */
+};
+
+/**
+ * @brief The state of bsp_cast_rays().
+ */
+struct view_t {
+    const struct bsp_t *bsp; /**< The tree. */
+    const struct hits_t *hits; /**< The rays. */
+    float angle; /**< The angle of the first ray. */
+    float step; /**< The angle between two neighbouring rays. */
+    size_t period; /**< The number of steps in a full turn. */
+    size_t covered; /**< The number of rays which have hit a fragment. */
+    size_t visited; /**< The number of fragments visited. */
+};
+
+
+static int push_fragment(struct fragment_list_t *const list, const struct fragment_t fragment) {
+    if (list->count == list->capacity) {
+        const size_t capacity = SDL_max(2 * list->capacity, 16);
+        struct fragment_t *const items = realloc(list->items, capacity * sizeof *items);
+
+        if (items == NULL) {
+            logger_perror("realloc");
+            return -1;
+        }
+
+        list->items = items;
+        list->capacity = capacity;
+    }
+
+    list->items[list->count++] = fragment;
+    return 0;
+}
+
+static int push_node(struct build_t *const build, uint32_t *const index) {
+    if (build->stats.nodes == build->capacity) {
+        const size_t capacity = SDL_max(2 * build->capacity, 16);
+        struct bsp_node_t *const nodes = realloc(build->nodes, capacity * sizeof *nodes);
+
+        if (nodes == NULL) {
+            logger_perror("realloc");
+            return -1;
+        }
+
+        build->nodes = nodes;
+        build->capacity = capacity;
+    }
+
+    *index = (uint32_t) build->stats.nodes++;
+    return 0;
+}
+
+/**
+ * @brief Computes the signed distance of a point from a partition line; positive values are in front of it.
+ */
+static inline float side(const struct vec_t origin, const struct vec_t dir, const float len, const struct vec_t p) {
+    return (dir.x * (p.y - origin.y) - dir.y * (p.x - origin.x)) / len;
+}
+
+/**
+ * @brief Chooses the partition line of a node among a sample of its fragments.
+ * @return The index of the fragment defining the partition line.
+ */
+static size_t choose_splitter(const struct fragment_list_t *const list) {
+    const size_t stride = SDL_max(list->count / BSP_CANDIDATES, 1);
+    size_t best = 0;
+    float best_cost = INFINITY;
+
+    for (size_t c = 0; c < list->count && c / stride < BSP_CANDIDATES; c += stride) {
+        const struct vec_t origin = list->items[c].a;
+        const struct vec_t dir = vsub(list->items[c].b, origin);
+        const float len = vlen(dir);
+        size_t front = 0;
+        size_t back = 0;
+        size_t splits = 0;
+
+        for (size_t i = 0; i < list->count; i++) {
+            const float sa = side(origin, dir, len, list->items[i].a);
+            const float sb = side(origin, dir, len, list->items[i].b);
+
+            if (sa > BSP_EPSILON || sb > BSP_EPSILON) {
+                if (sa < -BSP_EPSILON || sb < -BSP_EPSILON) {
+                    splits++;
+                } else {
+                    front++;
+                }
+            } else if (sa < -BSP_EPSILON || sb < -BSP_EPSILON) {
+                back++;
+            }
+        }
+
+        const float imbalance = fabsf((float) front - (float) back);
+        const float cost = (float) splits * BSP_SPLIT_COST + imbalance;
+
+        if (cost < best_cost) {
+            best_cost = cost;
+            best = c;
+        }
+    }
+
+    return best;
+}
+
+/**
+ * @brief Recursively builds the subtree over a list of fragments.
+ *
+ * @param index Set to the index of the root of the subtree, or BSP_NONE if the list is empty.
+ * @return 0 on success, -1 on error.
+ */
+static int build_node(struct build_t *const build,
+                      const struct fragment_list_t *const list,
+                      const size_t depth,
+                      uint32_t *const index) {
+    *index = BSP_NONE;
+
+    if (list->count == 0) {
+        return 0;
+    }
+
+    const struct fragment_t splitter = list->items[choose_splitter(list)];
+    const struct vec_t origin = splitter.a;
+    const struct vec_t dir = vsub(splitter.b, splitter.a);
+    const float len = vlen(dir);
+    const size_t first = build->out.count;
+    struct fragment_list_t front = {0};
+    struct fragment_list_t back = {0};
+    int ret = 0;
+
+    for (size_t i = 0; i < list->count && ret == 0; i++) {
+        const struct fragment_t fragment = list->items[i];
+        const float sa = side(origin, dir, len, fragment.a);
+        const float sb = side(origin, dir, len, fragment.b);
+        const bool a_front = sa > BSP_EPSILON;
+        const bool a_back = sa < -BSP_EPSILON;
+        const bool b_front = sb > BSP_EPSILON;
+        const bool b_back = sb < -BSP_EPSILON;
+
+        if ((a_front && b_back) || (a_back && b_front)) {
+            /* both pieces share the parameter of the split point, so a ray through it cannot slip between them */
+            const float t = sa / (sa - sb);
+            const float split = fragment.lo + t * (fragment.hi - fragment.lo);
+            const struct vec_t mid = vlerp(fragment.a, fragment.b, t);
+            const struct fragment_t head = {fragment.a, mid, fragment.lo, split, fragment.wall, fragment.id};
+            const struct fragment_t tail = {mid, fragment.b, split, fragment.hi, fragment.wall, fragment.id};
+
+            ret = push_fragment(a_front ? &front : &back, head);
+            ret = ret == 0 ? push_fragment(a_front ? &back : &front, tail) : ret;
+            build->stats.splits++;
+        } else if (a_front || b_front) {
+            ret = push_fragment(&front, fragment);
+        } else if (a_back || b_back) {
+            ret = push_fragment(&back, fragment);
+        } else {
+            ret = push_fragment(&build->out, fragment);
+        }
+    }
+
+    uint32_t node = BSP_NONE;
+    ret = ret == 0 ? push_node(build, &node) : ret;
+
+    if (ret == 0) {
+        build->stats.depth = SDL_max(build->stats.depth, depth);
+        build->nodes[node] = (struct bsp_node_t) {
+                .origin = origin,
+                .dir = dir,
+                .front = BSP_NONE,
+                .back = BSP_NONE,
+                .first = (uint32_t) first,
+                .count = (uint32_t) (build->out.count - first)
+        };
+    }
+
+    uint32_t child = BSP_NONE;
+    ret = ret == 0 ? build_node(build, &front, depth + 1, &child) : ret;
+    free(front.items);
+
+    if (ret == 0) {
+        build->nodes[node].front = child;
+    }
+
+    ret = ret == 0 ? build_node(build, &back, depth + 1, &child) : ret;
+    free(back.items);
+
+    if (ret == 0) {
+        build->nodes[node].back = child;
+        *index = node;
+    }
+
+    return ret;
+}
+
+int bsp_build(struct bsp_t *const restrict bsp, const struct wall_table_t *const restrict walls) {
+    memset(bsp, 0, sizeof *bsp);
+
+    if (walls->count > INT_MAX) {
+        logger_printf(LOG_LEVEL_ERROR, "too many walls for a BSP tree: %zu\n", walls->count);
+        return -1;
+    }
+
+    struct build_t build = {0};
+    struct fragment_list_t walls_list = {0};
+    int ret = 0;
+
+    build.stats.walls = walls->count;
+
+    /* walls of zero length can never be hit and have no partition line */
+    for (size_t i = 0; i < walls->count && ret == 0; i++) {
+        const struct fragment_t fragment = {
+                .a = {walls->ax[i], walls->ay[i]},
+                .b = {walls->ax[i] + walls->ex[i], walls->ay[i] + walls->ey[i]},
+                .lo = 0.0F,
+                .hi = 1.0F,
+                .wall = walls->walls[i],
+                .id = (uint32_t) i
+        };
+
+        if (vdist(fragment.a, fragment.b) > BSP_EPSILON) {
+            ret = push_fragment(&walls_list, fragment);
+        }
+    }
+
+    uint32_t root;
+    ret = ret == 0 ? build_node(&build, &walls_list, 0, &root) : ret;
+    free(walls_list.items);
+
+    if (ret == 0 && build.out.count > INT_MAX) {
+        logger_printf(LOG_LEVEL_ERROR, "too many wall fragments for a BSP tree: %zu\n", build.out.count);
+        ret = -1;
+    }
+
+    if (ret == 0 && build.out.count > 0) {
+        bsp->ids = malloc(build.out.count * sizeof *bsp->ids);
+        bsp->lo = malloc(2 * build.out.count * sizeof *bsp->lo);
+        ret = bsp->ids == NULL || bsp->lo == NULL ? -1 : wall_table_alloc(&bsp->table, build.out.count);
+    }
+
+    if (ret != 0) {
+        free(bsp->ids);
+        free(bsp->lo);
+        bsp->ids = NULL;
+        bsp->lo = NULL;
+        free(build.nodes);
+        free(build.out.items);
+        return -1;
+    }
+
+    bsp->hi = bsp->lo + build.out.count;
+
+    for (size_t i = 0; i < build.out.count; i++) {
+        const struct fragment_t *const fragment = &build.out.items[i];
+
+        bsp->table.ax[i] = walls->ax[fragment->id];
+        bsp->table.ay[i] = walls->ay[fragment->id];
+        bsp->table.ex[i] = walls->ex[fragment->id];
+        bsp->table.ey[i] = walls->ey[fragment->id];
+        bsp->lo[i] = fragment->lo;
+        bsp->hi[i] = fragment->hi;
+        bsp->table.walls[i] = fragment->wall;
+        bsp->ids[i] = fragment->id;
+    }
+
+    bsp->nodes = build.nodes;
+    bsp->stats = build.stats;
+    bsp->stats.fragments = build.out.count;
+    free(build.out.items);
+
+    return 0;
+}
+
+void bsp_destroy(struct bsp_t *const bsp) {
+    wall_table_destroy(&bsp->table);
+    free(bsp->ids);
+    free(bsp->lo);
+    free(bsp->nodes);
+    memset(bsp, 0, sizeof *bsp);
+}
+
+/**
+ * @brief Intersects a ray with a fragment, in the same formulation as ray_cast() uses for its wall, so that a ray
+ *        hits the fragment at the same distance as the wall; the fragments of a wall partition it exactly.
+ * @return true if the ray hits the fragment nearer than @p dist, which is updated in this case, false otherwise.
+ */
+static bool cast_ray(const struct bsp_t *const restrict bsp,
+                     const size_t fragment,
+                     const struct vec_t pos,
+                     const struct vec_t dir,
+                     float *const restrict dist) {
+    const struct wall_table_t *const table = &bsp->table;
+    const float den = table->ex[fragment] * dir.y - table->ey[fragment] * dir.x;
+
+    if (isclose(den, 0.0F)) {
+        return false;
+    }
+
+    const float wx = table->ax[fragment] - pos.x;
+    const float wy = table->ay[fragment] - pos.y;
+    const float den_abs = fabsf(den);
+    const float tn_raw = wy * dir.x - wx * dir.y;
+    const float tn = signbit(den) ? -tn_raw : tn_raw;
+    const float u = (table->ex[fragment] * wy - table->ey[fragment] * wx) / den;
+
+    /* the end of a fragment is closed, so that a ray through a split point hits the piece before it */
+    if (tn > bsp->lo[fragment] * den_abs && !(tn > bsp->hi[fragment] * den_abs) && tn < den_abs && u > 0.0F &&
+        u < *dist) {
+        *dist = u;
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Tests a fragment against the rays within the angle it covers which have not hit anything yet.
+ */
+static void cast_fragment(struct view_t *const view, const size_t fragment) {
+    const struct bsp_t *const bsp = view->bsp;
+    const struct wall_table_t *const table = &bsp->table;
+    const struct hits_t *const hits = view->hits;
+    const struct vec_t pos = hits->pos;
+    const struct vec_t wall = {table->ax[fragment] - pos.x, table->ay[fragment] - pos.y};
+    const struct vec_t extent = {table->ex[fragment], table->ey[fragment]};
+    const struct vec_t a = vadd(wall, vmul(extent, bsp->lo[fragment]));
+    const struct vec_t b = vadd(wall, vmul(extent, bsp->hi[fragment]));
+    const float cross = a.x * b.y - a.y * b.x;
+
+    view->visited++;
+
+    /* the fragment is seen edge-on */
+    if (isclose(cross, 0.0F)) {
+        return;
+    }
+
+    const struct vec_t start = cross > 0.0F ? a : b;
+    const float arc = atan2f(fabsf(cross), a.x * b.x + a.y * b.y);
+    float offset = fmodf(atan2f(start.y, start.x) - view->angle, 2.0F * PI);
+
+    if (offset < 0.0F) {
+        offset += 2.0F * PI;
+    }
+
+    /* widen the range by a ray on each side; the exact test below rejects the rays which miss */
+    const size_t first = (size_t) floorf(offset / view->step);
+    const size_t last = (size_t) ceilf((offset + arc) / view->step) + 1;
+
+    for (size_t k = first == 0 ? 0 : first - 1; k <= last; k++) {
+        const size_t i = k % view->period;
+
+        if (i >= hits->count || hits->wall[i] != HITS_NONE) {
+            continue;
+        }
+
+        float dist = INFINITY;
+        hits->tested[i]++;
+
+        if (cast_ray(bsp, fragment, pos, hits->dir[i], &dist)) {
+            hits->dist[i] = dist;
+            hits->wall[i] = bsp->ids[fragment];
+            view->covered++;
+        }
+    }
+}
+
+/**
+ * @brief Visits the fragments of a subtree front to back.
+ * @return true if every ray has hit a fragment, false otherwise.
+ */
+static bool visit(struct view_t *const view, const uint32_t index) {
+    const struct bsp_node_t *const node = &view->bsp->nodes[index];
+    const bool in_front = side(node->origin, node->dir, 1.0F, view->hits->pos) >= 0.0F;
+    const uint32_t near = in_front ? node->front : node->back;
+    const uint32_t far = in_front ? node->back : node->front;
+
+    if (near != BSP_NONE && visit(view, near)) {
+        return true;
+    }
+
+    for (size_t i = node->first; i < node->first + node->count; i++) {
+        cast_fragment(view, i);
+
+        if (view->covered == view->hits->count) {
+            return true;
+        }
+    }
+
+    return far != BSP_NONE && visit(view, far);
+}
+
+size_t bsp_cast_rays(const struct bsp_t *const restrict bsp,
+                     const struct hits_t *const restrict hits,
+                     const float angle,
+                     const float step) {
+    struct view_t view = {
+            .bsp = bsp,
+            .hits = hits,
+            .angle = angle,
+            .step = step,
+            .period = (size_t) lroundf(2.0F * PI / step)
+    };
+
+    hits_clear(hits);
+
+    if (hits->count > 0 && bsp->nodes != NULL) {
+        visit(&view, 0);
+    }
+
+    return view.visited;
+}
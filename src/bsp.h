@@ -0,0 +1,100 @@
+#ifndef RAY_BSP_H
+#define RAY_BSP_H
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hits.h"
+#include "ray.h"
+#include "vector.h"
+
+
+/**
+ * @brief Index of a missing child of a BSP node.
+ */
+#define BSP_NONE UINT32_MAX
+
+
+/**
+ * @brief A node of a binary space partitioning tree.
+ *
+ * The partition line passes through @p origin in the direction @p dir. Points to the left of the line
+ * (positive cross product with @p dir) are in front of it, the other points are behind it.
+ */
+struct bsp_node_t {
+    struct vec_t origin; /**< A point on the partition line. */
+    struct vec_t dir; /**< The direction of the partition line. */
+    uint32_t front; /**< The index of the subtree in front of the line, or BSP_NONE. */
+    uint32_t back; /**< The index of the subtree behind the line, or BSP_NONE. */
+    uint32_t first; /**< The first table entry of the wall fragments lying on the line. */
+    uint32_t count; /**< The number of wall fragments lying on the line. */
+};
+
+/**
+ * @brief Statistics collected while building a BSP tree, used to compare the quality of trees.
+ */
+struct bsp_stats_t {
+    size_t walls; /**< The number of walls the tree was built from. */
+    size_t fragments; /**< The number of wall fragments in the tree. */
+    size_t splits; /**< The number of times a fragment was split by a partition line. */
+    size_t nodes; /**< The number of nodes. */
+    size_t depth; /**< The depth of the deepest node; the root has depth 0. */
+};
+
+/**
+ * @brief A binary space partitioning tree over the walls in the world.
+ *
+ * Walls crossing a partition line are split into fragments. The fragments are stored in a wall table
+ * in the order of the nodes; every entry holds the whole wall the fragment was cut from, and the fragment is the
+ * part of it between the parameters @p lo and @p hi (0 at the first endpoint of the wall, 1 at the second). Rays
+ * are intersected with the line of the wall itself, so they hit fragments exactly where they hit the wall.
+ */
+struct bsp_t {
+    struct bsp_node_t *nodes; /**< The nodes; nodes[0] is the root. */
+    struct wall_table_t table; /**< The wall fragments of all nodes. */
+    uint32_t *ids; /**< For every table entry, the index of the wall in the table the tree was built from. */
+    float *lo; /**< For every table entry, the parameter along its wall at which the fragment starts. */
+    float *hi; /**< For every table entry, the parameter along its wall at which the fragment ends (shares the
+                    allocation of @p lo). */
+    struct bsp_stats_t stats; /**< Statistics of the build. */
+};
+
+
+/**
+ * @brief Builds a BSP tree over the given walls.
+ *
+ * The partition line of every node is chosen among up to BSP_CANDIDATES of its walls, minimizing the
+ * number of split walls (weighted by BSP_SPLIT_COST) plus the imbalance between the two subtrees.
+ *
+ * @param bsp The tree to build.
+ * @param walls The walls to partition.
+ * @return 0 on success, -1 on error (the tree is empty in this case).
+ */
+int bsp_build(struct bsp_t *bsp, const struct wall_table_t *walls);
+
+/**
+ * @brief Frees the memory owned by a BSP tree.
+ * @param bsp The tree to destroy.
+ */
+void bsp_destroy(struct bsp_t *bsp);
+
+/**
+ * @brief Casts a fan of rays from a common origin by visiting the wall fragments front to back.
+ *
+ * Each fragment is only tested against the rays within the angle it covers that have not hit a nearer
+ * fragment yet. Since fragments are visited front to back, the first hit of a ray is its nearest hit.
+ * The traversal stops as soon as every ray has hit a fragment.
+ *
+ * @param bsp The tree.
+ * @param hits The rays. The direction of ray i must be at the angle @p angle + i * @p step (in radians). The hits
+ *             and the numbers of tested walls are overwritten; the hit parameters are not computed. The rays must
+ *             not span more than a full turn.
+ * @param angle The angle of the first ray.
+ * @param step The angle between two neighbouring rays. Must be positive.
+ * @return The number of fragments visited.
+ */
+size_t bsp_cast_rays(const struct bsp_t *bsp, const struct hits_t *hits, float angle, float step);
+
+
+#endif //RAY_BSP_H
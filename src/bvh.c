@@ -0,0 +1,634 @@
+#include <float.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "conf.h"
+#include "logger.h"
+#include "math.h"
+
+#include "bvh.h"
+
+
+/**
+ * Maximum depth of a BVH. Nodes at this depth become leaves regardless of their size.
+ */
+#define BVH_DEPTH_MAX 64
+
+/**
+ * Cost of visiting a node, relative to the cost of testing a wall.
+ */
+#define BVH_TRAVERSAL_COST 1.0F
+
+/**
+ * Number of walls whose bounds are computed by a single call of the worker function.
+ */
+#define BVH_BOUNDS_TILE_SIZE 1024
+
+/**
+ * Number of subtrees built in parallel per worker thread.
+ */
+#define BVH_TASKS_PER_THREAD 4
+
+
+/**
+ * @brief A node of the BVH while it is being built.
+ */
+struct build_node_t {
+    struct vec_t min; /**< The lower corner of the bounding box of the node. */
+    struct vec_t max; /**< The upper corner of the bounding box of the node. */
+    uint32_t left; /**< The index of the left child, or 0 for a leaf. */
+    uint32_t right; /**< The index of the right child, or 0 for a leaf. */
+    uint32_t begin; /**< The first wall reference of the node. */
+    uint32_t end; /**< One past the last wall reference of the node. */
+};
+
+/**
+ * @brief A subtree of the BVH built by a single worker.
+ */
+struct build_task_t {
+    uint32_t node; /**< The index of the root of the subtree. */
+    uint32_t next; /**< The first of the node slots reserved for the subtree. */
+    size_t depth; /**< The depth of the root of the subtree. */
+    size_t max_depth; /**< The depth of the deepest leaf of the subtree. */
+};
+
+/**
+ * @brief The state shared by all stages of a BVH build.
+ */
+struct build_t {
+    const struct wall_table_t *walls; /**< The walls to index. */
+    struct vec_t *bounds; /**< The lower and upper corners of the bounding box of every wall, interleaved. */
+    struct vec_t *centroids; /**< The center of the bounding box of every wall. */
+    uint32_t *refs; /**< The wall references, partitioned in place while the nodes are split. */
+    struct build_node_t *nodes; /**< The nodes. */
+    struct build_task_t *tasks; /**< The subtrees left to the worker pool. */
+    size_t ntasks; /**< The number of subtrees. */
+    size_t task_size; /**< Nodes with at most this many walls are built as a single subtree. */
+    uint32_t next; /**< The index of the next free node slot. */
+};
+
+/**
+ * @brief A bin of wall centroids used to evaluate the split candidates of a node.
+ */
+struct bin_t {
+    struct vec_t min; /**< The lower corner of the bounding box of the walls in the bin. */
+    struct vec_t max; /**< The upper corner of the bounding box of the walls in the bin. */
+    size_t count; /**< The number of walls in the bin. */
+};
+
+
+static inline float axis_value(const struct vec_t vec, const size_t axis) {
+    return axis == 0 ? vec.x : vec.y;
+}
+
+static inline float half_perimeter(const struct vec_t min, const struct vec_t max) {
+    return (max.x - min.x) + (max.y - min.y);
+}
+
+static inline void grow(struct vec_t *const restrict min,
+                        struct vec_t *const restrict max,
+                        const struct vec_t other_min,
+                        const struct vec_t other_max) {
+    min->x = fminf(min->x, other_min.x);
+    min->y = fminf(min->y, other_min.y);
+    max->x = fmaxf(max->x, other_max.x);
+    max->y = fmaxf(max->y, other_max.y);
+}
+
+static inline size_t bin_index(const float centroid, const float min, const float scale) {
+    const size_t bin = (size_t) ((centroid - min) * scale);
+
+    return SDL_min(bin, BVH_BINS - 1);
+}
+
+static void compute_bounds(const void *const arg, const size_t begin, const size_t end) {
+    const struct build_t *const build = arg;
+    const struct wall_table_t *const walls = build->walls;
+
+    for (size_t i = begin; i < end; i++) {
+        const struct vec_t a = {walls->ax[i], walls->ay[i]};
+        const struct vec_t b = vadd(a, (struct vec_t) {walls->ex[i], walls->ey[i]});
+        const struct vec_t min = {fminf(a.x, b.x), fminf(a.y, b.y)};
+        const struct vec_t max = {fmaxf(a.x, b.x), fmaxf(a.y, b.y)};
+
+        build->bounds[2 * i] = min;
+        build->bounds[2 * i + 1] = max;
+        build->centroids[i] = vmul(vadd(min, max), 0.5F);
+        build->refs[i] = (uint32_t) i;
+    }
+}
+
+/**
+ * @brief Sets the bounding box of a node to the union of the bounding boxes of its walls.
+ */
+static void init_node(const struct build_t *const build,
+                      struct build_node_t *const node,
+                      const size_t begin,
+                      const size_t end) {
+    node->min = (struct vec_t) {INFINITY, INFINITY};
+    node->max = (struct vec_t) {-INFINITY, -INFINITY};
+    node->left = 0;
+    node->right = 0;
+    node->begin = (uint32_t) begin;
+    node->end = (uint32_t) end;
+
+    for (size_t i = begin; i < end; i++) {
+        const uint32_t ref = build->refs[i];
+
+        grow(&node->min, &node->max, build->bounds[2 * ref], build->bounds[2 * ref + 1]);
+    }
+}
+
+/**
+ * @brief Chooses the split of a node with the lowest surface area heuristic cost and partitions its walls.
+ *
+ * @param mid Set to the first wall reference of the right child.
+ * @return true if the node was split, false if it should become a leaf.
+ */
+static bool split_node(const struct build_t *const build,
+                       const struct build_node_t *const node,
+                       const size_t depth,
+                       size_t *const mid) {
+    const size_t begin = node->begin;
+    const size_t end = node->end;
+    const size_t count = end - begin;
+
+    if (count <= 1 || depth + 1 >= BVH_DEPTH_MAX) {
+        return false;
+    }
+
+    struct vec_t cmin = {INFINITY, INFINITY};
+    struct vec_t cmax = {-INFINITY, -INFINITY};
+
+    for (size_t i = begin; i < end; i++) {
+        const struct vec_t centroid = build->centroids[build->refs[i]];
+
+        grow(&cmin, &cmax, centroid, centroid);
+    }
+
+    float best_cost = INFINITY;
+    size_t best_axis = 0;
+    size_t best_bin = 0;
+
+    for (size_t axis = 0; axis < 2; axis++) {
+        const float extent = axis_value(cmax, axis) - axis_value(cmin, axis);
+
+        if (extent <= 0.0F) {
+            continue;
+        }
+
+        const float scale = (float) BVH_BINS / extent;
+        struct bin_t bins[BVH_BINS];
+
+        for (size_t k = 0; k < BVH_BINS; k++) {
+            bins[k] = (struct bin_t) {{INFINITY, INFINITY}, {-INFINITY, -INFINITY}, 0};
+        }
+
+        for (size_t i = begin; i < end; i++) {
+            const uint32_t ref = build->refs[i];
+            struct bin_t *const bin = &bins[bin_index(axis_value(build->centroids[ref], axis),
+                                                      axis_value(cmin, axis), scale)];
+
+            grow(&bin->min, &bin->max, build->bounds[2 * ref], build->bounds[2 * ref + 1]);
+            bin->count++;
+        }
+
+        /* right_cost[k] is the cost of a right child made of the bins [k, BVH_BINS) */
+        float right_cost[BVH_BINS];
+        struct bin_t acc = {{INFINITY, INFINITY}, {-INFINITY, -INFINITY}, 0};
+
+        for (size_t k = BVH_BINS - 1; k > 0; k--) {
+            grow(&acc.min, &acc.max, bins[k].min, bins[k].max);
+            acc.count += bins[k].count;
+            right_cost[k] = acc.count == 0 ? INFINITY : (float) acc.count * half_perimeter(acc.min, acc.max);
+        }
+
+        acc = (struct bin_t) {{INFINITY, INFINITY}, {-INFINITY, -INFINITY}, 0};
+
+        for (size_t k = 0; k + 1 < BVH_BINS; k++) {
+            grow(&acc.min, &acc.max, bins[k].min, bins[k].max);
+            acc.count += bins[k].count;
+
+            if (acc.count == 0) {
+                continue;
+            }
+
+            const float cost = (float) acc.count * half_perimeter(acc.min, acc.max) + right_cost[k + 1];
+
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_axis = axis;
+                best_bin = k;
+            }
+        }
+    }
+
+    if (isinf(best_cost)) {
+        /* all centroids coincide; split the references in the middle if the node is too large for a leaf */
+        if (count <= BVH_LEAF_SIZE) {
+            return false;
+        }
+
+        *mid = begin + count / 2;
+        return true;
+    }
+
+    const float perimeter = half_perimeter(node->min, node->max);
+    const float split_cost = BVH_TRAVERSAL_COST + best_cost / perimeter;
+
+    if (count <= BVH_LEAF_SIZE && split_cost >= (float) count) {
+        return false;
+    }
+
+    const float min = axis_value(cmin, best_axis);
+    const float scale = (float) BVH_BINS / (axis_value(cmax, best_axis) - min);
+    size_t i = begin;
+    size_t j = end;
+
+    while (i < j) {
+        const uint32_t ref = build->refs[i];
+
+        if (bin_index(axis_value(build->centroids[ref], best_axis), min, scale) <= best_bin) {
+            i++;
+        } else {
+            build->refs[i] = build->refs[--j];
+            build->refs[j] = ref;
+        }
+    }
+
+    *mid = i;
+    return true;
+}
+
+/**
+ * @brief Recursively builds the subtree below a node, taking node slots from @p next.
+ */
+static void build_subtree(const struct build_t *const build,
+                          const uint32_t index,
+                          const size_t depth,
+                          uint32_t *const next,
+                          size_t *const max_depth) {
+    struct build_node_t *const node = &build->nodes[index];
+    size_t mid;
+
+    if (!split_node(build, node, depth, &mid)) {
+        *max_depth = SDL_max(*max_depth, depth);
+        return;
+    }
+
+    node->left = (*next)++;
+    node->right = (*next)++;
+    init_node(build, &build->nodes[node->left], node->begin, mid);
+    init_node(build, &build->nodes[node->right], mid, node->end);
+    build_subtree(build, node->left, depth + 1, next, max_depth);
+    build_subtree(build, node->right, depth + 1, next, max_depth);
+}
+
+static void run_tasks(const void *const arg, const size_t begin, const size_t end) {
+    const struct build_t *const build = arg;
+
+    for (size_t i = begin; i < end; i++) {
+        struct build_task_t *const task = &build->tasks[i];
+
+        build_subtree(build, task->node, task->depth, &task->next, &task->max_depth);
+    }
+}
+
+/**
+ * @brief Splits the upper levels of the tree and collects the subtrees small enough for a single worker.
+ */
+static void build_top(struct build_t *const build, const uint32_t index, const size_t depth) {
+    struct build_node_t *const node = &build->nodes[index];
+    const size_t count = node->end - node->begin;
+    size_t mid;
+
+    if (count <= build->task_size || !split_node(build, node, depth, &mid)) {
+        /* a subtree over n walls has at most 2n - 1 nodes, including its root */
+        build->tasks[build->ntasks++] = (struct build_task_t) {
+                .node = index,
+                .next = build->next,
+                .depth = depth,
+                .max_depth = depth
+        };
+        build->next += (uint32_t) (2 * count - 2);
+        return;
+    }
+
+    node->left = build->next++;
+    node->right = build->next++;
+    init_node(build, &build->nodes[node->left], node->begin, mid);
+    init_node(build, &build->nodes[node->right], mid, node->end);
+    build_top(build, node->left, depth + 1);
+    build_top(build, node->right, depth + 1);
+}
+
+/**
+ * @brief Copies the subtree below a build node to the BVH in depth-first order.
+ */
+static void flatten(struct bvh_t *const restrict bvh,
+                    const struct build_node_t *const restrict nodes,
+                    const uint32_t index) {
+    const struct build_node_t *const node = &nodes[index];
+    struct bvh_node_t *const out = &bvh->nodes[bvh->nnodes++];
+
+    out->min = node->min;
+    out->max = node->max;
+
+    if (node->left == 0) {
+        out->offset = node->begin;
+        out->count = node->end - node->begin;
+        bvh->nleaves++;
+        return;
+    }
+
+    out->count = 0;
+    flatten(bvh, nodes, node->left);
+    out->offset = (uint32_t) bvh->nnodes;
+    flatten(bvh, nodes, node->right);
+}
+
+static void build_destroy(struct build_t *const build) {
+    free(build->bounds);
+    free(build->centroids);
+    free(build->nodes);
+    free(build->tasks);
+}
+
+int bvh_build(struct bvh_t *const restrict bvh,
+              const struct wall_table_t *const restrict walls,
+              struct pool_t *const restrict pool) {
+    memset(bvh, 0, sizeof *bvh);
+
+    const size_t count = walls->count;
+
+    if (count == 0) {
+        return 0;
+    }
+
+    if (count > INT_MAX) {
+        logger_printf(LOG_LEVEL_ERROR, "too many walls for a BVH: %zu\n", count);
+        return -1;
+    }
+
+    const size_t nthreads = pool == NULL ? 1 : pool->nthreads;
+    struct build_t build = {
+            .walls = walls,
+            .bounds = malloc(2 * count * sizeof *build.bounds),
+            .centroids = malloc(count * sizeof *build.centroids),
+            .refs = malloc(count * sizeof *build.refs),
+            .nodes = malloc((2 * count - 1) * sizeof *build.nodes),
+            .tasks = malloc(count * sizeof *build.tasks),
+            .task_size = nthreads <= 1 ? count : SDL_max(count / (nthreads * BVH_TASKS_PER_THREAD), 1),
+            .next = 1
+    };
+
+    /* the references end up in the order of the leaves and are kept as the ids of the table entries */
+    bvh->ids = build.refs;
+
+    if (build.bounds == NULL || build.centroids == NULL || build.refs == NULL || build.nodes == NULL ||
+        build.tasks == NULL || wall_table_alloc(&bvh->table, count) != 0) {
+        logger_perror("malloc");
+        build_destroy(&build);
+        bvh_destroy(bvh);
+        return -1;
+    }
+
+    if (pool == NULL) {
+        compute_bounds(&build, 0, count);
+    } else {
+        pool_run(pool, count, BVH_BOUNDS_TILE_SIZE, compute_bounds, &build);
+    }
+
+    init_node(&build, &build.nodes[0], 0, count);
+    build_top(&build, 0, 0);
+
+    if (pool == NULL) {
+        run_tasks(&build, 0, build.ntasks);
+    } else {
+        pool_run(pool, build.ntasks, 1, run_tasks, &build);
+    }
+
+    for (size_t i = 0; i < build.ntasks; i++) {
+        bvh->depth = SDL_max(bvh->depth, build.tasks[i].max_depth);
+    }
+
+    bvh->nodes = malloc(build.next * sizeof *bvh->nodes);
+
+    if (bvh->nodes == NULL) {
+        logger_perror("malloc");
+        build_destroy(&build);
+        bvh_destroy(bvh);
+        return -1;
+    }
+
+    flatten(bvh, build.nodes, 0);
+    build_destroy(&build);
+
+    for (size_t i = 0; i < count; i++) {
+        wall_table_set(&bvh->table, i, walls->walls[bvh->ids[i]]);
+    }
+
+    return 0;
+}
+
+int bvh_restore(struct bvh_t *const restrict bvh,
+                const struct wall_table_t *const restrict walls,
+                const struct bvh_node_t *const restrict nodes,
+                const size_t nnodes,
+                const uint32_t *const restrict ids) {
+    memset(bvh, 0, sizeof *bvh);
+
+    const size_t count = walls->count;
+
+    if (nnodes == 0 || count == 0) {
+        return nnodes == count ? 0 : -1;
+    }
+
+    /* one more than the depth of every node, or 0 for a node without a parent yet; as the nodes come from outside,
+     * they must form a tree, so that the traversal stack cannot overflow */
+    size_t *const depths = calloc(nnodes, sizeof *depths);
+
+    bvh->nodes = malloc(nnodes * sizeof *bvh->nodes);
+    bvh->ids = malloc(count * sizeof *bvh->ids);
+
+    if (depths == NULL || bvh->nodes == NULL || bvh->ids == NULL || wall_table_alloc(&bvh->table, count) != 0) {
+        logger_perror("malloc");
+        free(depths);
+        bvh_destroy(bvh);
+        return -1;
+    }
+
+    memcpy(bvh->nodes, nodes, nnodes * sizeof *bvh->nodes);
+    memcpy(bvh->ids, ids, count * sizeof *bvh->ids);
+    bvh->nnodes = nnodes;
+    depths[0] = 1;
+
+    /* the leaves cover the table entries in order, every entry exactly once */
+    size_t covered = 0;
+
+    for (size_t i = 0; i < nnodes; i++) {
+        const struct bvh_node_t *const node = &bvh->nodes[i];
+        bool valid = depths[i] > 0;
+
+        if (valid && node->count == 0) {
+            /* the left child directly follows its parent, the right child follows the left subtree */
+            valid = node->offset > i + 1 && node->offset < nnodes && depths[i] < BVH_DEPTH_MAX &&
+                    depths[i + 1] == 0 && depths[node->offset] == 0;
+
+            if (valid) {
+                depths[i + 1] = depths[node->offset] = depths[i] + 1;
+            }
+        } else if (valid) {
+            valid = node->offset == covered && node->count <= count - covered;
+            covered += valid ? node->count : 0;
+            bvh->nleaves++;
+            bvh->depth = SDL_max(bvh->depth, depths[i] - 1);
+        }
+
+        if (!valid) {
+            logger_printf(LOG_LEVEL_ERROR, "invalid BVH node: %zu\n", i);
+            free(depths);
+            bvh_destroy(bvh);
+            return -1;
+        }
+    }
+
+    if (covered != count) {
+        logger_printf(LOG_LEVEL_ERROR, "invalid BVH: %zu of %zu walls in leaves\n", covered, count);
+        free(depths);
+        bvh_destroy(bvh);
+        return -1;
+    }
+
+    free(depths);
+
+    for (size_t i = 0; i < count; i++) {
+        if (bvh->ids[i] >= count) {
+            logger_printf(LOG_LEVEL_ERROR, "invalid BVH wall: %" PRIu32 "\n", bvh->ids[i]);
+            bvh_destroy(bvh);
+            return -1;
+        }
+
+        wall_table_set(&bvh->table, i, walls->walls[bvh->ids[i]]);
+    }
+
+    return 0;
+}
+
+void bvh_destroy(struct bvh_t *const bvh) {
+    wall_table_destroy(&bvh->table);
+    free(bvh->nodes);
+    free(bvh->ids);
+    memset(bvh, 0, sizeof *bvh);
+}
+
+/**
+ * @brief Computes the ray parameter at which a ray enters the bounding box of a node.
+ * @return The entry parameter (0 if the ray starts inside the box), or INFINITY if the ray misses the box
+ *         before reaching @p dist.
+ */
+static inline float node_entry(const struct bvh_node_t *const node,
+                               const struct vec_t pos,
+                               const struct vec_t inv,
+                               const float dist) {
+    const float tx0 = (node->min.x - pos.x) * inv.x;
+    const float tx1 = (node->max.x - pos.x) * inv.x;
+    const float ty0 = (node->min.y - pos.y) * inv.y;
+    const float ty1 = (node->max.y - pos.y) * inv.y;
+    const float t_enter = fmaxf(fmaxf(fminf(tx0, tx1), fminf(ty0, ty1)), 0.0F);
+    const float t_exit = fminf(fmaxf(tx0, tx1), fmaxf(ty0, ty1));
+
+    return t_enter <= t_exit && t_enter < dist ? t_enter : INFINITY;
+}
+
+static inline float safe_inverse(const float value) {
+    /* avoid infinities, so that a zero distance to a slab never turns into NaN */
+    return fabsf(value) > 1.0F / FLT_MAX ? 1.0F / value : copysignf(FLT_MAX, value);
+}
+
+size_t bvh_cast(const struct bvh_t *const restrict bvh,
+                const struct vec_t pos,
+                const struct vec_t dir,
+                float *const restrict dist,
+                size_t *const restrict tested) {
+    struct {
+        uint32_t node;
+        float entry;
+    } stack[BVH_DEPTH_MAX];
+    size_t top = 0;
+    size_t hit = RAY_NO_HIT;
+
+    if (bvh->nnodes == 0) {
+        return RAY_NO_HIT;
+    }
+
+    const struct vec_t inv = {safe_inverse(dir.x), safe_inverse(dir.y)};
+    const float root_entry = node_entry(&bvh->nodes[0], pos, inv, *dist);
+
+    if (root_entry < *dist) {
+        stack[top].node = 0;
+        stack[top++].entry = root_entry;
+    }
+
+    while (top > 0) {
+        top--;
+
+        /* the node is entered behind the nearest hit found since it was pushed */
+        if (stack[top].entry >= *dist) {
+            continue;
+        }
+
+        uint32_t index = stack[top].node;
+
+        for (;;) {
+            const struct bvh_node_t *const node = &bvh->nodes[index];
+
+            if (node->count > 0) {
+                const size_t leaf_hit = ray_cast(&bvh->table, node->offset, node->offset + node->count,
+                                                 pos, dir, dist);
+
+                if (tested != NULL) {
+                    *tested += node->count;
+                }
+
+                if (leaf_hit != RAY_NO_HIT) {
+                    hit = bvh->ids[leaf_hit];
+                }
+
+                break;
+            }
+
+            uint32_t near = index + 1;
+            uint32_t far = node->offset;
+            float near_entry = node_entry(&bvh->nodes[near], pos, inv, *dist);
+            float far_entry = node_entry(&bvh->nodes[far], pos, inv, *dist);
+
+            if (far_entry < near_entry) {
+                const uint32_t tmp = near;
+                near = far;
+                far = tmp;
+
+                const float tmp_entry = near_entry;
+                near_entry = far_entry;
+                far_entry = tmp_entry;
+            }
+
+            if (isinf(near_entry)) {
+                break;
+            }
+
+            if (!isinf(far_entry)) {
+                stack[top].node = far;
+                stack[top++].entry = far_entry;
+            }
+
+            index = near;
+        }
+    }
+
+    return hit;
+}
@@ -0,0 +1,92 @@
+#ifndef RAY_BVH_H
+#define RAY_BVH_H
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pool.h"
+#include "ray.h"
+#include "vector.h"
+
+
+/**
+ * @brief A node of a flattened bounding volume hierarchy.
+ *
+ * The left child of an interior node directly follows the node in the node array; the index of the right
+ * child is stored in the node.
+ */
+struct bvh_node_t {
+    struct vec_t min; /**< The lower corner of the bounding box of the node. */
+    struct vec_t max; /**< The upper corner of the bounding box of the node. */
+    uint32_t offset; /**< The index of the right child (interior node), or of the first table entry (leaf). */
+    uint32_t count; /**< The number of walls in the leaf, or 0 for an interior node. */
+};
+
+/**
+ * @brief A bounding volume hierarchy over the walls in the world, used to find the walls near a ray.
+ *
+ * The walls are stored in a wall table in the order of the leaves, so that the walls of a leaf can be
+ * tested with a single call to ray_cast().
+ */
+struct bvh_t {
+    struct bvh_node_t *nodes; /**< The nodes in depth-first order; nodes[0] is the root. */
+    size_t nnodes; /**< The number of nodes. */
+    size_t nleaves; /**< The number of leaves. */
+    size_t depth; /**< The depth of the deepest leaf; the root has depth 0. */
+    uint32_t *ids; /**< For every table entry, the index of the wall in the table the BVH was built from. */
+    struct wall_table_t table; /**< The walls of all leaves. */
+};
+
+
+/**
+ * @brief Builds a bounding volume hierarchy over the given walls.
+ *
+ * Nodes are split with a binned surface area heuristic, using the perimeter of the bounding boxes. The
+ * upper levels are split on the calling thread; the subtrees below them are built by the worker pool.
+ *
+ * @param bvh The BVH to build.
+ * @param walls The walls to index.
+ * @param pool The worker pool used to build the subtrees, or NULL to build the BVH on the calling thread.
+ * @return 0 on success, -1 on error (the BVH is empty in this case).
+ */
+int bvh_build(struct bvh_t *bvh, const struct wall_table_t *walls, struct pool_t *pool);
+
+/**
+ * @brief Restores a BVH over the given walls from its nodes and wall ids, as saved from a BVH built by
+ *        bvh_build() over the same walls. The nodes are checked, so that a damaged copy cannot lead to
+ *        accesses out of bounds.
+ *
+ * @param bvh The BVH to restore.
+ * @param walls The walls to index.
+ * @param nodes The nodes of the BVH, which are copied.
+ * @param nnodes The number of nodes.
+ * @param ids The ids of the table entries of the BVH, one for every wall, which are copied.
+ * @return 0 on success, -1 on error (the BVH is empty in this case).
+ */
+int bvh_restore(struct bvh_t *bvh, const struct wall_table_t *walls, const struct bvh_node_t *nodes, size_t nnodes,
+                const uint32_t *ids);
+
+/**
+ * @brief Frees the memory owned by a BVH.
+ * @param bvh The BVH to destroy.
+ */
+void bvh_destroy(struct bvh_t *bvh);
+
+/**
+ * @brief Finds the nearest wall hit by a ray by traversing the BVH, visiting the nearer child first.
+ *
+ * Nodes whose bounding box is entered behind the nearest hit found so far are skipped.
+ *
+ * @param bvh The BVH.
+ * @param pos The origin of the ray.
+ * @param dir The direction of the ray. Must be a unit vector.
+ * @param dist A pointer to the distance to the nearest hit found so far, or INFINITY. Updated if a nearer
+ *             hit is found.
+ * @param tested If not NULL, incremented by the number of walls tested.
+ * @return The index of the nearest wall hit by the ray in the table the BVH was built from, or RAY_NO_HIT.
+ */
+size_t bvh_cast(const struct bvh_t *bvh, struct vec_t pos, struct vec_t dir, float *dist, size_t *tested);
+
+
+#endif //RAY_BVH_H
@@ -0,0 +1,118 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "conf.h"
+#include "framebuffer.h"
+#include "logger.h"
+#include "util.h"
+
+#include "colormap.h"
+
+
+/**
+ * Squared distance within which a wall is lit with its full color; farther walls fade with the squared distance.
+ */
+#define COLORMAP_FALLOFF 100000.0F
+
+
+static inline bool same_color(const SDL_Color a, const SDL_Color b) {
+    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+/**
+ * @brief Finds the distinct colors of the walls and stores the index of its color in every wall.
+ * @return The number of distinct colors.
+ */
+static size_t collect_colors(SDL_Color *const restrict colors, struct world_t *const restrict world) {
+    size_t ncolors = 0;
+
+    for (size_t i = 0; i < world->nwalls; i++) {
+        struct wall_t *const wall = &world->walls[i];
+        size_t c = 0;
+
+        for (; c < ncolors && !same_color(colors[c], wall->color); c++) {}
+
+        if (c == ncolors) {
+            colors[ncolors++] = wall->color;
+        }
+
+        /* only store changed indexes, so that the walls of a mapped world keep sharing the pages of the file */
+        if (wall->shade != c) {
+            wall->shade = (unsigned int) c;
+        }
+    }
+
+    return ncolors;
+}
+
+int colormap_build(struct colormap_t *const restrict colormap, struct world_t *const restrict world,
+                   const float lightmult) {
+    memset(colormap, 0, sizeof *colormap);
+
+    colormap->colors = malloc(SDL_max(world->nwalls, 1) * sizeof *colormap->colors);
+
+    if (colormap->colors == NULL) {
+        logger_perror("malloc");
+        return -1;
+    }
+
+    colormap->ncolors = collect_colors(colormap->colors, world);
+    colormap->shades = malloc(SDL_max(COLORMAP_LEVELS * colormap->ncolors, 1) * sizeof *colormap->shades);
+
+    if (colormap->shades == NULL) {
+        logger_perror("malloc");
+        colormap_destroy(colormap);
+        return -1;
+    }
+
+    colormap_set_light(colormap, lightmult);
+    return 0;
+}
+
+void colormap_destroy(struct colormap_t *const colormap) {
+    free(colormap->colors);
+    free(colormap->shades);
+    memset(colormap, 0, sizeof *colormap);
+}
+
+void colormap_set_light(struct colormap_t *const colormap, const float lightmult) {
+    for (size_t level = 0; level < COLORMAP_LEVELS; level++) {
+        const float brightness = lightmult * (float) level / (float) (COLORMAP_LEVELS - 1);
+        Uint32 *const shades = &colormap->shades[level * colormap->ncolors];
+
+        for (size_t c = 0; c < colormap->ncolors; c++) {
+            shades[c] = framebuffer_color(change_brightness(colormap->colors[c], brightness));
+        }
+    }
+}
+
+/**
+ * @brief Computes the light level of a wall at a distance, rounded to the nearest level. Nearer walls, even at
+ *        distance 0, get the last level.
+ */
+static inline uint32_t get_level(const float dist) {
+    const float level = COLORMAP_FALLOFF * (float) (COLORMAP_LEVELS - 1) / (dist * dist) + 0.5F;
+
+    return (uint32_t) fminf(level, (float) (COLORMAP_LEVELS - 1));
+}
+
+void colormap_levels(const float *const restrict dist, uint32_t *const restrict levels, const size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        levels[i] = get_level(dist[i]);
+    }
+}
+
+Uint32 colormap_shade(const struct colormap_t *const restrict colormap, const struct wall_t *const restrict wall,
+                      const float dist) {
+    return colormap->shades[get_level(dist) * colormap->ncolors + wall->shade];
+}
+
+SDL_Color colormap_color(const Uint32 shade) {
+    return (SDL_Color) {
+            .r = (Uint8) (shade >> 16),
+            .g = (Uint8) (shade >> 8),
+            .b = (Uint8) shade,
+            .a = (Uint8) (shade >> 24)
+    };
+}
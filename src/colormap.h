@@ -0,0 +1,79 @@
+#ifndef RAY_COLORMAP_H
+#define RAY_COLORMAP_H
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <SDL2/SDL.h>
+
+#include "world.h"
+
+
+/**
+ * @brief Precomputed shades of the colors of the walls at COLORMAP_LEVELS light levels.
+ *
+ * The light levels quantize the distance falloff, from black at level 0 to full brightness at the last level.
+ * The shades include the light multiplier of the camera, so they are rebuilt whenever it changes.
+ */
+struct colormap_t {
+    SDL_Color *colors; /**< The distinct colors of the walls. */
+    Uint32 *shades; /**< The shade of color c at level l, as an ARGB8888 pixel, at shades[l * ncolors + c]. */
+    size_t ncolors; /**< The number of distinct colors of the walls. */
+};
+
+
+/**
+ * @brief Collects the distinct colors of the walls and builds their shades. The index of the color of every
+ *        wall is stored in the wall.
+ *
+ * @param colormap The colormap to build.
+ * @param world The world.
+ * @param lightmult The light multiplier of the camera.
+ * @return 0 on success, -1 on error.
+ */
+int colormap_build(struct colormap_t *colormap, struct world_t *world, float lightmult);
+
+/**
+ * @brief Frees the shades of a colormap.
+ * @param colormap The colormap to destroy.
+ */
+void colormap_destroy(struct colormap_t *colormap);
+
+/**
+ * @brief Rebuilds the shades of a colormap for a new light multiplier.
+ *
+ * @param colormap The colormap.
+ * @param lightmult The light multiplier of the camera.
+ */
+void colormap_set_light(struct colormap_t *colormap, float lightmult);
+
+/**
+ * @brief Computes the light levels of walls at the given distances.
+ *
+ * @param dist The distances.
+ * @param levels The light levels, indices into the shades of a colormap.
+ * @param n The number of distances.
+ */
+void colormap_levels(const float *dist, uint32_t *levels, size_t n);
+
+/**
+ * @brief Looks up the shade of the color of a wall at a distance.
+ *
+ * @param colormap The colormap.
+ * @param wall The wall, whose shade index must have been set by colormap_build().
+ * @param dist The distance to the wall.
+ * @return The shade, as an ARGB8888 pixel.
+ */
+Uint32 colormap_shade(const struct colormap_t *colormap, const struct wall_t *wall, float dist);
+
+/**
+ * @brief Unpacks a shade of a colormap, the inverse of framebuffer_color().
+ *
+ * @param shade The shade, as an ARGB8888 pixel.
+ * @return The color of the shade.
+ */
+SDL_Color colormap_color(Uint32 shade);
+
+
+#endif //RAY_COLORMAP_H
@@ -12,6 +12,30 @@
  */
 #define WORLD_SPEC_FILE "assets/world.txt"
 
+/**
+ * @brief Default size of the arena holding the objects of the world in bytes, i.e. the memory budget for loading
+ *        the world. Can be overridden on the command line.
+ */
+#define WORLD_MEMORY_BUDGET (64 * 1024 * 1024)
+
+/**
+ * @brief Suffix appended to the path of the world specification to get the path of the compiled world, which is
+ *        mapped instead of parsing the specification as long as it is up to date, and rewritten otherwise.
+ */
+#define WORLD_COMPILED_SUFFIX ".bin"
+
+/**
+ * @brief Boolean flag indicating whether the walls of the world are optimized after the specification is parsed,
+ *        see optimize_world().
+ */
+#define WORLD_OPTIMIZE 1
+
+/**
+ * @brief Distance below which the endpoints of walls are welded into one, which is also the distance by which a
+ *        wall may deviate from the line of the walls it is merged with.
+ */
+#define WORLD_WELD_DISTANCE 0.01F
+
 /**
  * @brief Width of the window in pixels.
  */
@@ -112,6 +136,83 @@
  */
 #define CAMERA_FISHEYE 0.36F
 
+/**
+ * @brief Number of threads used for ray casting, including the main thread. 0 means one thread per CPU.
+ */
+#define RAYCAST_THREADS 0
+
+/**
+ * @brief Number of rays in a tile, the unit of work distributed among the ray casting threads.
+ */
+#define RAYCAST_TILE_SIZE 32
+
+/**
+ * @brief Target number of grid cells per wall used to choose the cell size of the uniform grid.
+ */
+#define GRID_CELLS_PER_WALL 2.0F
+
+/**
+ * @brief Maximum number of cells of the uniform grid along either axis.
+ */
+#define GRID_DIM_MAX 1024
+
+/**
+ * @brief Number of bins used to evaluate the split candidates of a BVH node.
+ */
+#define BVH_BINS 16
+
+/**
+ * @brief Maximum number of walls in a BVH leaf, unless the walls cannot be split any further.
+ */
+#define BVH_LEAF_SIZE 8
+
+/**
+ * @brief Boolean flag indicating whether a BSP tree should be built when the world is loaded.
+ */
+#define BSP_ENABLED 1
+
+/**
+ * @brief Maximum number of walls considered as the partition line of a BSP node.
+ */
+#define BSP_CANDIDATES 16
+
+/**
+ * @brief Cost of splitting a wall, relative to the cost of one wall of imbalance between the subtrees of a BSP node.
+ */
+#define BSP_SPLIT_COST 8.0F
+
+/**
+ * @brief Number of neighbouring rays sharing a list of candidate walls after frustum culling.
+ */
+#define CULL_BUCKET_SIZE 4
+
+/**
+ * @brief Distance beyond which walls are culled from the view, or 0 to cull by angle only.
+ */
+#define CULL_VIEW_DISTANCE 0.0F
+
+/**
+ * @brief Maximum distance, in pixels, between an edge of a wall stripe and the edge of the trapezoid it is merged
+ *        into.
+ */
+#define SPAN_TOLERANCE 0.5F
+
+/**
+ * @brief Maximum difference of a color channel of a wall stripe and the trapezoid it is merged into.
+ */
+#define SPAN_COLOR_TOLERANCE 2.0F
+
+/**
+ * @brief Number of light levels of the colormap, from black to the full color of a wall.
+ */
+#define COLORMAP_LEVELS 1024
+
+/**
+ * @brief Number of screen columns in a tile, the unit of work distributed among the threads drawing into the
+ *        software framebuffer.
+ */
+#define FRAMEBUFFER_TILE_SIZE 64
+
 /**
  * @brief Size of the walls in the game world.
  */
@@ -148,6 +249,9 @@
 #define KEY_VIEW_1 SDLK_F1
 #define KEY_VIEW_2 SDLK_F2
 #define KEY_VIEW_3 SDLK_F3
+#define KEY_VIEW_4 SDLK_F5
+#define KEY_VIEW_5 SDLK_F6
+#define KEY_INDEX SDLK_F4
 #define KEY_LIGHT_INC SDLK_HOME
 #define KEY_LIGHT_DEC SDLK_END
 #define KEY_FULLSCREEN SDLK_F11
@@ -11,6 +11,10 @@
 #define STATIC_ASSERT(cond) static_assert_inner2(cond, __LINE__)
 
 
+#if WORLD_MEMORY_BUDGET < 1
+#error "WORLD_MEMORY_BUDGET must be positive"
+#endif
+
 #if SCREEN_WIDTH < 1
 #error "SCREEN_WIDTH must be positive"
 #endif
@@ -63,6 +67,42 @@
 #error "CAMERA_HEADING must be between 0 and 359"
 #endif
 
+#if RAYCAST_THREADS < 0
+#error "RAYCAST_THREADS must be non-negative"
+#endif
+
+#if RAYCAST_TILE_SIZE < 1
+#error "RAYCAST_TILE_SIZE must be positive"
+#endif
+
+#if GRID_DIM_MAX < 1
+#error "GRID_DIM_MAX must be positive"
+#endif
+
+#if BVH_BINS < 2
+#error "BVH_BINS must be at least 2"
+#endif
+
+#if BVH_LEAF_SIZE < 1
+#error "BVH_LEAF_SIZE must be positive"
+#endif
+
+#if BSP_CANDIDATES < 1
+#error "BSP_CANDIDATES must be positive"
+#endif
+
+#if CULL_BUCKET_SIZE < 1
+#error "CULL_BUCKET_SIZE must be positive"
+#endif
+
+#if COLORMAP_LEVELS < 2
+#error "COLORMAP_LEVELS must be at least 2"
+#endif
+
+#if FRAMEBUFFER_TILE_SIZE < 1
+#error "FRAMEBUFFER_TILE_SIZE must be positive"
+#endif
+
 #if WALL_SIZE < 1
 #error "WALL_SIZE must be positive"
 #endif
@@ -72,12 +112,18 @@
 #endif
 
 
+STATIC_ASSERT((intmax_t) WORLD_WELD_DISTANCE >= 0); // WORLD_WELD_DISTANCE must be non-negative
 STATIC_ASSERT((intmax_t) CAMERA_ROTATION_SPEED >= 0); // CAMERA_ROTATION_SPEED must be non-negative
 STATIC_ASSERT((intmax_t) CAMERA_MOVEMENT_SPEED >= 0); // CAMERA_MOVEMENT_SPEED must be non-negative
 STATIC_ASSERT((intmax_t) CAMERA_SPRINT_MOVEMENT_SPEED >= 0); // CAMERA_SPRINT_MOVEMENT_SPEED must be non-negative
 STATIC_ASSERT((intmax_t) CAMERA_CROUCH_MOVEMENT_SPEED >= 0); // CAMERA_CROUCH_MOVEMENT_SPEED must be non-negative
 STATIC_ASSERT((intmax_t) CAMERA_CROUCH_HEIGHT_DELTA >= 0); // CAMERA_CROUCH_HEIGHT_DELTA must be non-negative
 STATIC_ASSERT((intmax_t) CAMERA_LIGHTMULT >= 1); // CAMERA_LIGHTMULT must be positive
+STATIC_ASSERT((intmax_t) GRID_CELLS_PER_WALL >= 1); // GRID_CELLS_PER_WALL must be at least 1
+STATIC_ASSERT((intmax_t) BSP_SPLIT_COST >= 0); // BSP_SPLIT_COST must be non-negative
+STATIC_ASSERT((intmax_t) CULL_VIEW_DISTANCE >= 0); // CULL_VIEW_DISTANCE must be non-negative
+STATIC_ASSERT((intmax_t) SPAN_TOLERANCE >= 0); // SPAN_TOLERANCE must be non-negative
+STATIC_ASSERT((intmax_t) SPAN_COLOR_TOLERANCE >= 0); // SPAN_COLOR_TOLERANCE must be non-negative
 
 
 #undef STATIC_ASSERT
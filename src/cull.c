@@ -0,0 +1,221 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "conf.h"
+#include "logger.h"
+#include "math.h"
+
+#include "cull.h"
+
+
+static inline float cross(const struct vec_t a, const struct vec_t b) {
+    return a.x * b.y - a.y * b.x;
+}
+
+/**
+ * @brief Computes the squared distance from the origin to the segment a + t * e, t in [0, 1].
+ */
+static float segment_dist2(const struct vec_t a, const struct vec_t e) {
+    const float len2 = vlen2(e);
+    const float t = len2 > 0.0F ? constrain(-(a.x * e.x + a.y * e.y) / len2, 0.0F, 1.0F) : 0.0F;
+
+    return vlen2(vadd(a, vmul(e, t)));
+}
+
+static void add_range(struct cull_t *const cull, const size_t wall, const float lo, const float hi,
+                      const size_t nrays, const float step) {
+    const float first = floorf(lo / step) - 1.0F;
+    const float last = ceilf(hi / step) + 1.0F;
+
+    cull->ranges[cull->nranges++] = (struct cull_range_t) {
+            .wall = (uint32_t) wall,
+            .first = first > 0.0F ? (uint32_t) first : 0,
+            .last = last < (float) (nrays - 1) ? (uint32_t) last : (uint32_t) (nrays - 1)
+    };
+}
+
+/**
+ * @brief Computes the angular extents of the walls relative to the first ray and keeps those inside the wedge.
+ */
+static void add_ranges(struct cull_t *const cull, const struct wall_table_t *const walls, const struct vec_t pos,
+                       const size_t nrays, const float angle, const float step, const float max_dist) {
+    const float span = (float) nrays * step;
+
+    cull->nranges = 0;
+    cull->candidates = 0;
+
+    for (size_t i = 0; i < walls->count; i++) {
+        const struct vec_t a = {walls->ax[i] - pos.x, walls->ay[i] - pos.y};
+        const struct vec_t e = {walls->ex[i], walls->ey[i]};
+
+        if (max_dist > 0.0F && segment_dist2(a, e) > max_dist * max_dist) {
+            continue;
+        }
+
+        const struct vec_t b = vadd(a, e);
+        const float area = cross(a, b);
+        const struct vec_t start = area > 0.0F ? a : b;
+        const float arc = atan2f(fabsf(area), a.x * b.x + a.y * b.y);
+        float lo = fmodf(atan2f(start.y, start.x) - angle, 2.0F * PI);
+
+        if (lo < 0.0F) {
+            lo += 2.0F * PI;
+        }
+
+        const float hi = lo + arc;
+        const size_t nranges = cull->nranges;
+
+        if (lo < span) {
+            add_range(cull, i, lo, fminf(hi, span), nrays, step);
+        }
+
+        /* the wall wraps around the first ray, or nearly does */
+        if (hi + step > 2.0F * PI) {
+            add_range(cull, i, 0.0F, fminf(fmaxf(hi - 2.0F * PI, 0.0F), span), nrays, step);
+        }
+
+        if (cull->nranges > nranges) {
+            cull->candidates++;
+        }
+    }
+}
+
+/**
+ * @brief Makes sure the wall table can hold the given number of references.
+ * @return 0 on success, -1 on error.
+ */
+static int reserve(struct cull_t *const cull, const size_t count) {
+    if (count <= cull->table.count) {
+        return 0;
+    }
+
+    const size_t capacity = SDL_max(count, 2 * cull->table.count);
+    uint32_t *const ids = realloc(cull->ids, capacity * sizeof *ids);
+
+    if (ids == NULL) {
+        logger_perror("realloc");
+        return -1;
+    }
+
+    cull->ids = ids;
+    wall_table_destroy(&cull->table);
+    return wall_table_alloc(&cull->table, capacity);
+}
+
+int cull_create(struct cull_t *const cull, const size_t nwalls, const size_t nrays) {
+    const size_t nbuckets = (nrays + CULL_BUCKET_SIZE - 1) / CULL_BUCKET_SIZE;
+
+    memset(cull, 0, sizeof *cull);
+
+    if (nwalls > UINT32_MAX / 2 || nrays > UINT32_MAX) {
+        logger_printf(LOG_LEVEL_ERROR, "too many walls or rays to cull: %zu, %zu\n", nwalls, nrays);
+        return -1;
+    }
+
+    cull->ranges = malloc(SDL_max(2 * nwalls, 1) * sizeof *cull->ranges);
+    cull->buckets = malloc((nbuckets + 1) * sizeof *cull->buckets);
+
+    if (cull->ranges == NULL || cull->buckets == NULL || reserve(cull, SDL_max(nwalls, 1)) != 0) {
+        logger_print(LOG_LEVEL_ERROR, "unable to allocate culling buffers");
+        cull_destroy(cull);
+        return -1;
+    }
+
+    cull->nwalls = nwalls;
+    cull->nrays = nrays;
+    return 0;
+}
+
+void cull_destroy(struct cull_t *const cull) {
+    free(cull->ranges);
+    free(cull->buckets);
+    free(cull->ids);
+    wall_table_destroy(&cull->table);
+    memset(cull, 0, sizeof *cull);
+}
+
+int cull_walls(struct cull_t *const restrict cull,
+               const struct wall_table_t *const restrict walls,
+               const struct vec_t pos,
+               const size_t nrays,
+               const float angle,
+               const float step,
+               const float max_dist) {
+    cull->nbuckets = 0;
+    cull->nranges = 0;
+
+    if (nrays == 0 || nrays > cull->nrays || walls->count > cull->nwalls) {
+        return -1;
+    }
+
+    const size_t nbuckets = (nrays + CULL_BUCKET_SIZE - 1) / CULL_BUCKET_SIZE;
+    size_t *const buckets = cull->buckets;
+
+    add_ranges(cull, walls, pos, nrays, angle, step, max_dist);
+    memset(buckets, 0, (nbuckets + 1) * sizeof *buckets);
+
+    /* count the references of every bucket, then fill them in using the start of each bucket as a cursor */
+    for (size_t i = 0; i < cull->nranges; i++) {
+        for (size_t b = cull->ranges[i].first / CULL_BUCKET_SIZE; b <= cull->ranges[i].last / CULL_BUCKET_SIZE; b++) {
+            buckets[b]++;
+        }
+    }
+
+    for (size_t b = 0, first = 0; b <= nbuckets; b++) {
+        const size_t count = buckets[b];
+        buckets[b] = first;
+        first += count;
+    }
+
+    if (reserve(cull, buckets[nbuckets]) != 0) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < cull->nranges; i++) {
+        const struct cull_range_t *const range = &cull->ranges[i];
+
+        for (size_t b = range->first / CULL_BUCKET_SIZE; b <= range->last / CULL_BUCKET_SIZE; b++) {
+            const size_t j = buckets[b]++;
+
+            cull->ids[j] = range->wall;
+            cull->table.ax[j] = walls->ax[range->wall];
+            cull->table.ay[j] = walls->ay[range->wall];
+            cull->table.ex[j] = walls->ex[range->wall];
+            cull->table.ey[j] = walls->ey[range->wall];
+            cull->table.walls[j] = walls->walls[range->wall];
+        }
+    }
+
+    /* every cursor now points at the start of the next bucket */
+    for (size_t b = nbuckets - 1; b > 0; b--) {
+        buckets[b] = buckets[b - 1];
+    }
+
+    buckets[0] = 0;
+    cull->nbuckets = nbuckets;
+    return 0;
+}
+
+size_t cull_cast(const struct cull_t *const restrict cull,
+                 const size_t ray,
+                 const struct vec_t pos,
+                 const struct vec_t dir,
+                 float *const restrict dist,
+                 size_t *const restrict tested) {
+    const size_t bucket = ray / CULL_BUCKET_SIZE;
+
+    if (bucket >= cull->nbuckets) {
+        return RAY_NO_HIT;
+    }
+
+    const size_t begin = cull->buckets[bucket];
+    const size_t end = cull->buckets[bucket + 1];
+    const size_t hit = ray_cast(&cull->table, begin, end, pos, dir, dist);
+
+    if (tested != NULL) {
+        *tested += end - begin;
+    }
+
+    return hit == RAY_NO_HIT ? RAY_NO_HIT : cull->ids[hit];
+}
@@ -0,0 +1,92 @@
+#ifndef RAY_CULL_H
+#define RAY_CULL_H
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ray.h"
+#include "vector.h"
+
+
+/**
+ * @brief The rays whose angle is covered by the angular extent of a wall.
+ */
+struct cull_range_t {
+    uint32_t wall; /**< The index of the wall in the wall table. */
+    uint32_t first; /**< The first ray covered by the wall. */
+    uint32_t last; /**< The last ray covered by the wall. */
+};
+
+/**
+ * @brief The walls in the view wedge of the current frame, grouped by the rays they may be hit by.
+ *
+ * The rays are split into buckets of CULL_BUCKET_SIZE neighbouring rays. Every bucket refers to the walls
+ * whose angular extent covers one of its rays. The references of all buckets are stored back to back in a
+ * single wall table, so that the walls of a bucket can be tested with a single call to ray_cast().
+ */
+struct cull_t {
+    struct cull_range_t *ranges; /**< The angular extents of the walls in the view wedge. */
+    size_t nranges; /**< The number of ranges. */
+    size_t *buckets; /**< The walls of bucket i are table entries [buckets[i], buckets[i + 1]). */
+    size_t nbuckets; /**< The number of buckets of the current frame. */
+    uint32_t *ids; /**< For every table entry, the index of the wall in the table it was culled from. */
+    struct wall_table_t table; /**< The wall references of all buckets; count is the allocated capacity. */
+    size_t nwalls; /**< The maximum number of walls. */
+    size_t nrays; /**< The maximum number of rays. */
+    size_t candidates; /**< The number of walls in the view wedge of the current frame. */
+};
+
+
+/**
+ * @brief Allocates the buffers of the culling pass.
+ *
+ * @param cull The culling pass to initialize.
+ * @param nwalls The maximum number of walls.
+ * @param nrays The maximum number of rays.
+ * @return 0 on success, -1 on error.
+ */
+int cull_create(struct cull_t *cull, size_t nwalls, size_t nrays);
+
+/**
+ * @brief Frees the buffers of the culling pass.
+ * @param cull The culling pass to destroy.
+ */
+void cull_destroy(struct cull_t *cull);
+
+/**
+ * @brief Clips the walls against the view wedge spanned by a fan of rays and groups the remaining walls by
+ *        the rays their angular extent covers.
+ *
+ * Walls behind the origin or outside the wedge are dropped, as well as walls farther than @p max_dist if it
+ * is positive. The extents are widened by one ray on either side to absorb rounding errors.
+ *
+ * @param cull The culling pass, allocated for at least @p walls->count walls and @p nrays rays.
+ * @param walls The walls.
+ * @param pos The common origin of the rays.
+ * @param nrays The number of rays. The rays must not span more than a full turn.
+ * @param angle The angle of the first ray (in radians).
+ * @param step The angle between two neighbouring rays. Must be positive.
+ * @param max_dist The view distance beyond which walls are dropped, or 0 for no limit.
+ * @return 0 on success, -1 on error (no ray hits any wall in this case).
+ */
+int cull_walls(struct cull_t *cull, const struct wall_table_t *walls, struct vec_t pos, size_t nrays, float angle,
+               float step, float max_dist);
+
+/**
+ * @brief Finds the nearest wall hit by a ray of the fan among the walls whose extent covers it.
+ *
+ * @param cull The culling pass of the current frame.
+ * @param ray The index of the ray in the fan.
+ * @param pos The origin of the ray.
+ * @param dir The direction of the ray. Must be a unit vector.
+ * @param dist A pointer to the distance to the nearest hit found so far, or INFINITY. Updated if a nearer
+ *             hit is found.
+ * @param tested If not NULL, incremented by the number of walls tested.
+ * @return The index of the nearest wall hit by the ray in the table the walls were culled from, or RAY_NO_HIT.
+ */
+size_t cull_cast(const struct cull_t *cull, size_t ray, struct vec_t pos, struct vec_t dir, float *dist,
+                 size_t *tested);
+
+
+#endif //RAY_CULL_H
@@ -8,15 +8,83 @@
 
 
 static void camera_set_resmult(struct game_t *const game, const size_t resmult) {
+    const size_t last = game->camera->resmult;
+
     game->camera->resmult = (size_t) constrain((float) resmult, RESMULT_MIN, RESMULT_MAX);
+
+    if (camera_update_columns(game) != 0) {
+        game->camera->resmult = last;
+    }
 }
 
 static void camera_set_fov(struct game_t *const game, const size_t fov) {
+    const size_t last = game->camera->fov;
+
     game->camera->fov = (size_t) constrain((float) fov, FOV_MIN, FOV_MAX);
+
+    if (camera_update_columns(game) != 0) {
+        game->camera->fov = last;
+    }
+}
+
+static void camera_set_fisheye(struct game_t *const game, const float fisheye) {
+    const float last = game->camera->fisheye;
+
+    game->camera->fisheye = fisheye;
+
+    if (camera_update_columns(game) != 0) {
+        game->camera->fisheye = last;
+    }
 }
 
 static void camera_set_lightmult(struct game_t *const game, const float lightmult) {
     game->camera->lightmult = constrain(lightmult, 0.0F, INFINITY);
+    colormap_set_light(&game->colormap, game->camera->lightmult);
+}
+
+static bool index_available(const struct game_t *const game) {
+    switch (game->index) {
+        case INDEX_LINEAR:
+        case INDEX_GRID:
+        case INDEX_BVH:
+        case INDEX_SWEEP:
+        case INDEX_FRUSTUM:
+            return true;
+        case INDEX_BSP:
+            return game->bsp.nodes != NULL;
+        case INDEX_SECTOR:
+            return game->sectors.nsectors > 0;
+    }
+
+    return false;
+}
+
+static void cycle_index(struct game_t *const game) {
+    do {
+        switch (game->index) {
+            case INDEX_LINEAR:
+                game->index = INDEX_GRID;
+                break;
+            case INDEX_GRID:
+                game->index = INDEX_BVH;
+                break;
+            case INDEX_BVH:
+                game->index = INDEX_BSP;
+                break;
+            case INDEX_BSP:
+                game->index = INDEX_SECTOR;
+                break;
+            case INDEX_SECTOR:
+                game->index = INDEX_SWEEP;
+                break;
+            case INDEX_SWEEP:
+                game->index = INDEX_FRUSTUM;
+                break;
+            case INDEX_FRUSTUM:
+                game->index = INDEX_LINEAR;
+                break;
+        }
+    } while (!index_available(game));
 }
 
 static void log_event(const SDL_Event *const event) {
@@ -110,6 +178,15 @@ void on_event(struct game_t *const restrict game, const SDL_Event *const restric
                 case KEY_VIEW_3:
                     game->render_mode = RENDER_MODE_UNTEXTURED;
                     break;
+                case KEY_VIEW_4:
+                    game->render_mode = RENDER_MODE_PROJECTED;
+                    break;
+                case KEY_VIEW_5:
+                    game->render_mode = RENDER_MODE_SOFTWARE;
+                    break;
+                case KEY_INDEX:
+                    cycle_index(game);
+                    break;
                 case KEY_LIGHT_INC:
                     camera_set_lightmult(game, game->camera->lightmult + 0.1F);
                     break;
@@ -121,10 +198,10 @@ void on_event(struct game_t *const restrict game, const SDL_Event *const restric
                     SDL_SetWindowFullscreen(game->window, game->fullscreen ? SDL_WINDOW_FULLSCREEN : 0);
                     break;
                 case KEY_FISHEYE_INC:
-                    game->camera->fisheye += 0.01F;
+                    camera_set_fisheye(game, game->camera->fisheye + 0.01F);
                     break;
                 case KEY_FISHEYE_DEC:
-                    game->camera->fisheye -= 0.01F;
+                    camera_set_fisheye(game, game->camera->fisheye - 0.01F);
                     break;
             }
             break;
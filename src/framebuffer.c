@@ -0,0 +1,199 @@
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "logger.h"
+
+#include "framebuffer.h"
+
+
+/**
+ * Side of the square blocks of pixels transposed at once, chosen so that the rows of a block in the source and
+ * in the destination both stay in the L1 cache.
+ */
+#define FRAMEBUFFER_BLOCK 32
+
+
+/**
+ * @brief A framebuffer being transposed into a locked texture on the worker pool.
+ */
+struct present_t {
+    const struct framebuffer_t *framebuffer; /**< The framebuffer. */
+    Uint32 *pixels; /**< The pixels of the locked texture. */
+    size_t pitch; /**< The distance between two rows of the texture, in pixels. */
+};
+
+
+int framebuffer_create(struct framebuffer_t *const restrict framebuffer, SDL_Renderer *const restrict renderer,
+                       const int width, const int height) {
+    memset(framebuffer, 0, sizeof *framebuffer);
+
+    if (width <= 0 || height <= 0) {
+        logger_printf(LOG_LEVEL_ERROR, "invalid framebuffer size: %d x %d\n", width, height);
+        return -1;
+    }
+
+    framebuffer->columns = malloc((size_t) width * (size_t) height * sizeof *framebuffer->columns);
+
+    if (framebuffer->columns == NULL) {
+        logger_perror("malloc");
+        return -1;
+    }
+
+    framebuffer->width = width;
+    framebuffer->height = height;
+
+    if (renderer == NULL) {
+        return 0;
+    }
+
+    framebuffer->texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+                                             width, height);
+
+    if (framebuffer->texture == NULL) {
+        logger_printf(LOG_LEVEL_ERROR, "SDL_CreateTexture: %s\n", SDL_GetError());
+        framebuffer_destroy(framebuffer);
+        return -1;
+    }
+
+    return 0;
+}
+
+void framebuffer_destroy(struct framebuffer_t *const framebuffer) {
+    if (framebuffer->texture != NULL) {
+        SDL_DestroyTexture(framebuffer->texture);
+    }
+
+    free(framebuffer->columns);
+    memset(framebuffer, 0, sizeof *framebuffer);
+}
+
+/**
+ * @brief Transposes the pixels [x0, x1) x [y0, y1) one by one.
+ */
+static void transpose_scalar(const Uint32 *const restrict src, const size_t height, Uint32 *const restrict dst,
+                             const size_t pitch, const int x0, const int x1, const int y0, const int y1) {
+    for (int y = y0; y < y1; y++) {
+        for (int x = x0; x < x1; x++) {
+            dst[(size_t) y * pitch + (size_t) x] = src[(size_t) x * height + (size_t) y];
+        }
+    }
+}
+
+#ifdef __SSE2__
+
+/**
+ * @brief Transposes the 4 x 4 pixels at @p src, four columns of four rows, to @p dst, four rows of four columns.
+ */
+static inline void transpose_4x4(const Uint32 *const restrict src, const size_t height,
+                                 Uint32 *const restrict dst, const size_t pitch) {
+    const __m128i a = _mm_loadu_si128((const __m128i *) src);
+    const __m128i b = _mm_loadu_si128((const __m128i *) (src + height));
+    const __m128i c = _mm_loadu_si128((const __m128i *) (src + 2 * height));
+    const __m128i d = _mm_loadu_si128((const __m128i *) (src + 3 * height));
+
+    /* a0 b0 a1 b1, a2 b2 a3 b3, c0 d0 c1 d1, c2 d2 c3 d3 */
+    const __m128i ab_lo = _mm_unpacklo_epi32(a, b);
+    const __m128i ab_hi = _mm_unpackhi_epi32(a, b);
+    const __m128i cd_lo = _mm_unpacklo_epi32(c, d);
+    const __m128i cd_hi = _mm_unpackhi_epi32(c, d);
+
+    _mm_storeu_si128((__m128i *) dst, _mm_unpacklo_epi64(ab_lo, cd_lo));
+    _mm_storeu_si128((__m128i *) (dst + pitch), _mm_unpackhi_epi64(ab_lo, cd_lo));
+    _mm_storeu_si128((__m128i *) (dst + 2 * pitch), _mm_unpacklo_epi64(ab_hi, cd_hi));
+    _mm_storeu_si128((__m128i *) (dst + 3 * pitch), _mm_unpackhi_epi64(ab_hi, cd_hi));
+}
+
+#endif
+
+/**
+ * @brief Transposes the block of pixels [x0, x1) x [y0, y1).
+ */
+static void transpose_block(const Uint32 *const restrict src, const size_t height, Uint32 *const restrict dst,
+                            const size_t pitch, const int x0, const int x1, const int y0, const int y1) {
+#ifdef __SSE2__
+    const int x4 = x0 + (x1 - x0) / 4 * 4;
+    const int y4 = y0 + (y1 - y0) / 4 * 4;
+
+    for (int y = y0; y < y4; y += 4) {
+        for (int x = x0; x < x4; x += 4) {
+            transpose_4x4(&src[(size_t) x * height + (size_t) y], height, &dst[(size_t) y * pitch + (size_t) x],
+                          pitch);
+        }
+    }
+
+    /* the pixels left over on the right and at the bottom of the block */
+    transpose_scalar(src, height, dst, pitch, x4, x1, y0, y4);
+    transpose_scalar(src, height, dst, pitch, x0, x1, y4, y1);
+#else
+    transpose_scalar(src, height, dst, pitch, x0, x1, y0, y1);
+#endif
+}
+
+void framebuffer_transpose(const struct framebuffer_t *const restrict framebuffer, Uint32 *const restrict pixels,
+                           const size_t pitch, const int top, const int bottom) {
+    const size_t height = (size_t) framebuffer->height;
+
+    for (int y = SDL_max(top, 0); y < SDL_min(bottom, framebuffer->height); y += FRAMEBUFFER_BLOCK) {
+        const int y1 = SDL_min(y + FRAMEBUFFER_BLOCK, SDL_min(bottom, framebuffer->height));
+
+        for (int x = 0; x < framebuffer->width; x += FRAMEBUFFER_BLOCK) {
+            transpose_block(framebuffer->columns, height, pixels, pitch, x,
+                            SDL_min(x + FRAMEBUFFER_BLOCK, framebuffer->width), y, y1);
+        }
+    }
+}
+
+static void transpose_bands(const void *const arg, const size_t begin, const size_t end) {
+    const struct present_t *const present = arg;
+
+    framebuffer_transpose(present->framebuffer, present->pixels, present->pitch,
+                          (int) begin * FRAMEBUFFER_BLOCK, (int) end * FRAMEBUFFER_BLOCK);
+}
+
+int framebuffer_present(const struct framebuffer_t *const restrict framebuffer, SDL_Renderer *const restrict renderer,
+                        struct pool_t *const restrict pool) {
+    const SDL_Rect target = {.x = 0, .y = 0, .w = framebuffer->width, .h = framebuffer->height};
+    const size_t nbands = ((size_t) framebuffer->height + FRAMEBUFFER_BLOCK - 1) / FRAMEBUFFER_BLOCK;
+    void *pixels;
+    int pitch;
+
+    if (SDL_LockTexture(framebuffer->texture, NULL, &pixels, &pitch) != 0) {
+        logger_printf(LOG_LEVEL_ERROR, "SDL_LockTexture: %s\n", SDL_GetError());
+        return -1;
+    }
+
+    const struct present_t present = {
+            .framebuffer = framebuffer,
+            .pixels = pixels,
+            .pitch = (size_t) pitch / sizeof *present.pixels
+    };
+
+    pool_run(pool, nbands, 1, transpose_bands, &present);
+    SDL_UnlockTexture(framebuffer->texture);
+
+    if (SDL_RenderCopy(renderer, framebuffer->texture, NULL, &target) != 0) {
+        logger_printf(LOG_LEVEL_ERROR, "SDL_RenderCopy: %s\n", SDL_GetError());
+        return -1;
+    }
+
+    return 0;
+}
+
+void framebuffer_fill_column(const struct framebuffer_t *const framebuffer, const int x, const int top,
+                             const int bottom, const Uint32 color) {
+    const int first = SDL_max(top, 0);
+    const int last = SDL_min(bottom, framebuffer->height);
+    Uint32 *const column = &framebuffer->columns[(size_t) x * (size_t) framebuffer->height];
+
+    for (int y = first; y < last; y++) {
+        column[y] = color;
+    }
+}
+
+Uint32 framebuffer_color(const SDL_Color color) {
+    return (Uint32) color.a << 24 | (Uint32) color.r << 16 | (Uint32) color.g << 8 | (Uint32) color.b;
+}
@@ -0,0 +1,91 @@
+#ifndef RAY_FRAMEBUFFER_H
+#define RAY_FRAMEBUFFER_H
+
+
+#include <stddef.h>
+
+#include <SDL2/SDL.h>
+
+#include "pool.h"
+
+
+/**
+ * @brief A CPU-side ARGB8888 image backed by a streaming texture, uploaded to the renderer once per frame.
+ *
+ * The image is drawn column by column, so it is stored transposed: every column is contiguous in memory, and
+ * filling it touches consecutive cache lines. It is only transposed to the row-major layout of the texture when
+ * presented. Several threads may draw into the framebuffer at once, as long as no two threads write the same
+ * column.
+ */
+struct framebuffer_t {
+    SDL_Texture *texture; /**< The streaming texture the pixels are uploaded to, or NULL if not presented. */
+    Uint32 *columns; /**< The pixels, column by column: the pixel (x, y) is at columns[x * height + y]. */
+    int width; /**< The width of the image, in pixels. */
+    int height; /**< The height of the image, in pixels. */
+};
+
+
+/**
+ * @brief Allocates the pixels of a framebuffer and creates its streaming texture.
+ *
+ * @param framebuffer The framebuffer to initialize.
+ * @param renderer The renderer the framebuffer is presented with, or NULL to only allocate the pixels.
+ * @param width The width of the image, in pixels.
+ * @param height The height of the image, in pixels.
+ * @return 0 on success, -1 on error.
+ */
+int framebuffer_create(struct framebuffer_t *framebuffer, SDL_Renderer *renderer, int width, int height);
+
+/**
+ * @brief Frees the pixels and destroys the streaming texture of a framebuffer.
+ * @param framebuffer The framebuffer to destroy.
+ */
+void framebuffer_destroy(struct framebuffer_t *framebuffer);
+
+/**
+ * @brief Transposes the rows [@p top, @p bottom) of a framebuffer into a row-major image.
+ *
+ * The image is copied in square blocks which fit in the cache, and, where SSE2 is available, the pixels are
+ * transposed four by four in registers.
+ *
+ * @param framebuffer The framebuffer.
+ * @param pixels The row-major image, at least as large as the framebuffer.
+ * @param pitch The distance between two rows of @p pixels, in pixels.
+ * @param top The first row.
+ * @param bottom The row after the last row.
+ */
+void framebuffer_transpose(const struct framebuffer_t *framebuffer, Uint32 *pixels, size_t pitch, int top,
+                           int bottom);
+
+/**
+ * @brief Transposes a framebuffer into its texture, in bands of rows on the worker pool, and copies the texture
+ *        to the top left corner of the render target, in the same coordinates as the other primitives.
+ *
+ * @param framebuffer The framebuffer, which must have a texture.
+ * @param renderer The renderer to draw with.
+ * @param pool The worker pool.
+ * @return 0 on success, -1 on error.
+ */
+int framebuffer_present(const struct framebuffer_t *framebuffer, SDL_Renderer *renderer, struct pool_t *pool);
+
+/**
+ * @brief Fills the rows [@p top, @p bottom) of a column of a framebuffer. The rows are clipped to the image.
+ *
+ * @param framebuffer The framebuffer.
+ * @param x The column, which must be inside the image.
+ * @param top The first row.
+ * @param bottom The row after the last row.
+ * @param color The color, see framebuffer_color().
+ */
+void framebuffer_fill_column(const struct framebuffer_t *framebuffer, int x, int top, int bottom, Uint32 color);
+
+/**
+ * @brief Converts a color to the pixel format of framebuffers.
+ *
+ * @param color The color.
+ * @return The color as an ARGB8888 pixel.
+ */
+Uint32 framebuffer_color(SDL_Color color);
+
+
+#endif //RAY_FRAMEBUFFER_H
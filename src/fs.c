@@ -1,7 +1,9 @@
+#include <errno.h>
 #include <fcntl.h>
 #include <inttypes.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
@@ -48,22 +50,21 @@ static int mode_to_flags(const char *const mode) {
     return -1;
 }
 
-FILE *open_file(const char *const restrict path, const char *const restrict mode) {
-    if (path == NULL || mode == NULL) {
-        return NULL;
-    }
-
-    const int flags = mode_to_flags(mode);
-
-    if (flags == -1) {
-        logger_print(LOG_LEVEL_ERROR, "invalid mode");
-        return NULL;
-    }
-
+/**
+ * @brief Opens a file given by a path relative to the directory where the program was launched from.
+ * @return A file descriptor on success, -1 on error. Only errors of openat(2) are left to the caller to report,
+ *         with errno set.
+ */
+static int open_relative(const char *const path, const int flags) {
+#ifdef RAY_STANDALONE
+    /* the tools do not link the SDL library and open their paths relative to the working directory */
+    return open(path, flags, 0644);
+#else
     char *const dirpath = SDL_GetBasePath();
 
     if (dirpath == NULL) {
-        return NULL;
+        errno = 0;
+        return -1;
     }
 
     const int dir_fd = open(dirpath, O_DIRECTORY);
@@ -71,19 +72,42 @@ FILE *open_file(const char *const restrict path, const char *const restrict mode
     if (dir_fd == -1) {
         logger_perror("open");
         free(dirpath);
-        return NULL;
+        errno = 0;
+        return -1;
     }
 
     free(dirpath);
-    const int fd = openat(dir_fd, path, flags);
+    const int fd = openat(dir_fd, path, flags, 0644);
+    const int error = errno;
+
+    close(dir_fd);
+    errno = error;
+    return fd;
+#endif
+}
+
+FILE *open_file(const char *const restrict path, const char *const restrict mode) {
+    if (path == NULL || mode == NULL) {
+        return NULL;
+    }
+
+    const int flags = mode_to_flags(mode);
+
+    if (flags == -1) {
+        logger_print(LOG_LEVEL_ERROR, "invalid mode");
+        return NULL;
+    }
+
+    const int fd = open_relative(path, flags);
 
     if (fd == -1) {
-        logger_perror("openat");
-        close(dir_fd);
+        if (errno != 0) {
+            logger_perror("openat");
+        }
+
         return NULL;
     }
 
-    close(dir_fd);
     FILE *const stream = fdopen(fd, mode);
 
     if (stream == NULL) {
@@ -102,3 +126,63 @@ FILE *open_file(const char *const restrict path, const char *const restrict mode
 
     return stream;
 }
+
+void *map_file(const char *const restrict path, size_t *const restrict size) {
+    if (path == NULL || size == NULL) {
+        return NULL;
+    }
+
+    const int fd = open_relative(path, O_RDONLY);
+
+    if (fd == -1) {
+        if (errno != 0 && errno != ENOENT) {
+            logger_perror("openat");
+        }
+
+        return NULL;
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) != 0) {
+        logger_perror("fstat");
+        close(fd);
+        return NULL;
+    }
+
+    if (st.st_size <= 0) {
+        close(fd);
+
+        /* an empty file cannot be mapped, a page of its own stands in for its contents */
+        void *const empty = mmap(NULL, 1, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (empty == MAP_FAILED) {
+            logger_perror("mmap");
+            return NULL;
+        }
+
+        *size = 0;
+        return empty;
+    }
+
+    /* a private writable mapping, so that the contents can be patched in memory without touching the file */
+    void *const data = mmap(NULL, (size_t) st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+    close(fd);
+
+    if (data == MAP_FAILED) {
+        logger_perror("mmap");
+        return NULL;
+    }
+
+    logger_printf(LOG_LEVEL_DEBUG, "%s [mmap] (%" PRIdMAX " bytes)\n", path, (intmax_t) st.st_size);
+
+    *size = (size_t) st.st_size;
+    return data;
+}
+
+void unmap_file(void *const data, const size_t size) {
+    if (data != NULL && munmap(data, size > 0 ? size : 1) != 0) {
+        logger_perror("munmap");
+    }
+}
@@ -2,6 +2,7 @@
 #define RAY_FS_H
 
 
+#include <stddef.h>
 #include <stdio.h>
 
 
@@ -14,4 +15,22 @@
  */
 FILE *open_file(const char *path, const char *mode);
 
+/**
+ * @brief Map a file given by a path relative to the directory where
+ * the program was launched from into memory, privately and writable.
+ * Changes to the mapping are not written back to the file.
+ * @param path The path to the file relative to the project root.
+ * @param size Pointer to store the size of the file in bytes.
+ * @return The contents of the file on success, which are no bytes for an empty
+ * file, NULL on error or if the file does not exist (only other errors are logged).
+ */
+void *map_file(const char *path, size_t *size);
+
+/**
+ * @brief Unmap a file mapped by map_file().
+ * @param data The contents of the file, or NULL.
+ * @param size The size of the file in bytes.
+ */
+void unmap_file(void *data, size_t size);
+
 #endif //RAY_FS_H
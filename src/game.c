@@ -1,5 +1,8 @@
-#include <assert.h>
 #include <inttypes.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL2_gfxPrimitives.h>
@@ -8,13 +11,27 @@
 #include "logger.h"
 #include "math.h"
 #include "menu.h"
+#include "optimize.h"
 #include "ray.h"
 #include "util.h"
 #include "vector.h"
+#include "worldbin.h"
 
 #include "game.h"
 
 
+/**
+ * Height of a wall on the screen, in pixels, at a distance of one unit.
+ */
+#define WALL_SCALING_FACTOR 200000.0F
+
+/**
+ * Distance from a whole number of rays within which a turn of the camera is considered to line up with the rays
+ * of the last frame.
+ */
+#define RECAST_EPSILON 1e-3F
+
+
 /**
  * Calculates the speed coefficient for the game based on the game's FPS and a given coefficient.
  *
@@ -36,13 +53,47 @@ static inline size_t camera_nrays(const struct game_t *const game) {
     return game->camera->fov * game->camera->resmult;
 }
 
-static void render_walls(const struct game_t *const game) {
-    for (size_t i = 0; i < game->nobjects; i++) {
-        if (game->objects[i]->type != WALL) {
-            continue;
-        }
+static const char *index_name(const struct game_t *const game) {
+    switch (game->index) {
+        case INDEX_LINEAR:
+            return "linear";
+        case INDEX_GRID:
+            return "grid";
+        case INDEX_BVH:
+            return "bvh";
+        case INDEX_BSP:
+            return "bsp";
+        case INDEX_SECTOR:
+            return "sectors";
+        case INDEX_SWEEP:
+            return "sweep";
+        case INDEX_FRUSTUM:
+            return "frustum";
+    }
+
+    return "unknown";
+}
+
+/**
+ * Calculates the average number of walls tested per ray in the last frame.
+ *
+ * @param game A pointer to the game_t struct representing the current game.
+ * @return The average number of walls tested per ray.
+ */
+static float walls_per_ray(const struct game_t *const game) {
+    const size_t nrays = camera_nrays(game);
+    size_t tested = 0;
 
-        const struct wall_t *const wall = &game->objects[i]->data.wall;
+    for (size_t i = 0; i < nrays; i++) {
+        tested += game->camera->hits.tested[i];
+    }
+
+    return (float) tested / (float) nrays;
+}
+
+static void render_walls(const struct game_t *const game) {
+    for (size_t i = 0; i < game->world.nwalls; i++) {
+        const struct wall_t *const wall = &game->world.walls[i];
 
         render_colored(game->renderer, wall->color, {
             SDL_RenderDrawLineF(game->renderer, wall->a.x, wall->a.y, wall->b.x, wall->b.y);
@@ -54,7 +105,8 @@ static void render_hud(const struct game_t *const restrict game, const SDL_Color
     static const struct vec_t pos = {.x = 10.0F, .y = 10.0F};
     static const char *const fmt =
             "fps: %" PRIu64 " | ticks: %" PRIu64 " | frames: %" PRIu64 " | pos: [%.2f, %.2f] | angle: %.0f | fov: %zu "
-            "| resmult: %zu | rays: %zu | px/ray: %.4f | light: %.1f | fisheye: %.2f";
+            "| resmult: %zu | rays: %zu | px/ray: %.4f | light: %.1f | fisheye: %.2f | threads: %zu "
+            "| index: %s | walls/ray: %.1f | recast: %zu | spans: %zu | draws: %zu";
 
     const size_t nrays = game->camera->fov * game->camera->resmult;
 
@@ -71,104 +123,179 @@ static void render_hud(const struct game_t *const restrict game, const SDL_Color
                       nrays,
                       (float) SCREEN_WIDTH / (float) nrays,
                       game->camera->lightmult,
-                      game->camera->fisheye);
+                      game->camera->fisheye,
+                      game->pool->nthreads,
+                      index_name(game),
+                      walls_per_ray(game),
+                      game->recast->cast,
+                      game->span->nruns,
+                      game->batch->calls);
     });
 }
 
 static void render_rays(const struct game_t *const restrict game, const SDL_Color color) {
     render_colored(game->renderer, color, {
+        const struct hits_t *const hits = &game->camera->hits;
+
         for (size_t i = 0; i < camera_nrays(game); i++) {
-            const struct ray_t *const ray = &game->camera->rays[i];
-            const struct intersection_t *const intersection = &ray->intersection;
+            if (hits->wall[i] != HITS_NONE) {
+                const struct vec_t pos = hits_pos(hits, &game->walls, i);
 
-            if (intersection->wall != NULL) {
-                SDL_RenderDrawLineF(game->renderer, ray->pos.x, ray->pos.y,
-                                    ray->intersection.pos.x, ray->intersection.pos.y);
+                SDL_RenderDrawLineF(game->renderer, hits->pos.x, hits->pos.y, pos.x, pos.y);
             }
         }
     });
 }
 
-static void render_3d(struct game_t *const game) {
+static void render_crosshair(const struct game_t *const game) {
+    filledCircleColor(game->renderer,
+                      (int16_t) game->center.x,
+                      (int16_t) game->center.y,
+                      3,
+                      color_to_int(COLOR_WHITE));
+
+    const size_t center_ray = camera_nrays(game) / 2;
+    const struct vec_t center_pos = vadd(game->center, (struct vec_t) {10.0F, 10.0F});
+
+    render_colored(game->renderer, COLOR_WHITE, {
+        render_printf(game->renderer, center_pos, "%.2f m",
+                      game->camera->hits.dist[center_ray] / 100.0F);
+    });
+}
+
+/**
+ * Gathers the hits of the rays into the stripes of the screen columns, then computes the geometry and the shade
+ * of every stripe in passes over whole arrays.
+ *
+ * @param game A pointer to the game_t struct representing the current game.
+ */
+static void shade_stripes(const struct game_t *const game) {
     const size_t nrays = camera_nrays(game);
-    const float width = SCREEN_WIDTH / (float) (nrays);
+    const float height_diff = game->camera->movement.crouch ? (float) CAMERA_CROUCH_HEIGHT_DELTA : 0.0F;
+    const struct hits_t *const hits = &game->camera->hits;
+    struct stripes_t *const stripes = game->stripes;
 
     for (size_t i = 0; i < nrays; i++) {
-        const struct ray_t *const ray = &game->camera->rays[i];
+        stripes->walls[i] = hits->wall[i] == HITS_NONE ? NULL : game->walls.walls[hits->wall[i]];
+        stripes->dist[i] = hits->dist[i];
+        stripes->correction[i] = game->camera->columns[i].correction;
+    }
 
-        if (ray->intersection.wall == NULL) {
-            continue;
-        }
+    stripes_shade(stripes, nrays, &game->colormap, WALL_SCALING_FACTOR, game->center.y - height_diff);
+}
 
-        static const float scaling_factor = 200000.0F;
+/**
+ * Merges the shaded stripes of the current frame into trapezoids and queues them for drawing.
+ *
+ * @param game A pointer to the game_t struct representing the current game.
+ * @param ncolumns The number of columns, whose stripes have been shaded.
+ */
+static void fill_spans(const struct game_t *const game, const size_t ncolumns) {
+    const struct stripes_t *const stripes = game->stripes;
+    const struct span_t *const span = game->span;
+
+    for (size_t i = 0; i < ncolumns; i++) {
+        span->columns[i] = (struct span_column_t) {
+                .wall = stripes->walls[i],
+                .top = stripes->top[i],
+                .bottom = stripes->top[i] + stripes->height[i],
+                .color = colormap_color(stripes->shade[i])
+        };
+    }
 
-        const float angle = vangle(ray->dir, game->camera->dir);
-        const float dist = ray->intersection.dist * (game->camera->fisheye + (1 - game->camera->fisheye) * cosf(angle));
-        const float height = 1.0F / dist * scaling_factor;
-        const float height_diff = game->camera->movement.crouch ? (float) CAMERA_CROUCH_HEIGHT_DELTA : 0.0F;
+    span_coalesce(game->span, ncolumns, SPAN_TOLERANCE, SPAN_COLOR_TOLERANCE);
 
-        const SDL_FRect stripe = {
-                .x = width * (float) i,
-                .y = game->center.y - height / 2.0F - height_diff,
-                .h = height,
-                .w = width
-        };
+    for (size_t i = 0; i < span->nruns; i++) {
+        const struct span_run_t *const run = &span->runs[i];
+        const struct span_column_t *const first = &span->columns[run->first];
+        const struct span_column_t *const last = &span->columns[run->last];
+        const struct column_t *const left = &game->camera->columns[run->first];
+        const struct column_t *const right = &game->camera->columns[run->last];
 
-        if (game->render_mode != RENDER_MODE_WIREFRAME) {
-            const float brightness = map(1.0F / powf(ray->intersection.dist, 2.0F), 0.0F, 0.00001F, 0.0F, 1.0F);
-            const SDL_Color color = change_brightness(ray->intersection.wall->color,
-                                                      brightness * game->camera->lightmult);
+        /* the edges run through the centers of the outer columns; extend them by half a column on either side */
+        const float half = run->last > run->first ? 0.5F / (float) (run->last - run->first) : 0.0F;
+        const float top = (last->top - first->top) * half;
+        const float bottom = (last->bottom - first->bottom) * half;
 
-            render_colored(game->renderer, color, {
-                SDL_RenderFillRectF(game->renderer, &stripe);
-            });
+        batch_fill_trapezoid(game->batch,
+                             left->x, first->top - top, first->bottom - bottom, first->color,
+                             right->x + right->w, last->top + top, last->bottom + bottom, last->color);
+    }
+}
+
+/**
+ * Queues the outlines of the stripes of the current frame.
+ *
+ * @param game A pointer to the game_t struct representing the current game.
+ * @param ncolumns The number of columns, whose stripes have been shaded.
+ */
+static void draw_outlines(const struct game_t *const game, const size_t ncolumns) {
+    const struct stripes_t *const stripes = game->stripes;
+    const struct hits_t *const hits = &game->camera->hits;
+
+    for (size_t i = 0; i < ncolumns; i++) {
+        const struct column_t *const column = &game->camera->columns[i];
+
+        if (stripes->walls[i] == NULL) {
             continue;
         }
 
-        render_colored(game->renderer, ray->intersection.wall->color, {
-            const float x = stripe.x + stripe.w;
-            const float y = stripe.y + stripe.h;
-
-            // top horizontal line
-            SDL_RenderDrawLineF(game->renderer,
-                                stripe.x,
-                                stripe.y,
-                                x,
-                                stripe.y);
-
-            // bottom horizontal line
-            SDL_RenderDrawLineF(game->renderer,
-                                stripe.x,
-                                y,
-                                x,
-                                y);
-
-            const float dist_a2 = vdist2(ray->intersection.pos, ray->intersection.wall->a);
-            const float dist_b2 = vdist2(ray->intersection.pos, ray->intersection.wall->b);
-
-            // vertical line; only at the adge of a wall
-            // this is a bad approximation, which works poorly in lower resolutions
-            // TODO: find a better threshold than stripe.w
-            if (fminf(dist_a2, dist_b2) <= stripe.w) {
-                SDL_RenderDrawLineF(game->renderer, stripe.x, stripe.y, stripe.x, y);
-            }
-        });
+        const SDL_FRect stripe = {
+                .x = column->x,
+                .y = stripes->top[i],
+                .h = stripes->height[i],
+                .w = column->w
+        };
+
+        const SDL_Color color = stripes->walls[i]->color;
+        const float x = stripe.x + stripe.w;
+        const float y = stripe.y + stripe.h;
+        const struct vec_t pos = hits_pos(hits, &game->walls, i);
+        const float dist_a2 = vdist2(pos, stripes->walls[i]->a);
+        const float dist_b2 = vdist2(pos, stripes->walls[i]->b);
+
+        // vertical line; only at the adge of a wall
+        // the sweep knows the exact edges of the visibility polygon; otherwise this is a bad approximation,
+        // which works poorly in lower resolutions
+        // TODO: find a better threshold than stripe.w
+        // drawn upwards, so that the batch joins it with the top line
+        if (game->index == INDEX_SWEEP ? hits->edge[i] : fminf(dist_a2, dist_b2) <= stripe.w) {
+            batch_draw_line(game->batch, stripe.x, y, stripe.x, stripe.y, color);
+        }
+
+        // top horizontal line
+        batch_draw_line(game->batch, stripe.x, stripe.y, x, stripe.y, color);
+
+        // bottom horizontal line
+        batch_draw_line(game->batch, stripe.x, y, x, y, color);
     }
+}
 
-    filledCircleColor(game->renderer,
-                      (int16_t) game->center.x,
-                      (int16_t) game->center.y,
-                      3,
-                      color_to_int(COLOR_WHITE));
+static void render_3d(struct game_t *const game) {
+    const size_t nrays = camera_nrays(game);
 
-    const struct ray_t *const center_ray = &game->camera->rays[camera_nrays(game) / 2];
-    const struct wall_t *const center_wall = center_ray->intersection.wall;
-    const struct vec_t center_pos = vadd(game->center, (struct vec_t) {10.0F, 10.0F});
+    shade_stripes(game);
 
-    render_colored(game->renderer, COLOR_WHITE, {
-        render_printf(game->renderer, center_pos, "%.2f m",
-                      center_wall == NULL ? INFINITY : center_ray->intersection.dist / 100.0F);
-    });
+    if (game->render_mode == RENDER_MODE_WIREFRAME) {
+        draw_outlines(game, nrays);
+    } else {
+        fill_spans(game, nrays);
+    }
+
+    batch_flush(game->batch, game->renderer);
+    render_crosshair(game);
+}
+
+/**
+ * Renders the walls projected to screen columns by project_walls(), filled without outlines.
+ *
+ * @param game A pointer to the game_t struct representing the current game.
+ */
+static void render_projected(struct game_t *const game) {
+    shade_stripes(game);
+    fill_spans(game, camera_nrays(game));
+    batch_flush(game->batch, game->renderer);
+    render_crosshair(game);
 }
 
 static void render_camera(const struct game_t *const restrict game, const SDL_Color camera, const SDL_Color direction) {
@@ -227,6 +354,85 @@ static void render_floor_and_ceiling(struct game_t *const game) {
     });
 }
 
+/**
+ * @brief A frame of the 3D view drawn into the software framebuffer on the worker pool.
+ */
+struct frame_t {
+    const struct game_t *game; /**< The game. */
+    Uint32 ceil; /**< The color of the ceiling, as a pixel. */
+    Uint32 floor; /**< The color of the floor, as a pixel. */
+    int horizon; /**< The first row of the floor. */
+};
+
+/**
+ * Fills the rows [top, bottom) of a column of the framebuffer with the ceiling above the horizon and the floor
+ * below it.
+ */
+static void draw_background(const struct frame_t *const frame, const int x, const int top, const int bottom) {
+    const int horizon = SDL_max(top, SDL_min(frame->horizon, bottom));
+
+    framebuffer_fill_column(frame->game->framebuffer, x, top, horizon, frame->ceil);
+    framebuffer_fill_column(frame->game->framebuffer, x, horizon, bottom, frame->floor);
+}
+
+/**
+ * Draws the screen columns [begin, end) of the 3D view into the framebuffer, writing every pixel exactly once.
+ */
+static void draw_columns(const void *const arg, const size_t begin, const size_t end) {
+    const struct frame_t *const frame = arg;
+    const struct game_t *const game = frame->game;
+    const struct stripes_t *const stripes = game->stripes;
+    const size_t nrays = camera_nrays(game);
+    const int rows = game->framebuffer->height;
+
+    for (size_t x = begin; x < end; x++) {
+        /* the stripe covering the center of the pixel, as SDL_RenderFillRectF() would have drawn it */
+        const size_t i = SDL_min((size_t) (((float) x + 0.5F) / game->camera->columns[0].w), nrays - 1);
+
+        if (stripes->walls[i] == NULL) {
+            draw_background(frame, (int) x, 0, rows);
+            continue;
+        }
+
+        const float y = stripes->top[i];
+        const int top = (int) constrain(ceilf(y - 0.5F), 0.0F, (float) rows);
+        const int bottom = (int) constrain(ceilf(y + stripes->height[i] - 0.5F), 0.0F, (float) rows);
+
+        draw_background(frame, (int) x, 0, top);
+        framebuffer_fill_column(game->framebuffer, (int) x, top, bottom, stripes->shade[i]);
+        draw_background(frame, (int) x, bottom, rows);
+    }
+}
+
+/**
+ * Renders the floor, the ceiling and the walls into the software framebuffer, split by screen columns across the
+ * worker pool, and uploads it to the renderer in one go. Falls back to the renderer if the framebuffer cannot be
+ * presented.
+ *
+ * @param game A pointer to the game_t struct representing the current game.
+ */
+static void render_software(struct game_t *const game) {
+    const float height_diff = game->camera->movement.crouch ? (float) CAMERA_CROUCH_HEIGHT_DELTA : 0.0F;
+
+    const struct frame_t frame = {
+            .game = game,
+            .ceil = framebuffer_color(game->ceil_color),
+            .floor = framebuffer_color(game->floor_color),
+            .horizon = (int) ceilf(game->center.y - height_diff - 0.5F)
+    };
+
+    shade_stripes(game);
+    pool_run(game->pool, (size_t) game->framebuffer->width, FRAMEBUFFER_TILE_SIZE, draw_columns, &frame);
+
+    if (framebuffer_present(game->framebuffer, game->renderer, game->pool) != 0) {
+        render_floor_and_ceiling(game);
+        render_3d(game);
+        return;
+    }
+
+    render_crosshair(game);
+}
+
 static void update_player_position(const struct game_t *const game) {
     struct vec_t dirvect = vmul(game->camera->dir, speed_coeff(game, game->camera->speed));
 
@@ -257,39 +463,232 @@ static float get_ray_angle(const struct game_t *const game, const size_t rayno)
     return radians((float) rayno / resmult - fov / 2.0F + angle);
 }
 
-static void update_ray_intersections(const struct game_t *const game) {
-    for (size_t i = 0; i < camera_nrays(game); i++) {
-        struct ray_t ray;
-        struct intersection_t ray_int = {0};
-        float min_dist = INFINITY;
+/**
+ * Calculates the direction of a ray by rotating the offset of its column by the heading of the camera.
+ *
+ * @param game A pointer to the game_t struct representing the current game.
+ * @param rayno The index of the ray.
+ * @return The direction of the ray, as a unit vector.
+ */
+static inline struct vec_t get_ray_dir(const struct game_t *const game, const size_t rayno) {
+    const struct vec_t offset = game->camera->columns[rayno].offset;
+    const struct vec_t heading = game->camera->dir;
 
-        ray.pos = game->camera->pos;
-        ray.dir = vfromangle(get_ray_angle(game, i));
+    return (struct vec_t) {
+            offset.x * heading.x - offset.y * heading.y,
+            offset.x * heading.y + offset.y * heading.x
+    };
+}
 
-        for (size_t j = 0; j < game->nobjects; j++) {
-            if (game->objects[j]->type != WALL) {
-                continue;
-            }
+/**
+ * @brief A range of rays cast on the worker pool.
+ */
+struct fan_t {
+    const struct game_t *game; /**< The game. */
+    size_t first; /**< The index of the first ray of the range. */
+};
+
+static void cast_rays(const void *const arg, const size_t begin, const size_t end) {
+    const struct fan_t *const fan = arg;
+    const struct game_t *const game = fan->game;
+    const struct hits_t *const hits = &game->camera->hits;
+    const struct vec_t pos = hits->pos;
+
+    for (size_t k = begin; k < end; k++) {
+        const size_t i = fan->first + k;
+        const struct vec_t dir = get_ray_dir(game, i);
+        size_t hit = RAY_NO_HIT;
+        size_t tested = 0;
+        float dist = INFINITY;
+
+        switch (game->index) {
+            case INDEX_LINEAR:
+                hit = ray_cast(&game->walls, 0, game->walls.count, pos, dir, &dist);
+                tested = game->walls.count;
+                break;
+            case INDEX_GRID:
+                hit = grid_cast(&game->grid, pos, dir, &dist, &tested);
+                break;
+            case INDEX_BVH:
+                hit = bvh_cast(&game->bvh, pos, dir, &dist, &tested);
+                break;
+            case INDEX_BSP:
+                /* the BSP tree casts all rays at once, see cast_fan() */
+                break;
+            case INDEX_SECTOR:
+                /* only reached if the camera is outside all sectors, see cast_fan() */
+                hit = ray_cast(&game->walls, 0, game->walls.count, pos, dir, &dist);
+                tested = game->walls.count;
+                break;
+            case INDEX_SWEEP:
+                /* the sweep casts all rays at once, see cast_fan() */
+                break;
+            case INDEX_FRUSTUM:
+                /* the culling pass was run over the range only */
+                hit = cull_cast(game->cull, k, pos, dir, &dist, &tested);
+                break;
+        }
 
-            const struct wall_t *const wall = &game->objects[j]->data.wall;
-            struct vec_t intersection;
+        hits->dir[i] = dir;
+        hits->dist[i] = hit == RAY_NO_HIT ? INFINITY : dist;
+        hits->wall[i] = hit == RAY_NO_HIT ? HITS_NONE : (uint32_t) hit;
+        hits->tested[i] = (uint32_t) tested;
+        hits->edge[i] = false;
+    }
+}
 
-            if (!ray_intersection(&ray, wall, &intersection)) {
-                continue;
-            }
+/**
+ * Sets the direction of the rays in a range, for the indexes which cast all rays at once.
+ *
+ * @param game A pointer to the game_t struct representing the current game.
+ * @param begin The index of the first ray.
+ * @param end The index one past the last ray.
+ */
+static void aim_rays(const struct game_t *const game, const size_t begin, const size_t end) {
+    for (size_t i = begin; i < end; i++) {
+        game->camera->hits.dir[i] = get_ray_dir(game, i);
+    }
+}
+
+/**
+ * Casts the rays in a range with the current spatial index, or projects the walls onto them in the projected
+ * render mode.
+ *
+ * @param game A pointer to the game_t struct representing the current game.
+ * @param begin The index of the first ray.
+ * @param end The index one past the last ray.
+ */
+static void cast_fan(const struct game_t *const game, const size_t begin, const size_t end) {
+    const struct hits_t hits = hits_slice(&game->camera->hits, begin, end);
+    const size_t nrays = end - begin;
+    const float angle = get_ray_angle(game, begin);
+    const float step = radians(1.0F / (float) game->camera->resmult);
+    const struct fan_t fan = {.game = game, .first = begin};
+
+    /* the projected renderer draws the walls in the view wedge front to back instead of casting rays */
+    if (game->render_mode == RENDER_MODE_PROJECTED) {
+        aim_rays(game, begin, end);
+
+        /* a failed pass shows no walls rather than those of the last frame */
+        if (cull_walls(game->cull, &game->walls, game->camera->pos, nrays, angle, step, CULL_VIEW_DISTANCE) != 0 ||
+            project_walls(game->project, game->cull, &game->walls, &hits) != 0) {
+            hits_clear(&hits);
+        }
 
-            const float dist = vdist(ray.pos, intersection);
+        return;
+    }
+
+    switch (game->index) {
+        case INDEX_LINEAR:
+        case INDEX_GRID:
+        case INDEX_BVH:
+            break;
 
-            if (dist < min_dist) {
-                ray_int.pos = intersection;
-                ray_int.wall = wall;
-                min_dist = ray_int.dist = dist;
+        case INDEX_BSP:
+            aim_rays(game, begin, end);
+            bsp_cast_rays(&game->bsp, &hits, angle, step);
+            return;
+
+        case INDEX_SECTOR:
+            aim_rays(game, begin, end);
+
+            if (sector_cast_rays(&game->sectors, &hits, angle, step) > 0) {
+                return;
             }
-        }
+            break;
+
+        case INDEX_SWEEP:
+            aim_rays(game, begin, end);
+            sweep_cast_rays(game->sweep, &game->walls, &hits, angle, step);
+            return;
+
+        case INDEX_FRUSTUM:
+            cull_walls(game->cull, &game->walls, game->camera->pos, nrays, angle, step, CULL_VIEW_DISTANCE);
+            break;
+    }
+
+    pool_run(game->pool, nrays, RAYCAST_TILE_SIZE, cast_rays, &fan);
+}
+
+/**
+ * Works out which rays have to be cast again since the last frame. Rays are reused if the camera, the spatial
+ * index and the render mode did not change; if the camera only turned by a whole number of rays, the rays are
+ * shifted and only the newly exposed ones are cast.
+ *
+ * @param game A pointer to the game_t struct representing the current game.
+ * @param begin Set to the index of the first ray to cast.
+ * @param end Set to the index one past the last ray to cast.
+ */
+static void reuse_rays(const struct game_t *const game, size_t *const begin, size_t *const end) {
+    const struct recast_t *const last = game->recast;
+    const struct camera_t *const camera = game->camera;
+    const size_t nrays = camera_nrays(game);
+
+    *begin = 0;
+    *end = nrays;
+
+    if (!last->valid || !isclose(last->pos.x, camera->pos.x) || !isclose(last->pos.y, camera->pos.y) ||
+        last->fov != camera->fov ||
+        last->resmult != camera->resmult || last->index != (int) game->index ||
+        last->render_mode != (int) game->render_mode) {
+        return;
+    }
+
+    /* the ray i of this frame was the ray i + shift of the last one */
+    const float delta = fmodf(camera->angle - last->angle + 540.0F, 360.0F) - 180.0F;
+    const float shift = roundf(delta * (float) camera->resmult);
+
+    if (fabsf(delta * (float) camera->resmult - shift) > RECAST_EPSILON || !(fabsf(shift) < (float) nrays)) {
+        return;
+    }
+
+    const size_t count = (size_t) fabsf(shift);
+
+    if (shift > 0.0F) {
+        hits_move(&camera->hits, 0, count, nrays - count);
+        *begin = nrays - count;
+    } else {
+        hits_move(&camera->hits, count, 0, nrays - count);
+        *end = count;
+    }
+}
+
+static void update_ray_intersections(const struct game_t *const game) {
+    struct recast_t *const last = game->recast;
+    struct hits_t *const hits = &game->camera->hits;
+    const size_t nrays = camera_nrays(game);
+    size_t begin;
+    size_t end;
 
-        ray.intersection = ray_int;
-        game->camera->rays[i] = ray;
+    reuse_rays(game, &begin, &end);
+    hits->pos = game->camera->pos;
+
+    if (begin < end) {
+        const struct hits_t cast = hits_slice(hits, begin, end);
+
+        cast_fan(game, begin, end);
+        hits_resolve(&cast, &game->walls);
     }
+
+    /* the rays on the seams compare their walls with rays which were not cast this frame */
+    if (game->index == INDEX_SWEEP && begin > 0 && begin < nrays) {
+        hits->edge[begin] = hits->wall[begin] != hits->wall[begin - 1];
+    }
+
+    if (game->index == INDEX_SWEEP && end > 0 && end < nrays) {
+        hits->edge[end] = hits->wall[end] != hits->wall[end - 1];
+    }
+
+    *last = (struct recast_t) {
+            .pos = game->camera->pos,
+            .angle = game->camera->angle,
+            .fov = game->camera->fov,
+            .resmult = game->camera->resmult,
+            .index = (int) game->index,
+            .render_mode = (int) game->render_mode,
+            .cast = end - begin,
+            .valid = true
+    };
 }
 
 void camera_update_angle(struct game_t *const game, float angle) {
@@ -303,6 +702,34 @@ void camera_update_angle(struct game_t *const game, float angle) {
     game->camera->dir = vfromangle(radians(game->camera->angle));
 }
 
+int camera_update_columns(struct game_t *const game) {
+    const size_t nrays = camera_nrays(game);
+    const float width = SCREEN_WIDTH / (float) nrays;
+    const float fisheye = game->camera->fisheye;
+
+    if (game->camera->hits.count != nrays) {
+        if (hits_resize(&game->camera->hits, nrays) != 0) {
+            logger_print(LOG_LEVEL_ERROR, "unable to resize the hit buffer");
+            return -1;
+        }
+
+        /* the hits of the last frame are lost */
+        game->recast->valid = false;
+    }
+
+    for (size_t i = 0; i < nrays; i++) {
+        const float angle = radians((float) i / (float) game->camera->resmult - (float) game->camera->fov / 2.0F);
+        struct column_t *const column = &game->camera->columns[i];
+
+        column->offset = vfromangle(angle);
+        column->correction = fisheye + (1 - fisheye) * column->offset.x;
+        column->x = width * (float) i;
+        column->w = width;
+    }
+
+    return 0;
+}
+
 void tick(struct game_t *const game) {
     const uint64_t ticks = SDL_GetTicks64();
     const uint64_t tick_delta = ticks - game->ticks;
@@ -339,6 +766,15 @@ void render(struct game_t *const game) {
             render_floor_and_ceiling(game);
             render_3d(game);
             break;
+
+        case RENDER_MODE_PROJECTED:
+            render_floor_and_ceiling(game);
+            render_projected(game);
+            break;
+
+        case RENDER_MODE_SOFTWARE:
+            render_software(game);
+            break;
     }
 
     render_visual_fps(game, COLOR_WHITE, COLOR_BLACK);
@@ -356,35 +792,205 @@ void update(const struct game_t *const game) {
     update_ray_intersections(game);
 }
 
-struct game_t *game_create(void) {
-    static struct game_t game = {0};
-    static struct ray_t rays[FOV_MAX * RESMULT_MAX] = {0};
-    static struct camera_t camera = {0};
-    static struct wobject_t *objects[WORLD_NOBJECTS_MAX] = {0};
-    static struct wobject_t objects_data[WORLD_NOBJECTS_MAX] = {0};
+/**
+ * Builds the spatial indexes over the walls in the game world.
+ *
+ * @param game A pointer to the game_t struct representing the current game.
+ * @return 0 on success, -1 on error. Indexes built before the error are not destroyed.
+ */
+static int build_indexes(struct game_t *const game, const struct worldbin_bvh_t *const prebuilt) {
+    if (grid_build(&game->grid, &game->walls) != 0) {
+        logger_print(LOG_LEVEL_ERROR, "unable to build grid");
+        return -1;
+    }
+
+    logger_printf(LOG_LEVEL_DEBUG, "grid: %zu x %zu cells of %.1f units, %.2f references per wall\n",
+                  game->grid.cols, game->grid.rows, game->grid.cell_size,
+                  (float) game->grid.table.count / (float) SDL_max(game->grid.nwalls, 1));
 
-    for (size_t i = 0; i < WORLD_NOBJECTS_MAX; i++) {
-        objects[i] = &objects_data[i];
+    /* a BVH restored from a compiled world may be rejected, which is no reason not to build it */
+    if ((prebuilt == NULL || bvh_restore(&game->bvh, &game->walls, prebuilt->nodes, prebuilt->nnodes,
+                                         prebuilt->ids) != 0) &&
+        bvh_build(&game->bvh, &game->walls, game->pool) != 0) {
+        logger_print(LOG_LEVEL_ERROR, "unable to build BVH");
+        return -1;
+    }
+
+    logger_printf(LOG_LEVEL_DEBUG, "bvh: %zu nodes, %zu leaves, depth %zu\n",
+                  game->bvh.nnodes, game->bvh.nleaves, game->bvh.depth);
+
+    if (BSP_ENABLED) {
+        if (bsp_build(&game->bsp, &game->walls) != 0) {
+            logger_print(LOG_LEVEL_ERROR, "unable to build BSP tree");
+            return -1;
+        }
+
+        logger_printf(LOG_LEVEL_INFO, "bsp: %zu walls, %zu splits, %zu fragments, %zu nodes, depth %zu\n",
+                      game->bsp.stats.walls, game->bsp.stats.splits, game->bsp.stats.fragments,
+                      game->bsp.stats.nodes, game->bsp.stats.depth);
+    }
+
+    if (sector_graph_build(&game->sectors, &game->world, &game->walls) != 0) {
+        logger_print(LOG_LEVEL_ERROR, "unable to build sector graph");
+        return -1;
     }
 
+    logger_printf(LOG_LEVEL_DEBUG, "sectors: %zu sectors, %zu wall references\n",
+                  game->sectors.nsectors, game->sectors.table.count);
+
+    if (cull_create(game->cull, game->walls.count, FOV_MAX * RESMULT_MAX) != 0) {
+        logger_print(LOG_LEVEL_ERROR, "unable to create culling pass");
+        return -1;
+    }
+
+    if (project_create(game->project, game->walls.count) != 0) {
+        logger_print(LOG_LEVEL_ERROR, "unable to create projection");
+        return -1;
+    }
+
+    if (sweep_create(game->sweep, game->walls.count) != 0) {
+        logger_print(LOG_LEVEL_ERROR, "unable to create sweep");
+        return -1;
+    }
+
+    if (span_create(game->span, FOV_MAX * RESMULT_MAX) != 0) {
+        logger_print(LOG_LEVEL_ERROR, "unable to create span buffers");
+        return -1;
+    }
+
+    if (stripes_create(game->stripes, FOV_MAX * RESMULT_MAX) != 0) {
+        logger_print(LOG_LEVEL_ERROR, "unable to create stripe buffers");
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Destroys the spatial indexes over the walls in the game world.
+ *
+ * @param game A pointer to the game_t struct representing the current game.
+ */
+static void destroy_indexes(struct game_t *const game) {
+    stripes_destroy(game->stripes);
+    span_destroy(game->span);
+    sweep_destroy(game->sweep);
+    project_destroy(game->project);
+    cull_destroy(game->cull);
+    sector_graph_destroy(&game->sectors);
+    bsp_destroy(&game->bsp);
+    bvh_destroy(&game->bvh);
+    grid_destroy(&game->grid);
+}
+
+struct game_t *game_create(const char *const world, const size_t budget) {
+    static struct game_t game = {0};
+    static struct column_t columns[FOV_MAX * RESMULT_MAX] = {0};
+    static struct camera_t camera = {0};
+    static struct pool_t pool;
+    static struct cull_t cull;
+    static struct project_t project;
+    static struct sweep_t sweep;
+    static struct recast_t recast;
+    static struct batch_t batch;
+    static struct span_t span;
+    static struct stripes_t stripes;
+    static struct framebuffer_t framebuffer;
+
     game.center = (struct vec_t) {(float) SCREEN_WIDTH / 2.0F, (float) SCREEN_HEIGHT / 2.0F};
 
     game.camera = &camera;
     game.camera->fov = CAMERA_FOV;
     game.camera->resmult = CAMERA_RESMULT;
     game.camera->speed = CAMERA_MOVEMENT_SPEED;
-    game.camera->rays = rays;
     game.camera->pos = game.center;
     game.camera->lightmult = CAMERA_LIGHTMULT;
     game.camera->fisheye = CAMERA_FISHEYE;
+    game.camera->columns = columns;
+    game.recast = &recast;
+
+    if (camera_update_columns(&game) != 0) {
+        return NULL;
+    }
 
     game.render_mode = RENDER_MODE_UNTEXTURED;
+    game.index = INDEX_BVH;
     game.ceil_color = (SDL_Color) CEIL_COLOR;
     game.floor_color = (SDL_Color) FLOOR_COLOR;
-    game.objects = objects;
     game.fullscreen = SCREEN_FLAGS & SDL_WINDOW_FULLSCREEN;
 
-    assert(load_world(WORLD_SPEC_FILE, game.objects, &game.nobjects) == 0);
+    /* the pool also parses the world specification */
+    if (pool_create(&pool, RAYCAST_THREADS) != 0) {
+        logger_print(LOG_LEVEL_ERROR, "unable to create worker pool");
+        hits_destroy(&game.camera->hits);
+        return NULL;
+    }
+
+    char compiled[PATH_MAX];
+    uint64_t hash = 0;
+    struct worldbin_bvh_t prebuilt;
+    const bool hashed = snprintf(compiled, sizeof compiled, "%s%s", world, WORLD_COMPILED_SUFFIX) <
+                        (int) sizeof compiled && worldbin_hash(world, &hash) == 0;
+    const bool mapped = hashed && worldbin_load(compiled, hash, &game.world, &prebuilt) == 0;
+
+    if (!mapped && load_world(world, &game.world, budget, &pool) != 0) {
+        logger_printf(LOG_LEVEL_ERROR, "unable to load world '%s'\n", world);
+        pool_destroy(&pool);
+        hits_destroy(&game.camera->hits);
+        return NULL;
+    }
+
+    /* the walls are optimized before the compiled world is written, so a mapped world needs no optimization */
+    if (WORLD_OPTIMIZE && !mapped && optimize_world(&game.world, NULL) != 0) {
+        logger_print(LOG_LEVEL_ERROR, "unable to optimize world");
+        world_destroy(&game.world);
+        pool_destroy(&pool);
+        hits_destroy(&game.camera->hits);
+        return NULL;
+    }
+
+    if (wall_table_build(&game.walls, &game.world) != 0) {
+        logger_print(LOG_LEVEL_ERROR, "unable to build wall table");
+        world_destroy(&game.world);
+        pool_destroy(&pool);
+        hits_destroy(&game.camera->hits);
+        return NULL;
+    }
+
+    if (colormap_build(&game.colormap, &game.world, game.camera->lightmult) != 0) {
+        logger_print(LOG_LEVEL_ERROR, "unable to build colormap");
+        wall_table_destroy(&game.walls);
+        world_destroy(&game.world);
+        pool_destroy(&pool);
+        hits_destroy(&game.camera->hits);
+        return NULL;
+    }
+
+    game.pool = &pool;
+    game.cull = &cull;
+    game.project = &project;
+    game.sweep = &sweep;
+    game.batch = &batch;
+    game.span = &span;
+    game.stripes = &stripes;
+    game.framebuffer = &framebuffer;
+    logger_printf(LOG_LEVEL_INFO, "casting rays with %zu threads\n", pool.nthreads);
+
+    if (build_indexes(&game, mapped ? &prebuilt : NULL) != 0) {
+        destroy_indexes(&game);
+        pool_destroy(&pool);
+        colormap_destroy(&game.colormap);
+        wall_table_destroy(&game.walls);
+        world_destroy(&game.world);
+        hits_destroy(&game.camera->hits);
+        return NULL;
+    }
+
+    /* a failure only costs the time to parse the specification again next time */
+    if (hashed && !mapped) {
+        worldbin_save(compiled, hash, &game.world, &game.bvh);
+    }
+
     camera_update_angle(&game, CAMERA_HEADING);
 
     return &game;
@@ -406,12 +1012,18 @@ int game_init(struct game_t *const game) {
     logger_printf(LOG_LEVEL_INFO, "created SDL window '%s' (%d x %d px)\n", SCREEN_TITLE, SCREEN_WIDTH, SCREEN_HEIGHT);
     game->renderer = SDL_CreateRenderer(game->window, -1, SDL_RENDERER_ACCELERATED);
 
+    /* machines without a GPU have no accelerated renderer, but SDL can always render in software */
+    if (game->renderer == NULL) {
+        logger_printf(LOG_LEVEL_WARN, "no accelerated renderer: %s\n", SDL_GetError());
+        game->renderer = SDL_CreateRenderer(game->window, -1, SDL_RENDERER_SOFTWARE);
+    }
+
     if (game->renderer == NULL) {
         logger_print(LOG_LEVEL_ERROR, "unable to create SDL renderer");
         return -1;
     }
 
-    SDL_RendererInfo info;
+    SDL_RendererInfo info = {0};
 
     if (SDL_GetRendererInfo(game->renderer, &info) == 0) {
         logger_printf(LOG_LEVEL_INFO, "using renderer '%s'\n", info.name);
@@ -419,11 +1031,30 @@ int game_init(struct game_t *const game) {
         logger_printf(LOG_LEVEL_ERROR, "SDL_GetRendererInfo: %s\n", SDL_GetError());
     }
 
+    if (framebuffer_create(game->framebuffer, game->renderer, SCREEN_WIDTH, SCREEN_HEIGHT) != 0) {
+        logger_print(LOG_LEVEL_ERROR, "unable to create software framebuffer");
+        return -1;
+    }
+
+    /* without acceleration, a single upload is much cheaper than thousands of primitives */
+    if (info.flags & SDL_RENDERER_SOFTWARE && game->render_mode == RENDER_MODE_UNTEXTURED) {
+        logger_print(LOG_LEVEL_INFO, "software renderer, drawing into a framebuffer");
+        game->render_mode = RENDER_MODE_SOFTWARE;
+    }
+
     SDL_SetRelativeMouseMode(SDL_TRUE);
     return 0;
 }
 
 void game_destroy(struct game_t *const game) {
+    pool_destroy(game->pool);
+    destroy_indexes(game);
+    colormap_destroy(&game->colormap);
+    wall_table_destroy(&game->walls);
+    world_destroy(&game->world);
+    hits_destroy(&game->camera->hits);
+    batch_destroy(game->batch);
+    framebuffer_destroy(game->framebuffer);
     SDL_DestroyRenderer(game->renderer);
     SDL_DestroyWindow(game->window);
 }
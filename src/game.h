@@ -8,20 +8,47 @@
 
 #include <SDL2/SDL.h>
 
+#include "batch.h"
+#include "bsp.h"
+#include "bvh.h"
+#include "colormap.h"
 #include "conf.h"
+#include "cull.h"
+#include "framebuffer.h"
+#include "grid.h"
+#include "hits.h"
 #include "menu.h"
+#include "pool.h"
+#include "project.h"
+#include "ray.h"
+#include "sector.h"
+#include "span.h"
+#include "stripes.h"
+#include "sweep.h"
 #include "util.h"
 #include "vector.h"
 #include "world.h"
 
 
+/**
+ * @brief The projection of a screen column, which only depends on the field of view, the resolution and the
+ *        fish-eye correction of the camera.
+ */
+struct column_t {
+    struct vec_t offset; /**< The direction of the ray of the column relative to the camera, as a unit vector. */
+    float correction; /**< The factor applied to the distance of a hit for the fish-eye correction. */
+    float x; /**< The left edge of the column on the screen. */
+    float w; /**< The width of the column on the screen. */
+};
+
 /**
  * @brief Structure representing a camera in the game.
  */
 struct camera_t {
     struct vec_t pos; /**< Position of the camera. */
     struct vec_t dir; /**< Direction the camera is facing. */
-    struct ray_t *rays; /**< Array of rays cast from the camera. */
+    struct hits_t hits; /**< The rays cast from the camera and the walls they hit, one per column. */
+    struct column_t *columns; /**< The projection of every ray to the screen, see camera_update_columns(). */
     struct {
         bool forward, backward, left, right, crouch; /**< Boolean flags indicating which movement keys are pressed. */
     } movement;
@@ -33,6 +60,22 @@ struct camera_t {
     float fisheye; /**< The fish-eye correction factor for the camera. */
 };
 
+/**
+ * @brief The state the rays of the camera were last cast for, used to skip or shorten the next cast.
+ *
+ * Anything which changes the walls must clear the valid flag, so that all rays are cast again.
+ */
+struct recast_t {
+    struct vec_t pos; /**< The position of the camera. */
+    float angle; /**< The angle (in degrees) of the camera. */
+    size_t fov; /**< The field of view (in degrees) of the camera. */
+    size_t resmult; /**< The resolution multiplier of the camera. */
+    int index; /**< The spatial index used to cast the rays. */
+    int render_mode; /**< The render mode. */
+    size_t cast; /**< The number of rays cast in the last frame. */
+    bool valid; /**< Whether the rays hold the result of a cast for this state. */
+};
+
 /**
  * @brief Structure representing the game.
  */
@@ -40,9 +83,23 @@ struct game_t {
     SDL_Renderer *renderer; /**< The SDL renderer for the game. */
     SDL_Window *window; /**< The SDL window for the game. */
     struct camera_t *camera; /**< The camera used for rendering the game. */
-    struct wobject_t **objects; /**< The objects in the game world. */
+    struct world_t world; /**< The objects in the game world, in one pool per type. */
+    struct wall_table_t walls; /**< Packed copy of the walls in the game world used for ray casting. */
+    struct grid_t grid; /**< Uniform grid over the walls in the game world. */
+    struct bvh_t bvh; /**< Bounding volume hierarchy over the walls in the game world. */
+    struct bsp_t bsp; /**< BSP tree over the walls in the game world; empty unless BSP_ENABLED is set. */
+    struct sector_graph_t sectors; /**< The sectors of the game world connected by portals; may be empty. */
+    struct colormap_t colormap; /**< The shades of the colors of the walls in the game world. */
+    struct cull_t *cull; /**< The walls in the view wedge of the current frame. */
+    struct project_t *project; /**< The walls of the current frame projected to screen columns. */
+    struct sweep_t *sweep; /**< Buffers of the angular sweep over the walls in the game world. */
+    struct recast_t *recast; /**< The state the rays were last cast for. */
+    struct batch_t *batch; /**< The command buffer for the columns of the 3D view. */
+    struct span_t *span; /**< The wall stripes of the 3D view merged into trapezoids. */
+    struct stripes_t *stripes; /**< The wall stripes of the 3D view, shaded in passes over arrays. */
+    struct framebuffer_t *framebuffer; /**< The software framebuffer for the columns of the 3D view. */
+    struct pool_t *pool; /**< The worker pool used for ray casting. */
     struct vec_t center; /**< The center of the game window. */
-    size_t nobjects; /**< The number of objects in the game world. */
     uint64_t fps; /**< The current frames per second (FPS) of the game. */
     uint64_t frames; /**< The total number of frames rendered by the game. */
     uint64_t newframes; /**< The number of frames rendered by the game since the last polling event. */
@@ -50,8 +107,11 @@ struct game_t {
     SDL_Color ceil_color; /**< The color of the ceiling/sky. */
     SDL_Color floor_color; /**< The color of the floor/ground. */
     enum {
-        RENDER_MODE_FLAT, RENDER_MODE_WIREFRAME, RENDER_MODE_UNTEXTURED
+        RENDER_MODE_FLAT, RENDER_MODE_WIREFRAME, RENDER_MODE_UNTEXTURED, RENDER_MODE_PROJECTED, RENDER_MODE_SOFTWARE
     } render_mode; /**< The current render mode. */
+    enum {
+        INDEX_LINEAR, INDEX_GRID, INDEX_BVH, INDEX_BSP, INDEX_SECTOR, INDEX_SWEEP, INDEX_FRUSTUM
+    } index; /**< The spatial index used to find the walls hit by rays. */
     bool quit; /**< Boolean flag indicating whether the game should quit. */
     bool paused; /**< Boolean flag indicating whether the game is paused. */
     bool fullscreen; /**< Boolean flag indicating whether the game is in fullscreen mode. */
@@ -66,6 +126,16 @@ struct game_t {
  */
 void camera_update_angle(struct game_t *game, float angle);
 
+/**
+ * @brief Rebuilds the projection table of the camera and resizes its hit buffer to the number of rays. Must be
+ *        called whenever the field of view, the resolution multiplier or the fish-eye correction factor changes.
+ *
+ * @param game The game instance to update.
+ * @return 0 on success, -1 if the hit buffer could not be resized (the projection table and the hit buffer are
+ *         left unchanged in this case).
+ */
+int camera_update_columns(struct game_t *game);
+
 /**
  * @brief Update the FPS, frames, and ticks counters.
  *
@@ -89,10 +159,12 @@ void update(const struct game_t *game);
 
 /**
  * @brief Creates a new game by allocating memory and setting default values.
- * @return A pointer to the newly created game instance.
+ * @param world The path to the world specification to load.
+ * @param budget The memory budget for loading the world in bytes, see WORLD_MEMORY_BUDGET.
+ * @return A pointer to the newly created game instance, or NULL on error.
  * @note The game instance and its members are statically allocated. Do NOT pass them to free(3).
  */
-struct game_t *game_create(void);
+struct game_t *game_create(const char *world, size_t budget);
 
 /**
  * @brief Initializes the game by creating the SDL window and renderer.
@@ -102,7 +174,7 @@ struct game_t *game_create(void);
 int game_init(struct game_t *game);
 
 /**
- * @brief Destroys the SDL window and renderer.
+ * @brief Destroys the SDL window and renderer, stops the worker threads and frees the memory owned by the game.
  * @param game The game instance to destroy.
  */
 void game_destroy(struct game_t *game);
@@ -0,0 +1,304 @@
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include "conf.h"
+#include "logger.h"
+#include "math.h"
+
+#include "grid.h"
+
+
+/**
+ * @brief State of a 2D DDA walk through the cells of a grid.
+ */
+struct dda_t {
+    size_t col; /**< The column of the current cell. */
+    size_t row; /**< The row of the current cell. */
+    int step_col; /**< -1 or 1, the direction of the walk along the x-axis. */
+    int step_row; /**< -1 or 1, the direction of the walk along the y-axis. */
+    float t_max_x; /**< The ray parameter at which the walk crosses the next vertical cell boundary. */
+    float t_max_y; /**< The ray parameter at which the walk crosses the next horizontal cell boundary. */
+    float t_delta_x; /**< The ray parameter needed to cross a whole cell along the x-axis. */
+    float t_delta_y; /**< The ray parameter needed to cross a whole cell along the y-axis. */
+};
+
+
+static size_t cell_coord(const float value, const float min, const float cell_size, const size_t count) {
+    const float cell = floorf((value - min) / cell_size);
+
+    if (cell < 0.0F) {
+        return 0;
+    }
+
+    if (cell >= (float) count) {
+        return count - 1;
+    }
+
+    return (size_t) cell;
+}
+
+/**
+ * @brief Clips the ray pos + t * dir to the bounding box of the grid.
+ * @return true if the ray passes through the grid, false otherwise.
+ */
+static bool clip_ray(const struct grid_t *const grid,
+                     const struct vec_t pos,
+                     const struct vec_t dir,
+                     float *const restrict t_enter,
+                     float *const restrict t_exit) {
+    const float pos_axes[2] = {pos.x, pos.y};
+    const float dir_axes[2] = {dir.x, dir.y};
+    const float min_axes[2] = {grid->min.x, grid->min.y};
+    const float max_axes[2] = {grid->max.x, grid->max.y};
+
+    for (size_t axis = 0; axis < 2; axis++) {
+        if (isclose(dir_axes[axis], 0.0F)) {
+            if (pos_axes[axis] < min_axes[axis] || pos_axes[axis] > max_axes[axis]) {
+                return false;
+            }
+
+            continue;
+        }
+
+        float t0 = (min_axes[axis] - pos_axes[axis]) / dir_axes[axis];
+        float t1 = (max_axes[axis] - pos_axes[axis]) / dir_axes[axis];
+
+        if (t0 > t1) {
+            const float tmp = t0;
+            t0 = t1;
+            t1 = tmp;
+        }
+
+        *t_enter = fmaxf(*t_enter, t0);
+        *t_exit = fminf(*t_exit, t1);
+    }
+
+    return *t_enter <= *t_exit;
+}
+
+static void dda_init(struct dda_t *const restrict dda,
+                     const struct grid_t *const restrict grid,
+                     const struct vec_t pos,
+                     const struct vec_t dir,
+                     const float t_enter) {
+    const struct vec_t start = vadd(pos, vmul(dir, t_enter));
+
+    dda->col = cell_coord(start.x, grid->min.x, grid->cell_size, grid->cols);
+    dda->row = cell_coord(start.y, grid->min.y, grid->cell_size, grid->rows);
+    dda->step_col = dir.x < 0.0F ? -1 : 1;
+    dda->step_row = dir.y < 0.0F ? -1 : 1;
+
+    if (isclose(dir.x, 0.0F)) {
+        dda->t_max_x = INFINITY;
+        dda->t_delta_x = INFINITY;
+    } else {
+        const float edge = grid->min.x + (float) (dda->col + (dda->step_col > 0)) * grid->cell_size;
+        dda->t_max_x = (edge - pos.x) / dir.x;
+        dda->t_delta_x = grid->cell_size / fabsf(dir.x);
+    }
+
+    if (isclose(dir.y, 0.0F)) {
+        dda->t_max_y = INFINITY;
+        dda->t_delta_y = INFINITY;
+    } else {
+        const float edge = grid->min.y + (float) (dda->row + (dda->step_row > 0)) * grid->cell_size;
+        dda->t_max_y = (edge - pos.y) / dir.y;
+        dda->t_delta_y = grid->cell_size / fabsf(dir.y);
+    }
+}
+
+/**
+ * @brief Moves the walk to the next cell.
+ * @return false if the walk has left the grid, true otherwise.
+ */
+static bool dda_step(struct dda_t *const restrict dda, const struct grid_t *const restrict grid) {
+    if (dda->t_max_x < dda->t_max_y) {
+        if ((dda->step_col < 0 && dda->col == 0) || (dda->step_col > 0 && dda->col + 1 == grid->cols)) {
+            return false;
+        }
+
+        dda->col = dda->step_col < 0 ? dda->col - 1 : dda->col + 1;
+        dda->t_max_x += dda->t_delta_x;
+    } else {
+        if ((dda->step_row < 0 && dda->row == 0) || (dda->step_row > 0 && dda->row + 1 == grid->rows)) {
+            return false;
+        }
+
+        dda->row = dda->step_row < 0 ? dda->row - 1 : dda->row + 1;
+        dda->t_max_y += dda->t_delta_y;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Calls @p visit for every cell the wall passes through.
+ */
+static void walk_wall(const struct grid_t *const grid,
+                      const struct wall_table_t *const walls,
+                      const size_t wall,
+                      void (*const visit)(struct grid_t *grid, size_t cell, size_t wall),
+                      struct grid_t *const arg) {
+    const struct vec_t pos = {walls->ax[wall], walls->ay[wall]};
+    const struct vec_t dir = {walls->ex[wall], walls->ey[wall]};
+    struct dda_t dda;
+
+    dda_init(&dda, grid, pos, dir, 0.0F);
+
+    do {
+        visit(arg, dda.row * grid->cols + dda.col, wall);
+    } while (fminf(dda.t_max_x, dda.t_max_y) < 1.0F && dda_step(&dda, grid));
+}
+
+static void count_ref(struct grid_t *const grid, const size_t cell, unused const size_t wall) {
+    grid->cells[cell + 1]++;
+}
+
+static void store_ref(struct grid_t *const grid, const size_t cell, const size_t wall) {
+    const size_t i = grid->cells[cell]++;
+
+    grid->ids[i] = (uint32_t) wall;
+}
+
+static void choose_dimensions(struct grid_t *const restrict grid, const struct wall_table_t *const restrict walls) {
+    grid->min = (struct vec_t) {INFINITY, INFINITY};
+    grid->max = (struct vec_t) {-INFINITY, -INFINITY};
+
+    for (size_t i = 0; i < walls->count; i++) {
+        const float xs[2] = {walls->ax[i], walls->ax[i] + walls->ex[i]};
+        const float ys[2] = {walls->ay[i], walls->ay[i] + walls->ey[i]};
+
+        for (size_t j = 0; j < 2; j++) {
+            grid->min.x = fminf(grid->min.x, xs[j]);
+            grid->min.y = fminf(grid->min.y, ys[j]);
+            grid->max.x = fmaxf(grid->max.x, xs[j]);
+            grid->max.y = fmaxf(grid->max.y, ys[j]);
+        }
+    }
+
+    /* pad the bounds, so that walls on the boundary are strictly inside the grid */
+    grid->min = vsub(grid->min, (struct vec_t) {1.0F, 1.0F});
+    grid->max = vadd(grid->max, (struct vec_t) {1.0F, 1.0F});
+
+    const float width = grid->max.x - grid->min.x;
+    const float height = grid->max.y - grid->min.y;
+
+    grid->cell_size = sqrtf(width * height / ((float) walls->count * GRID_CELLS_PER_WALL));
+    grid->cell_size = fmaxf(grid->cell_size, fmaxf(width, height) / (float) GRID_DIM_MAX);
+    grid->cols = (size_t) ceilf(width / grid->cell_size);
+    grid->rows = (size_t) ceilf(height / grid->cell_size);
+    grid->cols = SDL_max(SDL_min(grid->cols, GRID_DIM_MAX), 1);
+    grid->rows = SDL_max(SDL_min(grid->rows, GRID_DIM_MAX), 1);
+    grid->max = vadd(grid->min, (struct vec_t) {(float) grid->cols * grid->cell_size,
+                                                (float) grid->rows * grid->cell_size});
+}
+
+int grid_build(struct grid_t *const restrict grid, const struct wall_table_t *const restrict walls) {
+    memset(grid, 0, sizeof *grid);
+
+    if (walls->count == 0) {
+        return 0;
+    }
+
+    choose_dimensions(grid, walls);
+
+    const size_t ncells = grid->cols * grid->rows;
+    grid->cells = calloc(ncells + 1, sizeof *grid->cells);
+
+    if (grid->cells == NULL) {
+        logger_perror("calloc");
+        return -1;
+    }
+
+    for (size_t i = 0; i < walls->count; i++) {
+        walk_wall(grid, walls, i, count_ref, grid);
+    }
+
+    for (size_t i = 0; i < ncells; i++) {
+        grid->cells[i + 1] += grid->cells[i];
+    }
+
+    const size_t nrefs = grid->cells[ncells];
+
+    if (nrefs > UINT32_MAX || wall_table_alloc(&grid->table, nrefs) != 0) {
+        logger_print(LOG_LEVEL_ERROR, "unable to allocate grid cells");
+        grid_destroy(grid);
+        return -1;
+    }
+
+    grid->ids = malloc(nrefs * sizeof *grid->ids);
+
+    if (grid->ids == NULL) {
+        logger_perror("malloc");
+        grid_destroy(grid);
+        return -1;
+    }
+
+    /* store_ref advances every offset to the end of its cell; shift them back afterwards */
+    for (size_t i = 0; i < walls->count; i++) {
+        walk_wall(grid, walls, i, store_ref, grid);
+    }
+
+    memmove(grid->cells + 1, grid->cells, ncells * sizeof *grid->cells);
+    grid->cells[0] = 0;
+
+    for (size_t i = 0; i < nrefs; i++) {
+        const size_t wall = grid->ids[i];
+
+        grid->table.ax[i] = walls->ax[wall];
+        grid->table.ay[i] = walls->ay[wall];
+        grid->table.ex[i] = walls->ex[wall];
+        grid->table.ey[i] = walls->ey[wall];
+        grid->table.walls[i] = walls->walls[wall];
+    }
+
+    grid->nwalls = walls->count;
+    return 0;
+}
+
+void grid_destroy(struct grid_t *const grid) {
+    wall_table_destroy(&grid->table);
+    free(grid->cells);
+    free(grid->ids);
+    memset(grid, 0, sizeof *grid);
+}
+
+size_t grid_cast(const struct grid_t *const restrict grid,
+                 const struct vec_t pos,
+                 const struct vec_t dir,
+                 float *const restrict dist,
+                 size_t *const restrict tested) {
+    float t_enter = 0.0F;
+    float t_exit = *dist;
+    size_t hit = RAY_NO_HIT;
+
+    if (grid->cells == NULL || !clip_ray(grid, pos, dir, &t_enter, &t_exit)) {
+        return RAY_NO_HIT;
+    }
+
+    struct dda_t dda;
+    dda_init(&dda, grid, pos, dir, t_enter);
+
+    do {
+        const size_t cell = dda.row * grid->cols + dda.col;
+        const size_t begin = grid->cells[cell];
+        const size_t end = grid->cells[cell + 1];
+        const size_t cell_hit = ray_cast(&grid->table, begin, end, pos, dir, dist);
+
+        if (tested != NULL) {
+            *tested += end - begin;
+        }
+
+        if (cell_hit != RAY_NO_HIT) {
+            hit = grid->ids[cell_hit];
+        }
+
+        /* a hit inside the cells visited so far cannot be beaten by walls in cells farther away */
+        if (*dist <= fminf(dda.t_max_x, dda.t_max_y)) {
+            break;
+        }
+    } while (dda_step(&dda, grid));
+
+    return hit;
+}
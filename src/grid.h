@@ -0,0 +1,65 @@
+#ifndef RAY_GRID_H
+#define RAY_GRID_H
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ray.h"
+#include "vector.h"
+
+
+/**
+ * @brief A uniform grid over the bounding box of the world, used to find the walls near a ray.
+ *
+ * Every cell refers to the walls passing through it. The references of all cells are stored back to back
+ * in a single wall table, so that the walls of a cell can be tested with a single call to ray_cast().
+ */
+struct grid_t {
+    struct vec_t min; /**< The lower corner of the grid. */
+    struct vec_t max; /**< The upper corner of the grid. */
+    float cell_size; /**< The length of the side of a cell. */
+    size_t cols; /**< The number of columns (cells along the x-axis). */
+    size_t rows; /**< The number of rows (cells along the y-axis). */
+    uint32_t *cells; /**< The walls of cell i are table entries [cells[i], cells[i + 1]). */
+    uint32_t *ids; /**< For every table entry, the index of the wall in the table the grid was built from. */
+    struct wall_table_t table; /**< The wall references of all cells. */
+    size_t nwalls; /**< The number of walls the grid was built from. */
+};
+
+
+/**
+ * @brief Builds a uniform grid over the given walls.
+ *
+ * The cell size is chosen from the bounding box of the walls and the number of walls, so that there are
+ * about GRID_CELLS_PER_WALL cells per wall, but at most GRID_DIM_MAX cells along either axis.
+ *
+ * @param grid The grid to build.
+ * @param walls The walls to index.
+ * @return 0 on success, -1 on error (the grid is empty in this case).
+ */
+int grid_build(struct grid_t *grid, const struct wall_table_t *walls);
+
+/**
+ * @brief Frees the memory owned by a grid.
+ * @param grid The grid to destroy.
+ */
+void grid_destroy(struct grid_t *grid);
+
+/**
+ * @brief Finds the nearest wall hit by a ray by walking the cells along the ray with a 2D DDA.
+ *
+ * The walk stops at the first cell which contains a hit that is not farther than the far edge of the cell.
+ *
+ * @param grid The grid.
+ * @param pos The origin of the ray.
+ * @param dir The direction of the ray. Must be a unit vector.
+ * @param dist A pointer to the distance to the nearest hit found so far, or INFINITY. Updated if a nearer
+ *             hit is found.
+ * @param tested If not NULL, incremented by the number of walls tested.
+ * @return The index of the nearest wall hit by the ray in the table the grid was built from, or RAY_NO_HIT.
+ */
+size_t grid_cast(const struct grid_t *grid, struct vec_t pos, struct vec_t dir, float *dist, size_t *tested);
+
+
+#endif //RAY_GRID_H
@@ -0,0 +1,105 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "logger.h"
+#include "math.h"
+
+#include "hits.h"
+
+
+int hits_resize(struct hits_t *const hits, const size_t count) {
+    if (hits->dir != NULL && hits->count == count) {
+        return 0;
+    }
+
+    const size_t n = count > 0 ? count : 1;
+    /* the arrays are ordered by decreasing alignment, so that every one starts suitably aligned */
+    const size_t size = n * (sizeof *hits->dir + sizeof *hits->dist + sizeof *hits->wall + sizeof *hits->param +
+                             sizeof *hits->tested + sizeof *hits->edge);
+    char *const block = malloc(size);
+
+    if (block == NULL) {
+        logger_perror("malloc");
+        return -1;
+    }
+
+    free(hits->dir);
+
+    hits->dir = (struct vec_t *) block;
+    hits->dist = (float *) (hits->dir + n);
+    hits->wall = (uint32_t *) (hits->dist + n);
+    hits->param = (float *) (hits->wall + n);
+    hits->tested = (uint32_t *) (hits->param + n);
+    hits->edge = (bool *) (hits->tested + n);
+    hits->count = count;
+
+    return 0;
+}
+
+void hits_destroy(struct hits_t *const hits) {
+    free(hits->dir);
+    memset(hits, 0, sizeof *hits);
+}
+
+struct hits_t hits_slice(const struct hits_t *const hits, const size_t begin, const size_t end) {
+    return (struct hits_t) {
+            .pos = hits->pos,
+            .dir = &hits->dir[begin],
+            .dist = &hits->dist[begin],
+            .wall = &hits->wall[begin],
+            .param = &hits->param[begin],
+            .tested = &hits->tested[begin],
+            .edge = &hits->edge[begin],
+            .count = end - begin
+    };
+}
+
+void hits_clear(const struct hits_t *const hits) {
+    for (size_t i = 0; i < hits->count; i++) {
+        hits->dist[i] = INFINITY;
+        hits->wall[i] = HITS_NONE;
+        hits->param[i] = 0.0F;
+        hits->tested[i] = 0;
+        hits->edge[i] = false;
+    }
+}
+
+void hits_move(const struct hits_t *const hits, const size_t dst, const size_t src, const size_t n) {
+    memmove(&hits->dir[dst], &hits->dir[src], n * sizeof *hits->dir);
+    memmove(&hits->dist[dst], &hits->dist[src], n * sizeof *hits->dist);
+    memmove(&hits->wall[dst], &hits->wall[src], n * sizeof *hits->wall);
+    memmove(&hits->param[dst], &hits->param[src], n * sizeof *hits->param);
+    memmove(&hits->tested[dst], &hits->tested[src], n * sizeof *hits->tested);
+    memmove(&hits->edge[dst], &hits->edge[src], n * sizeof *hits->edge);
+}
+
+void hits_resolve(const struct hits_t *const restrict hits, const struct wall_table_t *const restrict walls) {
+    for (size_t i = 0; i < hits->count; i++) {
+        const uint32_t wall = hits->wall[i];
+
+        if (wall == HITS_NONE) {
+            hits->param[i] = 0.0F;
+            continue;
+        }
+
+        /* project the hit onto the wall; rounding may push it slightly past the endpoints */
+        const float x = hits->pos.x + hits->dir[i].x * hits->dist[i] - walls->ax[wall];
+        const float y = hits->pos.y + hits->dir[i].y * hits->dist[i] - walls->ay[wall];
+        const float ex = walls->ex[wall];
+        const float ey = walls->ey[wall];
+        const float len2 = ex * ex + ey * ey;
+
+        hits->param[i] = len2 > 0.0F ? constrain((x * ex + y * ey) / len2, 0.0F, 1.0F) : 0.0F;
+    }
+}
+
+struct vec_t hits_pos(const struct hits_t *const restrict hits, const struct wall_table_t *const restrict walls,
+                      const size_t i) {
+    const uint32_t wall = hits->wall[i];
+
+    return (struct vec_t) {
+            walls->ax[wall] + walls->ex[wall] * hits->param[i],
+            walls->ay[wall] + walls->ey[wall] * hits->param[i]
+    };
+}
@@ -0,0 +1,101 @@
+#ifndef RAY_HITS_H
+#define RAY_HITS_H
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ray.h"
+#include "vector.h"
+
+
+/**
+ * @brief Wall index of a ray which does not hit any wall.
+ */
+#define HITS_NONE UINT32_MAX
+
+
+/**
+ * @brief The rays cast from the camera and the walls they hit, one array per quantity.
+ *
+ * All rays share the origin of the camera. The render passes only stream through the distances, wall indexes and
+ * hit parameters; the directions, the counters and the edge flags are only touched while casting.
+ */
+struct hits_t {
+    struct vec_t pos; /**< The common origin of the rays. */
+    struct vec_t *dir; /**< The direction of every ray, as a unit vector. */
+    float *dist; /**< The distance from the origin to the hit of every ray, or INFINITY if it hits no wall. */
+    uint32_t *wall; /**< The index of the wall hit by every ray in the table of all walls, or HITS_NONE. */
+    float *param; /**< The position of the hit of every ray along its wall, from 0 at a to 1 at b. */
+    uint32_t *tested; /**< The number of walls tested while casting every ray. */
+    bool *edge; /**< Whether the visible wall changes between the previous ray and every ray; only set by sweeps. */
+    size_t count; /**< The number of rays. */
+};
+
+
+/**
+ * @brief Reallocates the arrays of a hit buffer for a new number of rays. Does nothing if the number of rays
+ *        does not change.
+ *
+ * All arrays share a single allocation. The contents are undefined after the buffer was reallocated.
+ *
+ * @param hits The hit buffer, zero-initialized or previously resized.
+ * @param count The number of rays.
+ * @return 0 on success, -1 on error (the buffer is left unchanged in this case).
+ */
+int hits_resize(struct hits_t *hits, size_t count);
+
+/**
+ * @brief Frees the arrays of a hit buffer.
+ * @param hits The hit buffer to destroy.
+ */
+void hits_destroy(struct hits_t *hits);
+
+/**
+ * @brief Returns a view of the rays [@p begin, @p end) of a hit buffer, sharing its arrays.
+ *
+ * @param hits The hit buffer.
+ * @param begin The index of the first ray.
+ * @param end The index one past the last ray.
+ * @return The view, whose ray 0 is the ray @p begin of @p hits.
+ */
+struct hits_t hits_slice(const struct hits_t *hits, size_t begin, size_t end);
+
+/**
+ * @brief Clears the hits, the counters and the edge flags of all rays of a hit buffer, keeping their directions.
+ * @param hits The hit buffer.
+ */
+void hits_clear(const struct hits_t *hits);
+
+/**
+ * @brief Moves @p n rays of a hit buffer, including their directions, from index @p src to index @p dst.
+ *        The ranges may overlap.
+ *
+ * @param hits The hit buffer.
+ * @param dst The index of the first ray to move to.
+ * @param src The index of the first ray to move.
+ * @param n The number of rays.
+ */
+void hits_move(const struct hits_t *hits, size_t dst, size_t src, size_t n);
+
+/**
+ * @brief Computes the hit parameters of all rays of a hit buffer from their distances.
+ *
+ * @param hits The hit buffer.
+ * @param walls The table of all walls the wall indexes refer to.
+ */
+void hits_resolve(const struct hits_t *hits, const struct wall_table_t *walls);
+
+/**
+ * @brief Computes the position of the hit of a ray from its hit parameter.
+ *
+ * @param hits The hit buffer.
+ * @param walls The table of all walls the wall indexes refer to.
+ * @param i The index of the ray, which must have hit a wall.
+ * @return The position of the hit.
+ */
+struct vec_t hits_pos(const struct hits_t *hits, const struct wall_table_t *walls, size_t i);
+
+
+#endif //RAY_HITS_H
@@ -1,4 +1,5 @@
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -34,13 +35,33 @@ static bool get_flag(const int argc,
     return false;
 }
 
+static const char *get_option(const int argc,
+                              char *const *const restrict argv,
+                              const char *const restrict shortopt,
+                              const char *const restrict longopt) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (shortopt != NULL && strcmp(argv[i], shortopt) == 0) {
+            return argv[i + 1];
+        }
+
+        if (longopt != NULL && strcmp(argv[i], longopt) == 0) {
+            return argv[i + 1];
+        }
+    }
+
+    return NULL;
+}
+
 static inline void usage(const char *const argv0) {
-    static const char *const fmt = "usage: %s [-h|--help] [-p|--profile] [-v|--version]\n"
+    static const char *const fmt = "usage: %s [-h|--help] [-m|--memory BYTES] [-p|--profile] [-v|--version] "
+                                   "[-w|--world PATH]\n"
                                    "\t-h, --help\t\tprint this help message and exit\n"
+                                   "\t-m, --memory BYTES\tload the world within BYTES of memory instead of %d\n"
                                    "\t-p, --profile\t\tprint profiling information and exit\n"
-                                   "\t-v, --version\t\tprint version information and exit\n";
+                                   "\t-v, --version\t\tprint version information and exit\n"
+                                   "\t-w, --world PATH\tload the world from PATH instead of " WORLD_SPEC_FILE "\n";
 
-    fprintf(stderr, fmt, argv0);
+    fprintf(stderr, fmt, argv0, WORLD_MEMORY_BUDGET);
 }
 
 static inline void version(const char *const argv0) {
@@ -234,7 +255,28 @@ int main(const int argc, char **const argv) {
     log_system_info();
     logger_print(LOG_LEVEL_INFO, "creating and initializing game objects...");
 
-    struct game_t *const game = game_create();
+    const char *const world = get_option(argc, argv, "-w", "--world");
+    const char *const memory = get_option(argc, argv, "-m", "--memory");
+    size_t budget = WORLD_MEMORY_BUDGET;
+
+    if (memory != NULL) {
+        char *end = NULL;
+        const unsigned long long value = strtoull(memory, &end, 10);
+
+        if (end == memory || *end != '\0' || value == 0 || value > SIZE_MAX) {
+            logger_printf(LOG_LEVEL_FATAL, "invalid memory budget: %s\n", memory);
+            return EXIT_FAILURE;
+        }
+
+        budget = (size_t) value;
+    }
+
+    struct game_t *const game = game_create(world == NULL ? WORLD_SPEC_FILE : world, budget);
+
+    if (game == NULL) {
+        logger_print(LOG_LEVEL_FATAL, "unable to create game");
+        return EXIT_FAILURE;
+    }
 
     if (game_init(game) != 0) {
         logger_print(LOG_LEVEL_FATAL, "unable to initialize game");
@@ -0,0 +1,469 @@
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "conf.h"
+#include "logger.h"
+
+#include "optimize.h"
+
+
+/**
+ * Marks the absence of a wall endpoint.
+ */
+#define OPTIMIZE_NONE UINT32_MAX
+
+/**
+ * Maximum number of walls meeting in a point for them to be merged there. Every pair of them is tested, and points
+ * shared by more walls are rare outside of pathological worlds.
+ */
+#define OPTIMIZE_DEGREE_MAX 16
+
+/**
+ * Number of bits of each coordinate of the grid the midpoints of the walls are snapped to before they are sorted
+ * along the Hilbert curve; the index of a cell fits into 32 bits.
+ */
+#define OPTIMIZE_HILBERT_BITS 16
+
+/**
+ * Minimum width of the cells of the welding grid. The cells are as wide as the weld distance, unless it is so small
+ * (or zero, which only welds identical endpoints) that the cell coordinates would lose their meaning.
+ */
+#define OPTIMIZE_CELL_MIN 0.001F
+
+/**
+ * Bound of the cell coordinates of the welding grid, so that coordinates far from the origin do not overflow.
+ */
+#define OPTIMIZE_CELL_MAX ((double) (INT64_C(1) << 62))
+
+
+/**
+ * @brief A wall endpoint in the welding grid.
+ */
+struct endpoint_t {
+    int64_t cx; /**< The column of the cell containing the endpoint. */
+    int64_t cy; /**< The row of the cell containing the endpoint. */
+    uint32_t id; /**< The index of the endpoint: twice the index of its wall, plus one for the second endpoint. */
+};
+
+/**
+ * @brief The state of an optimization; all arrays are allocated up front, so that the world is only modified once
+ *        nothing can fail anymore.
+ */
+struct optimize_t {
+    struct world_t *world; /**< The world being optimized. */
+    size_t nendpoints; /**< The number of wall endpoints, twice the number of walls. */
+    struct endpoint_t *endpoints; /**< The wall endpoints, sorted by their cells. */
+    uint32_t *welded; /**< For every endpoint, the endpoint it is welded to; endpoints kept are welded to themselves. */
+    uint32_t *first; /**< For every endpoint kept, the first of the endpoints welded to it in @p incident. */
+    uint32_t *incident; /**< The endpoints of the walls left, grouped by the endpoint they are welded to. */
+    uint32_t *link; /**< For every endpoint, the endpoint of the wall it is merged with, or OPTIMIZE_NONE. */
+    bool *removed; /**< For every wall, whether it has no length. */
+    bool *visited; /**< For every wall, whether it was added to a run of merged walls. */
+    struct wall_t *walls; /**< The walls left after merging, before they are sorted. */
+    uint64_t *keys; /**< For every wall left, its Hilbert index in the upper and its index in the lower half. */
+    struct optimize_stats_t stats; /**< Statistics of the optimization. */
+};
+
+
+static inline struct vec_t endpoint(const struct world_t *const world, const uint32_t id) {
+    const struct wall_t *const wall = &world->walls[id / 2];
+    return id % 2 == 0 ? wall->a : wall->b;
+}
+
+static inline float cross(const struct vec_t a, const struct vec_t b) {
+    return a.x * b.y - a.y * b.x;
+}
+
+static inline int64_t cell(const float coord) {
+    const double c = floor((double) coord / (double) fmaxf(WORLD_WELD_DISTANCE, OPTIMIZE_CELL_MIN));
+    return (int64_t) fmin(fmax(c, -OPTIMIZE_CELL_MAX), OPTIMIZE_CELL_MAX);
+}
+
+static inline int compare_cells(const int64_t ax, const int64_t ay, const int64_t bx, const int64_t by) {
+    return ax != bx ? (ax > bx) - (ax < bx) : (ay > by) - (ay < by);
+}
+
+static int compare_endpoints(const void *const a, const void *const b) {
+    const struct endpoint_t *const x = a;
+    const struct endpoint_t *const y = b;
+    const int order = compare_cells(x->cx, x->cy, y->cx, y->cy);
+
+    return order != 0 ? order : (x->id > y->id) - (x->id < y->id);
+}
+
+static int compare_keys(const void *const a, const void *const b) {
+    const uint64_t x = *(const uint64_t *) a;
+    const uint64_t y = *(const uint64_t *) b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Finds the first endpoint in a cell, or after it if the cell is empty.
+ */
+static size_t find_cell(const struct optimize_t *const opt, const int64_t cx, const int64_t cy) {
+    size_t lo = 0;
+    size_t hi = opt->nendpoints;
+
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+
+        if (compare_cells(opt->endpoints[mid].cx, opt->endpoints[mid].cy, cx, cy) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+/**
+ * @brief Welds every endpoint to the first endpoint in the order of the cells which is close enough and not welded
+ *        to another one yet, then moves the endpoints onto the ones they are welded to.
+ *
+ * Endpoints are only welded to an endpoint kept, never to one welded to something else, so endpoints do not chain
+ * into clusters wider than the weld distance.
+ */
+static void weld_endpoints(struct optimize_t *const opt) {
+    struct world_t *const world = opt->world;
+
+    for (uint32_t i = 0; i < opt->nendpoints; i++) {
+        const struct vec_t p = endpoint(world, i);
+        opt->endpoints[i] = (struct endpoint_t) {cell(p.x), cell(p.y), i};
+        opt->welded[i] = OPTIMIZE_NONE;
+    }
+
+    qsort(opt->endpoints, opt->nendpoints, sizeof *opt->endpoints, compare_endpoints);
+
+    for (size_t i = 0; i < opt->nendpoints; i++) {
+        const struct endpoint_t *const e = &opt->endpoints[i];
+
+        if (opt->welded[e->id] != OPTIMIZE_NONE) {
+            continue;
+        }
+
+        const struct vec_t p = endpoint(world, e->id);
+        opt->welded[e->id] = e->id;
+
+        /* endpoints close enough lie in the same or a neighbouring cell */
+        for (int64_t dx = -1; dx <= 1; dx++) {
+            for (size_t j = find_cell(opt, e->cx + dx, e->cy - 1); j < opt->nendpoints; j++) {
+                const struct endpoint_t *const f = &opt->endpoints[j];
+
+                if (f->cx != e->cx + dx || f->cy > e->cy + 1) {
+                    break;
+                }
+
+                const float dist = vdist(p, endpoint(world, f->id));
+
+                if (opt->welded[f->id] == OPTIMIZE_NONE && dist <= WORLD_WELD_DISTANCE) {
+                    opt->welded[f->id] = e->id;
+                    opt->stats.welded += dist > 0.0F ? 1 : 0;
+                }
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < opt->nendpoints; i++) {
+        struct wall_t *const wall = &world->walls[i / 2];
+        const struct vec_t p = endpoint(world, opt->welded[i]);
+
+        *(i % 2 == 0 ? &wall->a : &wall->b) = p;
+    }
+
+    for (size_t i = 0; i < world->nwalls; i++) {
+        world_update_wall(&world->walls[i]);
+        opt->removed[i] = !(world->walls[i].length > 0.0F);
+        opt->stats.degenerate += opt->removed[i] ? 1 : 0;
+    }
+}
+
+/**
+ * @brief Checks whether two walls meeting in an endpoint can be merged there: they have the same color and type,
+ *        continue each other on opposite sides of the endpoint, and each far endpoint lies within the weld distance
+ *        of the line of the other wall.
+ */
+static bool can_merge(const struct world_t *const world, const uint32_t e1, const uint32_t e2) {
+    const struct wall_t *const w1 = &world->walls[e1 / 2];
+    const struct wall_t *const w2 = &world->walls[e2 / 2];
+
+    if (w1->color.r != w2->color.r || w1->color.g != w2->color.g || w1->color.b != w2->color.b ||
+        w1->color.a != w2->color.a || w1->type != w2->type) {
+        return false;
+    }
+
+    const struct vec_t p = endpoint(world, e1);
+    const struct vec_t d1 = vsub(endpoint(world, e1 ^ 1), p);
+    const struct vec_t d2 = vsub(endpoint(world, e2 ^ 1), p);
+    const float area = fabsf(cross(d1, d2));
+
+    return vprod(d1, d2) < 0.0F && area <= WORLD_WELD_DISTANCE * fminf(w1->length, w2->length);
+}
+
+/**
+ * @brief Links the walls which can be merged, pairing up the walls meeting in every endpoint.
+ */
+static void link_walls(struct optimize_t *const opt) {
+    const struct world_t *const world = opt->world;
+
+    /* group the endpoints of the walls left by the endpoint they are welded to */
+    memset(opt->first, 0, (opt->nendpoints + 1) * sizeof *opt->first);
+
+    for (uint32_t i = 0; i < opt->nendpoints; i++) {
+        opt->link[i] = OPTIMIZE_NONE;
+        opt->first[opt->welded[i] + 1] += opt->removed[i / 2] ? 0 : 1;
+    }
+
+    for (size_t i = 0; i < opt->nendpoints; i++) {
+        opt->first[i + 1] += opt->first[i];
+    }
+
+    for (uint32_t i = 0; i < opt->nendpoints; i++) {
+        if (!opt->removed[i / 2]) {
+            opt->incident[opt->first[opt->welded[i]]++] = i;
+        }
+    }
+
+    /* filling the groups moved every start to the start of the next group */
+    memmove(opt->first + 1, opt->first, opt->nendpoints * sizeof *opt->first);
+    opt->first[0] = 0;
+
+    for (size_t i = 0; i < opt->nendpoints; i++) {
+        const uint32_t begin = opt->first[i];
+        const uint32_t end = opt->first[i + 1];
+
+        if (end - begin < 2 || end - begin > OPTIMIZE_DEGREE_MAX) {
+            continue;
+        }
+
+        for (uint32_t j = begin; j < end; j++) {
+            for (uint32_t k = j + 1; k < end && opt->link[opt->incident[j]] == OPTIMIZE_NONE; k++) {
+                const uint32_t e1 = opt->incident[j];
+                const uint32_t e2 = opt->incident[k];
+
+                if (opt->link[e2] == OPTIMIZE_NONE && can_merge(world, e1, e2)) {
+                    opt->link[e1] = e2;
+                    opt->link[e2] = e1;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Merges the run of linked walls starting with a wall into as few walls as possible, which are appended to
+ *        the walls left.
+ *
+ * A wall is only added to a merged wall while its far endpoint lies within the weld distance of the line through
+ * the first wall of the merged wall, so that small deviations cannot add up along a long run.
+ *
+ * @param opt The state of the optimization.
+ * @param wall The first wall of the run.
+ * @param in The endpoint of the first wall at which the run starts, 0 or 1.
+ * @param count Pointer to the number of walls left, to be incremented.
+ */
+static void merge_run(struct optimize_t *const opt, uint32_t wall, uint32_t in, size_t *const count) {
+    const struct world_t *const world = opt->world;
+
+    while (true) {
+        const struct vec_t start = endpoint(world, 2 * wall + in);
+        const struct vec_t dir = vsub(endpoint(world, 2 * wall + (in ^ 1)), start);
+        const float length = world->walls[wall].length;
+        struct wall_t merged = world->walls[wall];
+        struct vec_t end = endpoint(world, 2 * wall + (in ^ 1));
+        uint32_t next = opt->link[2 * wall + (in ^ 1)];
+
+        opt->visited[wall] = true;
+
+        while (next != OPTIMIZE_NONE && !opt->visited[next / 2]) {
+            const struct vec_t far = endpoint(world, next ^ 1);
+
+            if (fabsf(cross(dir, vsub(far, start))) > WORLD_WELD_DISTANCE * length) {
+                break;
+            }
+
+            opt->visited[next / 2] = true;
+            end = far;
+            next = opt->link[next ^ 1];
+        }
+
+        /* the merged wall keeps the orientation of its first wall */
+        merged.a = in == 0 ? start : end;
+        merged.b = in == 0 ? end : start;
+        world_update_wall(&merged);
+        opt->walls[(*count)++] = merged;
+
+        if (next == OPTIMIZE_NONE || opt->visited[next / 2]) {
+            return;
+        }
+
+        wall = next / 2;
+        in = next % 2;
+    }
+}
+
+/**
+ * @brief Merges all runs of linked walls.
+ * @return The number of walls left.
+ */
+static size_t merge_walls(struct optimize_t *const opt) {
+    const size_t nwalls = opt->world->nwalls;
+    size_t count = 0;
+
+    memset(opt->visited, 0, nwalls * sizeof *opt->visited);
+
+    /* runs are followed from one of their ends; what is left are closed loops, which are cut anywhere */
+    for (uint32_t i = 0; i < nwalls; i++) {
+        if (!opt->removed[i] && !opt->visited[i] &&
+            (opt->link[2 * i] == OPTIMIZE_NONE || opt->link[2 * i + 1] == OPTIMIZE_NONE)) {
+            merge_run(opt, i, opt->link[2 * i] == OPTIMIZE_NONE ? 0 : 1, &count);
+        }
+    }
+
+    for (uint32_t i = 0; i < nwalls; i++) {
+        if (!opt->removed[i] && !opt->visited[i]) {
+            merge_run(opt, i, 0, &count);
+        }
+    }
+
+    return count;
+}
+
+/**
+ * @brief Computes the index of a cell of a square grid along the Hilbert curve through the grid.
+ */
+static uint32_t hilbert_index(uint32_t x, uint32_t y) {
+    const uint32_t n = 1U << OPTIMIZE_HILBERT_BITS;
+    uint32_t index = 0;
+
+    for (uint32_t s = n / 2; s > 0; s /= 2) {
+        const uint32_t rx = (x & s) > 0 ? 1 : 0;
+        const uint32_t ry = (y & s) > 0 ? 1 : 0;
+
+        index += s * s * ((3 * rx) ^ ry);
+
+        /* rotate the quadrant, so that the curve within it starts and ends next to the neighbouring quadrants */
+        if (ry == 0) {
+            if (rx == 1) {
+                x = n - 1 - x;
+                y = n - 1 - y;
+            }
+
+            const uint32_t t = x;
+            x = y;
+            y = t;
+        }
+    }
+
+    return index;
+}
+
+/**
+ * @brief Sorts the walls left along the Hilbert curve through their midpoints, and stores them in the world.
+ */
+static void sort_walls(struct optimize_t *const opt, const size_t count) {
+    struct vec_t min = {INFINITY, INFINITY};
+    struct vec_t max = {-INFINITY, -INFINITY};
+
+    for (size_t i = 0; i < count; i++) {
+        const struct vec_t mid = vlerp(opt->walls[i].a, opt->walls[i].b, 0.5F);
+
+        min = (struct vec_t) {fminf(min.x, mid.x), fminf(min.y, mid.y)};
+        max = (struct vec_t) {fmaxf(max.x, mid.x), fmaxf(max.y, mid.y)};
+    }
+
+    /* the same scale on both axes keeps the curve from stretching along the longer side of the world */
+    const float top = (float) ((1U << OPTIMIZE_HILBERT_BITS) - 1);
+    const float extent = fmaxf(max.x - min.x, max.y - min.y);
+    const float scale = extent > 0.0F ? top / extent : 0.0F;
+
+    for (size_t i = 0; i < count; i++) {
+        const struct vec_t mid = vlerp(opt->walls[i].a, opt->walls[i].b, 0.5F);
+        const uint32_t x = (uint32_t) fminf((mid.x - min.x) * scale, top);
+        const uint32_t y = (uint32_t) fminf((mid.y - min.y) * scale, top);
+
+        opt->keys[i] = (uint64_t) hilbert_index(x, y) << 32 | i;
+    }
+
+    qsort(opt->keys, count, sizeof *opt->keys, compare_keys);
+
+    for (size_t i = 0; i < count; i++) {
+        opt->world->walls[i] = opt->walls[opt->keys[i] & UINT32_MAX];
+    }
+
+    opt->world->nwalls = count;
+}
+
+static void optimize_destroy(struct optimize_t *const opt) {
+    free(opt->endpoints);
+    free(opt->welded);
+    free(opt->first);
+    free(opt->incident);
+    free(opt->link);
+    free(opt->removed);
+    free(opt->visited);
+    free(opt->walls);
+    free(opt->keys);
+}
+
+int optimize_world(struct world_t *const world, struct optimize_stats_t *const stats) {
+    struct optimize_t opt = {
+            .world = world,
+            .nendpoints = 2 * world->nwalls,
+            .stats = {.walls = world->nwalls}
+    };
+
+    if (stats != NULL) {
+        *stats = opt.stats;
+    }
+
+    /* a mapped world was optimized before it was compiled, and its walls cannot be removed from the file */
+    if (world->nwalls == 0 || world->map != NULL) {
+        return 0;
+    }
+
+    if (world->nwalls > UINT32_MAX / 2 - 1) {
+        logger_printf(LOG_LEVEL_ERROR, "too many walls to optimize: %zu\n", world->nwalls);
+        return -1;
+    }
+
+    opt.endpoints = malloc(opt.nendpoints * sizeof *opt.endpoints);
+    opt.welded = malloc(opt.nendpoints * sizeof *opt.welded);
+    opt.first = malloc((opt.nendpoints + 1) * sizeof *opt.first);
+    opt.incident = malloc(opt.nendpoints * sizeof *opt.incident);
+    opt.link = malloc(opt.nendpoints * sizeof *opt.link);
+    opt.removed = malloc(world->nwalls * sizeof *opt.removed);
+    opt.visited = malloc(world->nwalls * sizeof *opt.visited);
+    opt.walls = malloc(world->nwalls * sizeof *opt.walls);
+    opt.keys = malloc(world->nwalls * sizeof *opt.keys);
+
+    if (opt.endpoints == NULL || opt.welded == NULL || opt.first == NULL || opt.incident == NULL ||
+        opt.link == NULL || opt.removed == NULL || opt.visited == NULL || opt.walls == NULL || opt.keys == NULL) {
+        logger_perror("malloc");
+        optimize_destroy(&opt);
+        return -1;
+    }
+
+    weld_endpoints(&opt);
+    link_walls(&opt);
+
+    const size_t count = merge_walls(&opt);
+
+    opt.stats.merged = world->nwalls - opt.stats.degenerate - count;
+    sort_walls(&opt, count);
+    optimize_destroy(&opt);
+
+    logger_printf(LOG_LEVEL_INFO, "optimized world: removed %zu of %zu walls (%zu of zero length, %zu merged), "
+                                  "welded %zu endpoints\n", opt.stats.walls - world->nwalls, opt.stats.walls,
+                  opt.stats.degenerate, opt.stats.merged, opt.stats.welded);
+
+    if (stats != NULL) {
+        *stats = opt.stats;
+    }
+
+    return 0;
+}
@@ -0,0 +1,39 @@
+#ifndef RAY_OPTIMIZE_H
+#define RAY_OPTIMIZE_H
+
+
+#include <stddef.h>
+
+#include "world.h"
+
+
+/**
+ * @brief Statistics collected while optimizing the walls of a world.
+ */
+struct optimize_stats_t {
+    size_t walls; /**< The number of walls before the optimization. */
+    size_t welded; /**< The number of wall endpoints moved onto a nearby endpoint. */
+    size_t degenerate; /**< The number of walls removed for having no length. */
+    size_t merged; /**< The number of walls removed by merging them into a collinear neighbour. */
+};
+
+
+/**
+ * @brief Optimizes the walls of a world for ray casting, in place.
+ *
+ * Wall endpoints closer than WORLD_WELD_DISTANCE to each other are welded into one. Walls of no length are then
+ * removed, and runs of walls which share an endpoint, have the same color and type and lie on a common line are
+ * merged into a single wall. Finally, the walls are sorted along a Hilbert curve through their midpoints, so that
+ * walls which are close in the world are also close in memory.
+ *
+ * Sectors and portals are not modified. The walls of a mapped world are left as they are, as compiled worlds are
+ * optimized before they are written.
+ *
+ * @param world The world to optimize.
+ * @param stats Pointer to store the statistics of the optimization, or NULL.
+ * @return 0 on success, -1 on error (the world is not modified in this case).
+ */
+int optimize_world(struct world_t *world, struct optimize_stats_t *stats);
+
+
+#endif //RAY_OPTIMIZE_H
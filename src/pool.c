@@ -0,0 +1,272 @@
+#include <SDL2/SDL.h>
+
+#include "logger.h"
+
+#include "pool.h"
+
+
+#ifdef RAY_STANDALONE
+
+/* the tools do not link the SDL library, so their pools run every job on the calling thread */
+
+int pool_create(struct pool_t *const pool, const size_t nthreads) {
+    (void) nthreads;
+    memset(pool, 0, sizeof *pool);
+    pool->workers[0] = (struct pool_worker_t) {.pool = pool, .id = 0};
+    pool->nthreads = 1;
+    return 0;
+}
+
+void pool_run(struct pool_t *const pool,
+              const size_t nitems,
+              const size_t tile,
+              void (*const func)(const void *arg, size_t begin, size_t end),
+              const void *const arg) {
+    (void) pool;
+    (void) tile;
+
+    if (nitems > 0) {
+        func(arg, 0, nitems);
+    }
+}
+
+void pool_destroy(struct pool_t *const pool) {
+    memset(pool, 0, sizeof *pool);
+}
+
+#else
+
+/**
+ * Number of bits used for each end of a packed tile range.
+ */
+#define POOL_TILE_BITS 15
+
+/**
+ * Maximum number of tiles in a single job.
+ */
+#define POOL_TILES_MAX ((1 << POOL_TILE_BITS) - 1)
+
+
+static inline int pack_range(const size_t begin, const size_t end) {
+    return (int) (begin << POOL_TILE_BITS | end);
+}
+
+static inline size_t range_begin(const int range) {
+    return (size_t) range >> POOL_TILE_BITS;
+}
+
+static inline size_t range_end(const int range) {
+    return (size_t) range & POOL_TILES_MAX;
+}
+
+/**
+ * @brief Takes the first tile from the range owned by a worker.
+ * @return true if a tile was taken, false if the range is empty.
+ */
+static bool pop_tile(struct pool_worker_t *const worker, size_t *const tile) {
+    for (;;) {
+        const int range = SDL_AtomicGet(&worker->tiles);
+        const size_t begin = range_begin(range);
+        const size_t end = range_end(range);
+
+        if (begin >= end) {
+            return false;
+        }
+
+        if (SDL_AtomicCAS(&worker->tiles, range, pack_range(begin + 1, end))) {
+            *tile = begin;
+            return true;
+        }
+    }
+}
+
+/**
+ * @brief Moves the back half of the range owned by @p victim to @p thief, whose range must be empty.
+ * @return true if any tiles were stolen, false if the range of the victim is empty.
+ */
+static bool steal_tiles(struct pool_worker_t *const restrict thief, struct pool_worker_t *const restrict victim) {
+    for (;;) {
+        const int range = SDL_AtomicGet(&victim->tiles);
+        const size_t begin = range_begin(range);
+        const size_t end = range_end(range);
+
+        if (begin >= end) {
+            return false;
+        }
+
+        const size_t mid = begin + (end - begin) / 2;
+
+        if (SDL_AtomicCAS(&victim->tiles, range, pack_range(begin, mid))) {
+            SDL_AtomicSet(&thief->tiles, pack_range(mid, end));
+            return true;
+        }
+    }
+}
+
+static void run_tiles(struct pool_worker_t *const worker) {
+    const struct pool_t *const pool = worker->pool;
+    size_t tile;
+
+    for (;;) {
+        while (pop_tile(worker, &tile)) {
+            const size_t begin = tile * pool->tile;
+            const size_t end = SDL_min(begin + pool->tile, pool->nitems);
+
+            pool->func(pool->arg, begin, end);
+        }
+
+        bool stolen = false;
+
+        for (size_t i = 1; i < pool->nthreads && !stolen; i++) {
+            stolen = steal_tiles(worker, &worker->pool->workers[(worker->id + i) % pool->nthreads]);
+        }
+
+        if (!stolen) {
+            return;
+        }
+    }
+}
+
+static int worker_main(void *const arg) {
+    struct pool_worker_t *const worker = arg;
+    struct pool_t *const pool = worker->pool;
+    uint64_t generation = 0;
+
+    for (;;) {
+        SDL_LockMutex(pool->lock);
+
+        while (!pool->quit && pool->generation == generation) {
+            SDL_CondWait(pool->start, pool->lock);
+        }
+
+        generation = pool->generation;
+        const bool quit = pool->quit;
+        SDL_UnlockMutex(pool->lock);
+
+        if (quit) {
+            return 0;
+        }
+
+        run_tiles(worker);
+
+        SDL_LockMutex(pool->lock);
+
+        if (--pool->pending == 0) {
+            SDL_CondSignal(pool->done);
+        }
+
+        SDL_UnlockMutex(pool->lock);
+    }
+}
+
+int pool_create(struct pool_t *const pool, size_t nthreads) {
+    memset(pool, 0, sizeof *pool);
+
+    if (nthreads == 0) {
+        nthreads = (size_t) SDL_max(SDL_GetCPUCount(), 1);
+    }
+
+    nthreads = SDL_min(nthreads, POOL_THREADS_MAX);
+
+    pool->lock = SDL_CreateMutex();
+    pool->start = SDL_CreateCond();
+    pool->done = SDL_CreateCond();
+
+    if (pool->lock == NULL || pool->start == NULL || pool->done == NULL) {
+        logger_printf(LOG_LEVEL_ERROR, "unable to create synchronization primitives: %s\n", SDL_GetError());
+        pool_destroy(pool);
+        return -1;
+    }
+
+    pool->workers[0] = (struct pool_worker_t) {.pool = pool, .id = 0};
+    pool->nthreads = 1;
+
+    for (size_t i = 1; i < nthreads; i++) {
+        struct pool_worker_t *const worker = &pool->workers[i];
+
+        worker->pool = pool;
+        worker->id = i;
+        worker->thread = SDL_CreateThread(worker_main, "worker", worker);
+
+        if (worker->thread == NULL) {
+            logger_printf(LOG_LEVEL_WARN, "unable to create worker thread: %s\n", SDL_GetError());
+            break;
+        }
+
+        pool->nthreads++;
+    }
+
+    return 0;
+}
+
+void pool_run(struct pool_t *const pool,
+              const size_t nitems,
+              size_t tile,
+              void (*const func)(const void *arg, size_t begin, size_t end),
+              const void *const arg) {
+    if (nitems == 0) {
+        return;
+    }
+
+    tile = SDL_max(tile, (nitems + POOL_TILES_MAX - 1) / POOL_TILES_MAX);
+    tile = SDL_max(tile, 1);
+
+    if (pool->nthreads <= 1) {
+        func(arg, 0, nitems);
+        return;
+    }
+
+    const size_t ntiles = (nitems + tile - 1) / tile;
+
+    pool->func = func;
+    pool->arg = arg;
+    pool->nitems = nitems;
+    pool->tile = tile;
+
+    for (size_t i = 0; i < pool->nthreads; i++) {
+        const size_t begin = ntiles * i / pool->nthreads;
+        const size_t end = ntiles * (i + 1) / pool->nthreads;
+
+        SDL_AtomicSet(&pool->workers[i].tiles, pack_range(begin, end));
+    }
+
+    SDL_LockMutex(pool->lock);
+    pool->pending = pool->nthreads - 1;
+    pool->generation++;
+    SDL_CondBroadcast(pool->start);
+    SDL_UnlockMutex(pool->lock);
+
+    run_tiles(&pool->workers[0]);
+
+    SDL_LockMutex(pool->lock);
+
+    while (pool->pending > 0) {
+        SDL_CondWait(pool->done, pool->lock);
+    }
+
+    SDL_UnlockMutex(pool->lock);
+}
+
+void pool_destroy(struct pool_t *const pool) {
+    if (pool->lock != NULL) {
+        SDL_LockMutex(pool->lock);
+        pool->quit = true;
+
+        if (pool->start != NULL) {
+            SDL_CondBroadcast(pool->start);
+        }
+
+        SDL_UnlockMutex(pool->lock);
+    }
+
+    for (size_t i = 1; i < pool->nthreads; i++) {
+        SDL_WaitThread(pool->workers[i].thread, NULL);
+    }
+
+    SDL_DestroyCond(pool->done);
+    SDL_DestroyCond(pool->start);
+    SDL_DestroyMutex(pool->lock);
+    memset(pool, 0, sizeof *pool);
+}
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef RAY_POOL_H
+#define RAY_POOL_H
+
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <SDL2/SDL.h>
+
+
+/**
+ * @brief Maximum number of threads in a pool, including the calling thread.
+ */
+#define POOL_THREADS_MAX 64
+
+
+struct pool_t;
+
+/**
+ * @brief A participant in a worker pool.
+ *
+ * Each worker owns a contiguous range of tiles. The owner takes tiles from the front of the range;
+ * idle workers steal the back half of the range of another worker.
+ */
+struct pool_worker_t {
+    struct pool_t *pool; /**< The pool the worker belongs to. */
+    SDL_Thread *thread; /**< The thread running the worker, or NULL for the calling thread. */
+    SDL_atomic_t tiles; /**< The range of tiles [begin, end) owned by the worker, packed as (begin << 15) | end. */
+    size_t id; /**< Index of the worker in the pool. */
+};
+
+/**
+ * @brief A persistent pool of worker threads which process ranges of items in parallel.
+ *
+ * Programs built with RAY_STANDALONE, which do not link the SDL library, only get the calling thread.
+ */
+struct pool_t {
+    struct pool_worker_t workers[POOL_THREADS_MAX]; /**< The workers; workers[0] is the calling thread. */
+    size_t nthreads; /**< The number of workers, including the calling thread. */
+    SDL_mutex *lock; /**< Protects generation, pending and quit. */
+    SDL_cond *start; /**< Signalled when a new job is submitted. */
+    SDL_cond *done; /**< Signalled when the last worker thread finishes a job. */
+    uint64_t generation; /**< Incremented for every job. */
+    size_t pending; /**< The number of worker threads which have not finished the current job yet. */
+    bool quit; /**< Boolean flag indicating whether the worker threads should exit. */
+    void (*func)(const void *arg, size_t begin, size_t end); /**< The function processing the current job. */
+    const void *arg; /**< The argument passed to func. */
+    size_t nitems; /**< The number of items in the current job. */
+    size_t tile; /**< The number of items in a tile of the current job. */
+};
+
+
+/**
+ * @brief Creates a worker pool and starts its threads.
+ *
+ * @param pool The pool to initialize.
+ * @param nthreads The number of threads, including the calling thread, or 0 to use SDL_GetCPUCount().
+ *                 At most POOL_THREADS_MAX threads are used. If a thread cannot be started, the pool
+ *                 continues with fewer threads.
+ * @return 0 on success, -1 on error.
+ */
+int pool_create(struct pool_t *pool, size_t nthreads);
+
+/**
+ * @brief Processes the items [0, @p nitems) in parallel and waits until all of them are processed.
+ *
+ * The items are split into tiles of @p tile items, which are distributed evenly among the workers and
+ * rebalanced with work stealing. The calling thread participates in the work.
+ *
+ * @param pool The pool to use.
+ * @param nitems The number of items to process.
+ * @param tile The preferred number of items in a tile. May be increased for very large jobs.
+ * @param func The function to call for every range of items [begin, end).
+ * @param arg The argument to pass to @p func.
+ */
+void pool_run(struct pool_t *pool, size_t nitems, size_t tile,
+              void (*func)(const void *arg, size_t begin, size_t end), const void *arg);
+
+/**
+ * @brief Stops the threads of a worker pool and frees its resources.
+ *
+ * @param pool The pool to destroy.
+ */
+void pool_destroy(struct pool_t *pool);
+
+
+#endif //RAY_POOL_H
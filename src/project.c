@@ -0,0 +1,162 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "logger.h"
+#include "math.h"
+
+#include "project.h"
+
+
+/**
+ * @brief Computes the distance from the origin to the segment a + t * e, t in [0, 1].
+ */
+static float segment_dist(const struct vec_t a, const struct vec_t e) {
+    const float len2 = vlen2(e);
+    const float t = len2 > 0.0F ? constrain(-(a.x * e.x + a.y * e.y) / len2, 0.0F, 1.0F) : 0.0F;
+
+    return vlen(vadd(a, vmul(e, t)));
+}
+
+static int compare_walls(const void *const a, const void *const b) {
+    const struct project_wall_t *const x = a;
+    const struct project_wall_t *const y = b;
+
+    return (x->near > y->near) - (x->near < y->near);
+}
+
+/**
+ * @brief Computes the largest depth of all columns, once all columns are covered.
+ */
+static float max_depth(const float *const depth, const size_t ncolumns) {
+    float far = 0.0F;
+
+    for (size_t i = 0; i < ncolumns; i++) {
+        far = fmaxf(far, depth[i]);
+    }
+
+    return far;
+}
+
+int project_create(struct project_t *const project, const size_t nwalls) {
+    memset(project, 0, sizeof *project);
+
+    /* the culling pass yields up to two ranges per wall */
+    project->walls = malloc(SDL_max(2 * nwalls, 1) * sizeof *project->walls);
+
+    if (project->walls == NULL) {
+        logger_print(LOG_LEVEL_ERROR, "unable to allocate projection buffers");
+        project_destroy(project);
+        return -1;
+    }
+
+    project->capacity = 2 * nwalls;
+    return 0;
+}
+
+void project_destroy(struct project_t *const project) {
+    free(project->walls);
+    memset(project, 0, sizeof *project);
+}
+
+/**
+ * @brief Draws a wall into the columns it covers which may still hold a farther wall.
+ *
+ * @param uncovered The number of columns not covered by any wall, decremented for every column the wall
+ *                  covers first.
+ * @return The number of columns the wall was drawn into.
+ */
+static size_t draw_wall(const struct project_wall_t *const restrict wall,
+                        const struct wall_table_t *const restrict walls,
+                        const struct hits_t *const restrict hits,
+                        size_t *const restrict uncovered) {
+    const float ax = walls->ax[wall->wall];
+    const float ay = walls->ay[wall->wall];
+    const float ex = walls->ex[wall->wall];
+    const float ey = walls->ey[wall->wall];
+    size_t drawn = 0;
+
+    for (size_t i = wall->first; i <= wall->last; i++) {
+        if (!(hits->dist[i] > wall->near)) {
+            continue;
+        }
+
+        /* same formulation as ray_cast(), so that both agree on the visible wall */
+        const struct vec_t dir = hits->dir[i];
+        const float den = ex * dir.y - ey * dir.x;
+        hits->tested[i]++;
+
+        if (isclose(den, 0.0F)) {
+            continue;
+        }
+
+        const float wx = ax - hits->pos.x;
+        const float wy = ay - hits->pos.y;
+        const float tn_raw = wy * dir.x - wx * dir.y;
+        const float tn = signbit(den) ? -tn_raw : tn_raw;
+        const float u = (ex * wy - ey * wx) / den;
+
+        if (tn > 0.0F && tn < fabsf(den) && u > 0.0F && u < hits->dist[i]) {
+            *uncovered -= hits->wall[i] == HITS_NONE;
+            drawn++;
+            hits->dist[i] = u;
+            hits->wall[i] = wall->wall;
+        }
+    }
+
+    return drawn;
+}
+
+int project_walls(struct project_t *const restrict project,
+                  const struct cull_t *const restrict cull,
+                  const struct wall_table_t *const restrict walls,
+                  const struct hits_t *const restrict hits) {
+    const size_t nrays = hits->count;
+
+    if (nrays == 0 || cull->nranges > project->capacity) {
+        return -1;
+    }
+
+    const struct vec_t pos = hits->pos;
+
+    for (size_t i = 0; i < cull->nranges; i++) {
+        const struct cull_range_t *const range = &cull->ranges[i];
+        const struct vec_t a = {walls->ax[range->wall] - pos.x, walls->ay[range->wall] - pos.y};
+        const struct vec_t e = {walls->ex[range->wall], walls->ey[range->wall]};
+
+        project->walls[i] = (struct project_wall_t) {
+                .near = segment_dist(a, e),
+                .wall = range->wall,
+                .first = range->first,
+                .last = SDL_min(range->last, (uint32_t) (nrays - 1))
+        };
+    }
+
+    project->nwalls = cull->nranges;
+    qsort(project->walls, project->nwalls, sizeof *project->walls, compare_walls);
+    hits_clear(hits);
+
+    size_t uncovered = nrays;
+    float far = INFINITY;
+    bool stale = true;
+
+    for (project->drawn = 0; project->drawn < project->nwalls; project->drawn++) {
+        const struct project_wall_t *const wall = &project->walls[project->drawn];
+
+        /* once every column is covered, no wall starting beyond the farthest column can be visible */
+        if (uncovered == 0) {
+            if (stale && wall->near < far) {
+                far = max_depth(hits->dist, nrays);
+                stale = false;
+            }
+
+            if (!(wall->near < far)) {
+                break;
+            }
+        }
+
+        stale |= draw_wall(wall, walls, hits, &uncovered) > 0;
+    }
+
+    return 0;
+}
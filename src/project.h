@@ -0,0 +1,68 @@
+#ifndef RAY_PROJECT_H
+#define RAY_PROJECT_H
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cull.h"
+#include "hits.h"
+#include "ray.h"
+
+
+/**
+ * @brief A wall in the view wedge, with the columns it is projected to.
+ */
+struct project_wall_t {
+    float near; /**< The distance from the camera to the nearest point of the wall. */
+    uint32_t wall; /**< The index of the wall in the wall table. */
+    uint32_t first; /**< The first column covered by the wall. */
+    uint32_t last; /**< The last column covered by the wall. */
+};
+
+/**
+ * @brief Buffers of the projection of the walls to screen columns, allocated once.
+ */
+struct project_t {
+    struct project_wall_t *walls; /**< The walls in the view wedge, sorted front to back. */
+    size_t nwalls; /**< The number of walls in the view wedge. */
+    size_t capacity; /**< The maximum number of walls in the view wedge. */
+    size_t drawn; /**< The number of walls drawn in the current frame before all columns were final. */
+};
+
+
+/**
+ * @brief Allocates the buffers of the projection.
+ *
+ * @param project The projection to initialize.
+ * @param nwalls The maximum number of walls.
+ * @return 0 on success, -1 on error.
+ */
+int project_create(struct project_t *project, size_t nwalls);
+
+/**
+ * @brief Frees the buffers of the projection.
+ * @param project The projection to destroy.
+ */
+void project_destroy(struct project_t *project);
+
+/**
+ * @brief Draws the walls in the view wedge front to back into a 1D depth buffer with one entry per column.
+ *
+ * The walls are ordered by the distance of their nearest point, and each wall is only drawn into the columns
+ * its angular extent covers. Drawing stops as soon as no remaining wall can be nearer than what every column
+ * already holds. The hits of the rays serve as the depth buffer, one ray per column, so the result is the same
+ * as if the rays had been cast.
+ *
+ * @param project The projection buffers, allocated for at least @p walls->count walls.
+ * @param cull The culling pass of the current frame over @p walls and @p hits.
+ * @param walls The walls.
+ * @param hits The rays. Their directions must match the culling pass. The hits and the numbers of tested walls
+ *             are overwritten; the hit parameters are not computed.
+ * @return 0 on success, -1 on error.
+ */
+int project_walls(struct project_t *project, const struct cull_t *cull, const struct wall_table_t *walls,
+                  const struct hits_t *hits);
+
+
+#endif //RAY_PROJECT_H
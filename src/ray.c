@@ -1,8 +1,210 @@
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+
+#if defined(__SSE2__) && !defined(SDL_DISABLE_IMMINTRIN_H)
+#include <immintrin.h>
+#endif
+
+#include "logger.h"
 #include "math.h"
 
 #include "ray.h"
 
 
+/**
+ * Tests the table entries in the range [begin, end) one at a time. Used on targets without SIMD
+ * support and for the entries left over after the vectorized loop.
+ */
+static size_t ray_cast_scalar(const struct wall_table_t *const restrict table,
+                              const size_t begin,
+                              const size_t end,
+                              const struct vec_t pos,
+                              const struct vec_t dir,
+                              float *const restrict dist,
+                              size_t hit) {
+    for (size_t i = begin; i < end; i++) {
+        const float den = table->ex[i] * dir.y - table->ey[i] * dir.x;
+
+        if (isclose(den, 0.0F)) {
+            continue;
+        }
+
+        const float wx = table->ax[i] - pos.x;
+        const float wy = table->ay[i] - pos.y;
+        const float den_abs = fabsf(den);
+
+        /* same formulation as the vectorized loops, so that all code paths agree bit for bit */
+        const float tn_raw = wy * dir.x - wx * dir.y;
+        const float tn = signbit(den) ? -tn_raw : tn_raw;
+        const float u = (table->ex[i] * wy - table->ey[i] * wx) / den;
+
+        if (tn > 0.0F && tn < den_abs && u > 0.0F && u < *dist) {
+            *dist = u;
+            hit = i;
+        }
+    }
+
+    return hit;
+}
+
+#if defined(__AVX2__) && !defined(SDL_DISABLE_IMMINTRIN_H)
+
+#define RAY_SIMD_WIDTH 8
+
+/**
+ * Tests 8 table entries per iteration. Returns the index of the first entry that was not tested.
+ */
+static size_t ray_cast_simd(const struct wall_table_t *const restrict table,
+                            const size_t begin,
+                            const size_t end,
+                            const struct vec_t pos,
+                            const struct vec_t dir,
+                            float *const restrict dist,
+                            size_t *const restrict hit) {
+    const __m256 px = _mm256_set1_ps(pos.x);
+    const __m256 py = _mm256_set1_ps(pos.y);
+    const __m256 dx = _mm256_set1_ps(dir.x);
+    const __m256 dy = _mm256_set1_ps(dir.y);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 sign = _mm256_set1_ps(-0.0F);
+    const __m256 eps = _mm256_set1_ps(FLT_EPSILON);
+    const __m256i step = _mm256_set1_epi32(RAY_SIMD_WIDTH);
+
+    __m256 best = _mm256_set1_ps(*dist);
+    __m256i best_idx = _mm256_set1_epi32(-1);
+    __m256i idx = _mm256_add_epi32(_mm256_set1_epi32((int) begin), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    size_t i;
+
+    for (i = begin; i + RAY_SIMD_WIDTH <= end; i += RAY_SIMD_WIDTH) {
+        const __m256 ex = _mm256_loadu_ps(&table->ex[i]);
+        const __m256 ey = _mm256_loadu_ps(&table->ey[i]);
+        const __m256 wx = _mm256_sub_ps(_mm256_loadu_ps(&table->ax[i]), px);
+        const __m256 wy = _mm256_sub_ps(_mm256_loadu_ps(&table->ay[i]), py);
+
+        const __m256 den = _mm256_sub_ps(_mm256_mul_ps(ex, dy), _mm256_mul_ps(ey, dx));
+        const __m256 den_sign = _mm256_and_ps(den, sign);
+        const __m256 den_abs = _mm256_andnot_ps(sign, den);
+
+        /* t = tn / den is in (0, 1) iff tn * sign(den) is in (0, |den|) */
+        const __m256 tn = _mm256_xor_ps(_mm256_sub_ps(_mm256_mul_ps(wy, dx), _mm256_mul_ps(wx, dy)), den_sign);
+        const __m256 u = _mm256_div_ps(_mm256_sub_ps(_mm256_mul_ps(ex, wy), _mm256_mul_ps(ey, wx)), den);
+
+        __m256 mask = _mm256_cmp_ps(den_abs, eps, _CMP_GT_OQ);
+        mask = _mm256_and_ps(mask, _mm256_cmp_ps(tn, zero, _CMP_GT_OQ));
+        mask = _mm256_and_ps(mask, _mm256_cmp_ps(tn, den_abs, _CMP_LT_OQ));
+        mask = _mm256_and_ps(mask, _mm256_cmp_ps(u, zero, _CMP_GT_OQ));
+        mask = _mm256_and_ps(mask, _mm256_cmp_ps(u, best, _CMP_LT_OQ));
+
+        best = _mm256_blendv_ps(best, u, mask);
+        best_idx = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(best_idx),
+                                                        _mm256_castsi256_ps(idx), mask));
+        idx = _mm256_add_epi32(idx, step);
+    }
+
+    float lanes[RAY_SIMD_WIDTH];
+    int lane_idx[RAY_SIMD_WIDTH];
+
+    _mm256_storeu_ps(lanes, best);
+    _mm256_storeu_si256((__m256i *) lane_idx, best_idx);
+
+    for (size_t lane = 0; lane < RAY_SIMD_WIDTH; lane++) {
+        if (lane_idx[lane] == -1) {
+            continue;
+        }
+
+        const size_t lane_hit = (size_t) lane_idx[lane];
+
+        if (lanes[lane] < *dist || (lanes[lane] <= *dist && *hit != RAY_NO_HIT && lane_hit < *hit)) {
+            *dist = lanes[lane];
+            *hit = lane_hit;
+        }
+    }
+
+    return i;
+}
+
+#elif defined(__SSE2__) && !defined(SDL_DISABLE_IMMINTRIN_H)
+
+#define RAY_SIMD_WIDTH 4
+
+/**
+ * Tests 4 table entries per iteration. Returns the index of the first entry that was not tested.
+ */
+static size_t ray_cast_simd(const struct wall_table_t *const restrict table,
+                            const size_t begin,
+                            const size_t end,
+                            const struct vec_t pos,
+                            const struct vec_t dir,
+                            float *const restrict dist,
+                            size_t *const restrict hit) {
+    const __m128 px = _mm_set1_ps(pos.x);
+    const __m128 py = _mm_set1_ps(pos.y);
+    const __m128 dx = _mm_set1_ps(dir.x);
+    const __m128 dy = _mm_set1_ps(dir.y);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 sign = _mm_set1_ps(-0.0F);
+    const __m128 eps = _mm_set1_ps(FLT_EPSILON);
+    const __m128i step = _mm_set1_epi32(RAY_SIMD_WIDTH);
+
+    __m128 best = _mm_set1_ps(*dist);
+    __m128i best_idx = _mm_set1_epi32(-1);
+    __m128i idx = _mm_add_epi32(_mm_set1_epi32((int) begin), _mm_setr_epi32(0, 1, 2, 3));
+    size_t i;
+
+    for (i = begin; i + RAY_SIMD_WIDTH <= end; i += RAY_SIMD_WIDTH) {
+        const __m128 ex = _mm_loadu_ps(&table->ex[i]);
+        const __m128 ey = _mm_loadu_ps(&table->ey[i]);
+        const __m128 wx = _mm_sub_ps(_mm_loadu_ps(&table->ax[i]), px);
+        const __m128 wy = _mm_sub_ps(_mm_loadu_ps(&table->ay[i]), py);
+
+        const __m128 den = _mm_sub_ps(_mm_mul_ps(ex, dy), _mm_mul_ps(ey, dx));
+        const __m128 den_sign = _mm_and_ps(den, sign);
+        const __m128 den_abs = _mm_andnot_ps(sign, den);
+
+        /* t = tn / den is in (0, 1) iff tn * sign(den) is in (0, |den|) */
+        const __m128 tn = _mm_xor_ps(_mm_sub_ps(_mm_mul_ps(wy, dx), _mm_mul_ps(wx, dy)), den_sign);
+        const __m128 u = _mm_div_ps(_mm_sub_ps(_mm_mul_ps(ex, wy), _mm_mul_ps(ey, wx)), den);
+
+        __m128 mask = _mm_cmpgt_ps(den_abs, eps);
+        mask = _mm_and_ps(mask, _mm_cmpgt_ps(tn, zero));
+        mask = _mm_and_ps(mask, _mm_cmplt_ps(tn, den_abs));
+        mask = _mm_and_ps(mask, _mm_cmpgt_ps(u, zero));
+        mask = _mm_and_ps(mask, _mm_cmplt_ps(u, best));
+
+        /* SSE2 has no blend instruction */
+        const __m128i imask = _mm_castps_si128(mask);
+        best = _mm_or_ps(_mm_and_ps(mask, u), _mm_andnot_ps(mask, best));
+        best_idx = _mm_or_si128(_mm_and_si128(imask, idx), _mm_andnot_si128(imask, best_idx));
+        idx = _mm_add_epi32(idx, step);
+    }
+
+    float lanes[RAY_SIMD_WIDTH];
+    int lane_idx[RAY_SIMD_WIDTH];
+
+    _mm_storeu_ps(lanes, best);
+    _mm_storeu_si128((__m128i *) lane_idx, best_idx);
+
+    for (size_t lane = 0; lane < RAY_SIMD_WIDTH; lane++) {
+        if (lane_idx[lane] == -1) {
+            continue;
+        }
+
+        const size_t lane_hit = (size_t) lane_idx[lane];
+
+        if (lanes[lane] < *dist || (lanes[lane] <= *dist && *hit != RAY_NO_HIT && lane_hit < *hit)) {
+            *dist = lanes[lane];
+            *hit = lane_hit;
+        }
+    }
+
+    return i;
+}
+
+#endif
+
+
 bool ray_intersection(const struct ray_t *const restrict ray,
                       const struct wall_t *const restrict wall,
                       struct vec_t *const restrict dst) {
@@ -35,3 +237,80 @@ bool ray_intersection(const struct ray_t *const restrict ray,
 
     return false;
 }
+
+int wall_table_alloc(struct wall_table_t *const table, const size_t count) {
+    *table = (struct wall_table_t) {0};
+
+    if (count == 0) {
+        return 0;
+    }
+
+    if (count > INT_MAX) {
+        logger_printf(LOG_LEVEL_ERROR, "too many walls: %zu\n", count);
+        return -1;
+    }
+
+    /* one block for all four coordinate arrays; owned by ax */
+    float *const coords = malloc(4 * count * sizeof *coords);
+    const struct wall_t **const walls = malloc(count * sizeof *walls);
+
+    if (coords == NULL || walls == NULL) {
+        logger_perror("malloc");
+        free(coords);
+        free(walls);
+        return -1;
+    }
+
+    table->ax = coords;
+    table->ay = coords + count;
+    table->ex = coords + 2 * count;
+    table->ey = coords + 3 * count;
+    table->walls = walls;
+    table->count = count;
+
+    return 0;
+}
+
+void wall_table_set(struct wall_table_t *const restrict table,
+                    const size_t i,
+                    const struct wall_t *const restrict wall) {
+    table->ax[i] = wall->a.x;
+    table->ay[i] = wall->a.y;
+    table->ex[i] = wall->b.x - wall->a.x;
+    table->ey[i] = wall->b.y - wall->a.y;
+    table->walls[i] = wall;
+}
+
+int wall_table_build(struct wall_table_t *const restrict table, const struct world_t *const restrict world) {
+    if (wall_table_alloc(table, world->nwalls) != 0) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < world->nwalls; i++) {
+        wall_table_set(table, i, &world->walls[i]);
+    }
+
+    return 0;
+}
+
+void wall_table_destroy(struct wall_table_t *const table) {
+    free(table->ax);
+    free(table->walls);
+    *table = (struct wall_table_t) {0};
+}
+
+size_t ray_cast(const struct wall_table_t *const restrict table,
+                const size_t begin,
+                const size_t end,
+                const struct vec_t pos,
+                const struct vec_t dir,
+                float *const restrict dist) {
+    size_t hit = RAY_NO_HIT;
+    size_t i = begin;
+
+#ifdef RAY_SIMD_WIDTH
+    i = ray_cast_simd(table, begin, end, pos, dir, dist, &hit);
+#endif
+
+    return ray_cast_scalar(table, i, end, pos, dir, dist, hit);
+}
@@ -3,6 +3,8 @@
 
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #include "ray.h"
 #include "vector.h"
@@ -10,34 +12,37 @@
 
 
 /**
- * @struct intersection_t
- * @bried A struct representing an intersection between a ray and a wall.
- *
- * The fields `wall` and `ray` are NULL if there is no intersection.
+ * @brief Value returned by ray_cast() if the ray does not hit any wall.
  */
-struct intersection_t {
-    struct vec_t pos;
-    float dist;
-    const struct wall_t *wall;
-};
+#define RAY_NO_HIT SIZE_MAX
+
 
 /**
  * @struct ray_t
- * @brief A struct representing a ray in 2D space.
- *
- * The `ray_t` struct represents a ray in 2D space. It contains a `pos` field representing the
- * origin of the ray, a `dir` field representing the direction of the ray, and a `has_intersection`
- * flag indicating whether the ray intersects with an object in the scene.
+ * @brief A struct representing a ray in 2D space, with an origin `pos` and a direction `dir`.
  *
- * If the ray intersects with an object, the `intersection` field will contain the coordinates of the
- * intersection point and the `intersection_dist` field will contain the distance between the origin of
- * the ray and the intersection point. If the ray does not intersect with any object in the scene, these
- * fields will be undefined.
+ * The rays cast from the camera and their hits are stored in a struct hits_t instead.
  */
 struct ray_t {
     struct vec_t pos;
     struct vec_t dir;
-    struct intersection_t intersection;
+};
+
+/**
+ * @struct wall_table_t
+ * @brief A packed structure-of-arrays copy of the wall endpoints.
+ *
+ * Each wall is stored as its first endpoint `a` and its extent `e = b - a`, so that the intersection
+ * kernels can load 4 (SSE2) or 8 (AVX2) walls at a time from contiguous memory, without chasing pointers
+ * through the world objects or branching on the object type.
+ */
+struct wall_table_t {
+    float *ax; /**< x-coordinates of the first endpoints. */
+    float *ay; /**< y-coordinates of the first endpoints. */
+    float *ex; /**< x-components of the wall extents (b - a). */
+    float *ey; /**< y-components of the wall extents (b - a). */
+    const struct wall_t **walls; /**< The walls the entries were built from. */
+    size_t count; /**< The number of entries in the table. */
 };
 
 
@@ -52,5 +57,61 @@ struct ray_t {
  */
 bool ray_intersection(const struct ray_t *ray, const struct wall_t *wall, struct vec_t *dst);
 
+/**
+ * @brief Allocates a wall table with the given number of entries. The entries are not initialized.
+ *
+ * @param table The table to allocate. Any previous contents are discarded without being freed.
+ * @param count The number of entries.
+ *
+ * @return 0 on success, -1 on error (the table is empty in this case).
+ */
+int wall_table_alloc(struct wall_table_t *table, size_t count);
+
+/**
+ * @brief Sets an entry of a wall table.
+ *
+ * @param table The wall table.
+ * @param i The index of the entry.
+ * @param wall The wall to store in the entry.
+ */
+void wall_table_set(struct wall_table_t *table, size_t i, const struct wall_t *wall);
+
+/**
+ * @brief Builds a wall table from all walls of a world, in the order of their handles.
+ *
+ * @param table The table to build. Any previous contents are discarded without being freed.
+ * @param world The world.
+ *
+ * @return 0 on success, -1 on error (the table is empty in this case).
+ */
+int wall_table_build(struct wall_table_t *table, const struct world_t *world);
+
+/**
+ * @brief Frees the memory owned by a wall table.
+ *
+ * @param table The table to destroy.
+ */
+void wall_table_destroy(struct wall_table_t *table);
+
+/**
+ * @brief Finds the nearest wall hit by a ray among the table entries in the range [@p begin, @p end).
+ *
+ * The walls are tested several at a time using SSE2 or AVX2 if they are available, falling back
+ * to a scalar loop otherwise. All code paths return identical results, which match ray_intersection()
+ * up to floating-point rounding. Ties are resolved in favor of the entry with the lower index.
+ *
+ * @param table The wall table.
+ * @param begin Index of the first entry to test.
+ * @param end Index one past the last entry to test.
+ * @param pos The origin of the ray.
+ * @param dir The direction of the ray. Must be a unit vector.
+ * @param dist A pointer to the distance to the nearest hit found so far, or INFINITY. Only hits nearer
+ *             than this are considered. Updated if a nearer hit is found.
+ *
+ * @return The index of the nearest wall hit by the ray, or RAY_NO_HIT if there is no hit nearer than @p dist.
+ */
+size_t ray_cast(const struct wall_table_t *table, size_t begin, size_t end,
+                struct vec_t pos, struct vec_t dir, float *dist);
+
 
 #endif // RAY_RAY_H
@@ -0,0 +1,413 @@
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include "logger.h"
+#include "math.h"
+
+#include "sector.h"
+
+
+/**
+ * Distance from the boundary of a sector within which a point is considered to lie inside the sector.
+ */
+#define SECTOR_EPSILON 0.01F
+
+/**
+ * Maximum number of portals passed by a ray.
+ */
+#define SECTOR_DEPTH_MAX 64
+
+
+/**
+ * @brief The state of sector_cast_rays().
+ */
+struct view_t {
+    const struct sector_graph_t *graph; /**< The sector graph. */
+    const struct hits_t *hits; /**< The rays. */
+    struct vec_t pos; /**< The common origin of the rays. */
+    float angle; /**< The angle of the first ray. */
+    float step; /**< The angle between two neighbouring rays. */
+    long period; /**< The number of steps in a full turn. */
+    size_t visited; /**< The number of sectors visited. */
+};
+
+
+static inline float cross(const struct vec_t a, const struct vec_t b) {
+    return a.x * b.y - a.y * b.x;
+}
+
+/**
+ * @brief Clips the segment a + t * (b - a), t in [0, 1], to a convex polygon with counterclockwise vertices.
+ * @return true if a part of the segment lies inside the polygon, false otherwise.
+ */
+static bool clip_segment(const struct vec_t *const vertices,
+                         const size_t nvertices,
+                         const struct vec_t a,
+                         const struct vec_t b) {
+    const struct vec_t d = vsub(b, a);
+    float t0 = 0.0F;
+    float t1 = 1.0F;
+
+    for (size_t i = 0; i < nvertices && t0 <= t1; i++) {
+        const struct vec_t v = vertices[i];
+        const struct vec_t e = vsub(vertices[(i + 1) % nvertices], v);
+        const float len = vlen(e);
+
+        /* signed distance of the point at t from the edge is c0 + t * c1; it must not be negative */
+        const float c0 = cross(e, vsub(a, v)) / len + SECTOR_EPSILON;
+        const float c1 = cross(e, d) / len;
+
+        if (c1 > 0.0F) {
+            t0 = fmaxf(t0, -c0 / c1);
+        } else if (c1 < 0.0F) {
+            t1 = fminf(t1, -c0 / c1);
+        } else if (c0 < 0.0F) {
+            return false;
+        }
+    }
+
+    return t0 <= t1;
+}
+
+static inline bool contains(const struct vec_t *const vertices, const size_t nvertices, const struct vec_t pos) {
+    return clip_segment(vertices, nvertices, pos, pos);
+}
+
+static size_t find_by_id(const struct sector_graph_t *const graph, const unsigned int id) {
+    for (size_t i = 0; i < graph->nsectors; i++) {
+        if (graph->sectors[i].id == id) {
+            return i;
+        }
+    }
+
+    return SIZE_MAX;
+}
+
+/**
+ * @brief Makes the vertices of a sector counterclockwise and checks that the sector is convex.
+ * @return 0 on success, -1 if the sector is not convex.
+ */
+static int orient_sector(struct vec_t *const vertices, const size_t nvertices) {
+    float area = 0.0F;
+
+    for (size_t i = 0; i < nvertices; i++) {
+        area += cross(vertices[i], vertices[(i + 1) % nvertices]);
+    }
+
+    if (area < 0.0F) {
+        for (size_t i = 0; i < nvertices / 2; i++) {
+            const struct vec_t tmp = vertices[i];
+            vertices[i] = vertices[nvertices - 1 - i];
+            vertices[nvertices - 1 - i] = tmp;
+        }
+    }
+
+    for (size_t i = 0; i < nvertices; i++) {
+        const struct vec_t e1 = vsub(vertices[(i + 1) % nvertices], vertices[i]);
+        const struct vec_t e2 = vsub(vertices[(i + 2) % nvertices], vertices[(i + 1) % nvertices]);
+
+        if (cross(e1, e2) < -SECTOR_EPSILON * vlen(e1) * vlen(e2)) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int add_sectors(struct sector_graph_t *const restrict graph, const struct world_t *const restrict world) {
+    size_t nvertices = 0;
+
+    for (size_t i = 0; i < world->nsectors; i++) {
+        const struct sector_t *const sector = &world->sectors[i];
+        struct sector_node_t *const node = &graph->sectors[graph->nsectors];
+
+        if (find_by_id(graph, sector->id) != SIZE_MAX) {
+            logger_printf(LOG_LEVEL_ERROR, "duplicate sector id: %u\n", sector->id);
+            return -1;
+        }
+
+        node->id = sector->id;
+        node->first_vertex = (uint32_t) nvertices;
+        node->nvertices = (uint32_t) sector->nvertices;
+        memcpy(&graph->vertices[nvertices], sector->vertices, sector->nvertices * sizeof *graph->vertices);
+
+        if (orient_sector(&graph->vertices[nvertices], sector->nvertices) != 0) {
+            logger_printf(LOG_LEVEL_ERROR, "sector %u is not convex\n", sector->id);
+            return -1;
+        }
+
+        nvertices += sector->nvertices;
+        graph->nsectors++;
+    }
+
+    return 0;
+}
+
+static int add_links(struct sector_graph_t *const restrict graph, const struct world_t *const restrict world) {
+    /* count the portals of every sector first, then fill them in using nlinks as a cursor */
+    for (size_t pass = 0; pass < 2; pass++) {
+        for (size_t i = 0; i < world->nportals; i++) {
+            const struct portal_t *const portal = &world->portals[i];
+            const size_t sides[2] = {find_by_id(graph, portal->sectors[0]), find_by_id(graph, portal->sectors[1])};
+
+            if (sides[0] == SIZE_MAX || sides[1] == SIZE_MAX || sides[0] == sides[1]) {
+                logger_printf(LOG_LEVEL_ERROR, "invalid portal between sectors %u and %u\n",
+                              portal->sectors[0], portal->sectors[1]);
+                return -1;
+            }
+
+            for (size_t side = 0; side < 2; side++) {
+                struct sector_node_t *const node = &graph->sectors[sides[side]];
+
+                if (pass == 1) {
+                    graph->links[node->first_link + node->nlinks] = (struct sector_link_t) {
+                            .a = portal->a,
+                            .b = portal->b,
+                            .target = (uint32_t) sides[1 - side]
+                    };
+                }
+
+                node->nlinks++;
+            }
+        }
+
+        for (size_t i = 0, first = 0; pass == 0 && i < graph->nsectors; i++) {
+            graph->sectors[i].first_link = (uint32_t) first;
+            first += graph->sectors[i].nlinks;
+            graph->sectors[i].nlinks = 0;
+        }
+    }
+
+    return 0;
+}
+
+static int add_walls(struct sector_graph_t *const restrict graph, const struct wall_table_t *const restrict walls) {
+    size_t nrefs = 0;
+
+    for (size_t pass = 0; pass < 2; pass++) {
+        nrefs = 0;
+
+        for (size_t i = 0; i < graph->nsectors; i++) {
+            struct sector_node_t *const node = &graph->sectors[i];
+            const struct vec_t *const vertices = &graph->vertices[node->first_vertex];
+
+            node->first_wall = (uint32_t) nrefs;
+
+            for (size_t j = 0; j < walls->count; j++) {
+                const struct vec_t a = {walls->ax[j], walls->ay[j]};
+                const struct vec_t b = {walls->ax[j] + walls->ex[j], walls->ay[j] + walls->ey[j]};
+
+                if (!clip_segment(vertices, node->nvertices, a, b)) {
+                    continue;
+                }
+
+                if (pass == 1) {
+                    graph->ids[nrefs] = (uint32_t) j;
+                    wall_table_set(&graph->table, nrefs, walls->walls[j]);
+                }
+
+                nrefs++;
+            }
+
+            node->nwalls = (uint32_t) (nrefs - node->first_wall);
+        }
+
+        if (pass == 0 && nrefs > 0) {
+            graph->ids = malloc(nrefs * sizeof *graph->ids);
+
+            if (graph->ids == NULL || nrefs > INT_MAX || wall_table_alloc(&graph->table, nrefs) != 0) {
+                logger_print(LOG_LEVEL_ERROR, "unable to allocate sector walls");
+                return -1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+int sector_graph_build(struct sector_graph_t *const restrict graph,
+                       const struct world_t *const restrict world,
+                       const struct wall_table_t *const restrict walls) {
+    size_t nvertices = 0;
+
+    memset(graph, 0, sizeof *graph);
+
+    for (size_t i = 0; i < world->nsectors; i++) {
+        nvertices += world->sectors[i].nvertices;
+    }
+
+    if (world->nsectors == 0) {
+        return 0;
+    }
+
+    graph->sectors = calloc(world->nsectors, sizeof *graph->sectors);
+    graph->vertices = malloc(nvertices * sizeof *graph->vertices);
+    graph->links = malloc(SDL_max(2 * world->nportals, 1) * sizeof *graph->links);
+
+    if (graph->sectors == NULL || graph->vertices == NULL || graph->links == NULL) {
+        logger_perror("malloc");
+        sector_graph_destroy(graph);
+        return -1;
+    }
+
+    if (add_sectors(graph, world) != 0 || add_links(graph, world) != 0 ||
+        add_walls(graph, walls) != 0) {
+        sector_graph_destroy(graph);
+        return -1;
+    }
+
+    return 0;
+}
+
+void sector_graph_destroy(struct sector_graph_t *const graph) {
+    wall_table_destroy(&graph->table);
+    free(graph->sectors);
+    free(graph->vertices);
+    free(graph->links);
+    free(graph->ids);
+    memset(graph, 0, sizeof *graph);
+}
+
+size_t sector_find(const struct sector_graph_t *const graph, const struct vec_t pos) {
+    for (size_t i = 0; i < graph->nsectors; i++) {
+        const struct sector_node_t *const node = &graph->sectors[i];
+
+        if (contains(&graph->vertices[node->first_vertex], node->nvertices, pos)) {
+            return i;
+        }
+    }
+
+    return SIZE_MAX;
+}
+
+static void visit(struct view_t *view, uint32_t index, long first, long last, uint32_t from, size_t depth);
+
+/**
+ * @brief Visits the sector behind a portal with the rays of the window [first, last] passing through it.
+ */
+static void visit_link(struct view_t *const view,
+                       const struct sector_link_t *const link,
+                       const uint32_t from,
+                       const long first,
+                       const long last,
+                       const size_t depth) {
+    /* the portal is widened by SECTOR_EPSILON at both ends, as a ray grazing the wall next to one of them may
+     * slip past it; rays through the widened part are only stopped by walls inside the sector behind */
+    const struct vec_t margin = vmul(vnorm_weak(vsub(link->b, link->a)), SECTOR_EPSILON);
+    const struct vec_t a = vsub(vsub(link->a, margin), view->pos);
+    const struct vec_t b = vsub(vadd(link->b, margin), view->pos);
+    const float area = cross(a, b);
+
+    /* the origin lies on the line of the portal, so the portal does not narrow the window */
+    if (isclose(area, 0.0F)) {
+        visit(view, link->target, first, last, from, depth + 1);
+        return;
+    }
+
+    const struct vec_t start = area > 0.0F ? a : b;
+    const float arc = atan2f(fabsf(area), a.x * b.x + a.y * b.y);
+    float offset = fmodf(atan2f(start.y, start.x) - view->angle, 2.0F * PI);
+
+    if (offset < 0.0F) {
+        offset += 2.0F * PI;
+    }
+
+    const long begin = (long) ceilf(offset / view->step);
+    const long end = (long) floorf((offset + arc) / view->step);
+
+    /* the rays through the portal may wrap around the full turn */
+    for (long shift = 0; shift <= end; shift += view->period) {
+        const long lo = SDL_max(begin - shift, first);
+        const long hi = SDL_min(end - shift, last);
+
+        if (lo <= hi) {
+            visit(view, link->target, lo, hi, from, depth + 1);
+        }
+    }
+}
+
+/**
+ * @brief Casts the rays of the window [first, last] against the walls of a sector, then visits the sectors
+ *        visible through its portals.
+ */
+static void visit(struct view_t *const view,
+                  const uint32_t index,
+                  const long first,
+                  const long last,
+                  const uint32_t from,
+                  const size_t depth) {
+    const struct sector_graph_t *const graph = view->graph;
+    const struct sector_node_t *const node = &graph->sectors[index];
+    const struct vec_t *const vertices = &graph->vertices[node->first_vertex];
+    size_t open = 0;
+
+    view->visited++;
+
+    for (long i = first; i <= last; i++) {
+        const struct hits_t *const hits = view->hits;
+
+        if (hits->wall[i] != HITS_NONE) {
+            continue;
+        }
+
+        float dist = INFINITY;
+        const size_t hit = ray_cast(&graph->table, node->first_wall, node->first_wall + node->nwalls,
+                                    view->pos, hits->dir[i], &dist);
+
+        hits->tested[i] += (uint32_t) node->nwalls;
+
+        if (hit != RAY_NO_HIT) {
+            const struct vec_t pos = vadd(view->pos, vmul(hits->dir[i], dist));
+
+            /* a wall overlapping several sectors may be hit outside this one, behind one of its portals */
+            if (contains(vertices, node->nvertices, pos)) {
+                hits->dist[i] = dist;
+                hits->wall[i] = graph->ids[hit];
+                continue;
+            }
+        }
+
+        open++;
+    }
+
+    if (open == 0 || depth + 1 >= SECTOR_DEPTH_MAX) {
+        return;
+    }
+
+    for (size_t i = node->first_link; i < node->first_link + node->nlinks; i++) {
+        const struct sector_link_t *const link = &graph->links[i];
+
+        if (link->target != from) {
+            visit_link(view, link, index, first, last, depth);
+        }
+    }
+}
+
+size_t sector_cast_rays(const struct sector_graph_t *const restrict graph,
+                        const struct hits_t *const restrict hits,
+                        const float angle,
+                        const float step) {
+    if (hits->count == 0) {
+        return 0;
+    }
+
+    const size_t start = sector_find(graph, hits->pos);
+
+    if (start == SIZE_MAX) {
+        return 0;
+    }
+
+    struct view_t view = {
+            .graph = graph,
+            .hits = hits,
+            .pos = hits->pos,
+            .angle = angle,
+            .step = step,
+            .period = lroundf(2.0F * PI / step)
+    };
+
+    hits_clear(hits);
+    visit(&view, (uint32_t) start, 0, (long) hits->count - 1, UINT32_MAX, 0);
+    return view.visited;
+}
@@ -0,0 +1,93 @@
+#ifndef RAY_SECTOR_H
+#define RAY_SECTOR_H
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hits.h"
+#include "ray.h"
+#include "vector.h"
+#include "world.h"
+
+
+/**
+ * @brief A portal as seen from one of the sectors it connects.
+ */
+struct sector_link_t {
+    struct vec_t a; /**< The first endpoint of the portal. */
+    struct vec_t b; /**< The second endpoint of the portal. */
+    uint32_t target; /**< The index of the sector on the other side of the portal. */
+};
+
+/**
+ * @brief A convex sector of the world and its connections to the neighbouring sectors.
+ */
+struct sector_node_t {
+    unsigned int id; /**< The identifier of the sector in the world specification. */
+    uint32_t first_vertex; /**< The first vertex of the sector, in counterclockwise order. */
+    uint32_t nvertices; /**< The number of vertices of the sector. */
+    uint32_t first_wall; /**< The first table entry of the walls overlapping the sector. */
+    uint32_t nwalls; /**< The number of walls overlapping the sector. */
+    uint32_t first_link; /**< The first portal leading out of the sector. */
+    uint32_t nlinks; /**< The number of portals leading out of the sector. */
+};
+
+/**
+ * @brief The graph of the sectors in the world, connected by portals.
+ */
+struct sector_graph_t {
+    struct sector_node_t *sectors; /**< The sectors. */
+    size_t nsectors; /**< The number of sectors. */
+    struct vec_t *vertices; /**< The vertices of all sectors. */
+    struct sector_link_t *links; /**< The portals leading out of all sectors. */
+    uint32_t *ids; /**< For every table entry, the index of the wall in the table the graph was built from. */
+    struct wall_table_t table; /**< The walls overlapping each sector. */
+};
+
+
+/**
+ * @brief Builds the sector graph from the sectors and portals in the world.
+ *
+ * Every wall is assigned to each sector it overlaps. Sectors must be convex and have unique identifiers;
+ * portals must refer to existing sectors. A world without sectors yields an empty graph.
+ *
+ * @param graph The graph to build.
+ * @param world The world.
+ * @param walls The walls in the world.
+ * @return 0 on success, -1 on error (the graph is empty in this case).
+ */
+int sector_graph_build(struct sector_graph_t *graph, const struct world_t *world, const struct wall_table_t *walls);
+
+/**
+ * @brief Frees the memory owned by a sector graph.
+ * @param graph The graph to destroy.
+ */
+void sector_graph_destroy(struct sector_graph_t *graph);
+
+/**
+ * @brief Finds the sector containing a point.
+ * @return The index of the sector, or SIZE_MAX if the point is outside all sectors.
+ */
+size_t sector_find(const struct sector_graph_t *graph, struct vec_t pos);
+
+/**
+ * @brief Casts a fan of rays from a common origin through the sectors visible from it.
+ *
+ * Starting in the sector containing the origin, the walls of each sector are tested against the rays in
+ * the angular window through which the sector is seen. Each portal narrows the window to the rays passing
+ * through it before the sector behind it is visited, so only the walls of visible sectors are tested.
+ *
+ * @param graph The sector graph.
+ * @param hits The rays. The direction of ray i must be at the angle @p angle + i * @p step (in radians). The hits
+ *             and the numbers of tested walls are overwritten; the hit parameters are not computed. The rays must
+ *             not span more than a full turn.
+ * @param angle The angle of the first ray.
+ * @param step The angle between two neighbouring rays. Must be positive.
+ * @return The number of sectors visited, or 0 if the origin is outside all sectors (the rays are not cast
+ *         in this case).
+ */
+size_t sector_cast_rays(const struct sector_graph_t *graph, const struct hits_t *hits, float angle, float step);
+
+
+#endif //RAY_SECTOR_H
@@ -0,0 +1,118 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "logger.h"
+
+#include "span.h"
+
+
+/**
+ * Number of values interpolated across a run: the top edge, the bottom edge and the three color channels.
+ */
+#define SPAN_VALUES 5
+
+
+static void get_values(const struct span_column_t *const column, float values[SPAN_VALUES]) {
+    values[0] = column->top;
+    values[1] = column->bottom;
+    values[2] = (float) column->color.r;
+    values[3] = (float) column->color.g;
+    values[4] = (float) column->color.b;
+}
+
+int span_create(struct span_t *const span, const size_t ncolumns) {
+    memset(span, 0, sizeof *span);
+
+    span->columns = malloc(SDL_max(ncolumns, 1) * sizeof *span->columns);
+    span->runs = malloc(SDL_max(ncolumns, 1) * sizeof *span->runs);
+
+    if (span->columns == NULL || span->runs == NULL) {
+        logger_print(LOG_LEVEL_ERROR, "unable to allocate span buffers");
+        span_destroy(span);
+        return -1;
+    }
+
+    span->ncolumns = ncolumns;
+    return 0;
+}
+
+void span_destroy(struct span_t *const span) {
+    free(span->columns);
+    free(span->runs);
+    memset(span, 0, sizeof *span);
+}
+
+/**
+ * @brief Extends a run starting at @p first as far as its trapezoid stays within the tolerances.
+ * @return The last column of the run.
+ */
+static size_t extend_run(const struct span_column_t *const columns, const size_t first, const size_t ncolumns,
+                         const float tolerances[SPAN_VALUES]) {
+    float start[SPAN_VALUES];
+    float lo[SPAN_VALUES];
+    float hi[SPAN_VALUES];
+    size_t last = first;
+
+    get_values(&columns[first], start);
+
+    for (size_t i = 0; i < SPAN_VALUES; i++) {
+        lo[i] = -INFINITY;
+        hi[i] = INFINITY;
+    }
+
+    for (size_t j = first + 1; j < ncolumns && columns[j].wall == columns[first].wall; j++) {
+        const float d = (float) (j - first);
+        float values[SPAN_VALUES];
+        bool fits = true;
+
+        get_values(&columns[j], values);
+
+        /* the slope ending at this column must pass close enough to every column in between */
+        for (size_t i = 0; i < SPAN_VALUES; i++) {
+            const float slope = (values[i] - start[i]) / d;
+
+            if (slope < lo[i] || slope > hi[i]) {
+                fits = false;
+            }
+        }
+
+        if (!fits) {
+            break;
+        }
+
+        for (size_t i = 0; i < SPAN_VALUES; i++) {
+            lo[i] = fmaxf(lo[i], (values[i] - tolerances[i] - start[i]) / d);
+            hi[i] = fminf(hi[i], (values[i] + tolerances[i] - start[i]) / d);
+        }
+
+        last = j;
+    }
+
+    return last;
+}
+
+size_t span_coalesce(struct span_t *const span, const size_t ncolumns, const float tolerance,
+                     const float color_tolerance) {
+    const float tolerances[SPAN_VALUES] = {tolerance, tolerance, color_tolerance, color_tolerance, color_tolerance};
+
+    span->nruns = 0;
+
+    if (ncolumns > span->ncolumns) {
+        return 0;
+    }
+
+    for (size_t first = 0; first < ncolumns;) {
+        if (span->columns[first].wall == NULL) {
+            first++;
+            continue;
+        }
+
+        const size_t last = extend_run(span->columns, first, ncolumns, tolerances);
+
+        span->runs[span->nruns++] = (struct span_run_t) {.first = first, .last = last};
+        first = last + 1;
+    }
+
+    return span->nruns;
+}
@@ -0,0 +1,76 @@
+#ifndef RAY_SPAN_H
+#define RAY_SPAN_H
+
+
+#include <stddef.h>
+
+#include <SDL2/SDL.h>
+
+#include "world.h"
+
+
+/**
+ * @brief The wall stripe drawn in a screen column.
+ */
+struct span_column_t {
+    const struct wall_t *wall; /**< The wall hit in the column, or NULL if the column is empty. */
+    float top; /**< The top edge of the stripe. */
+    float bottom; /**< The bottom edge of the stripe. */
+    SDL_Color color; /**< The shaded color of the stripe. */
+};
+
+/**
+ * @brief A run of neighbouring columns on the same wall which can be drawn as a single trapezoid.
+ *
+ * The top edge, the bottom edge and the color of the trapezoid are interpolated linearly between the centers of
+ * the first and the last column, and extrapolated by half a column to the edges of the run.
+ */
+struct span_run_t {
+    size_t first; /**< The first column of the run. */
+    size_t last; /**< The last column of the run. */
+};
+
+/**
+ * @brief Buffers of the coalescing of wall stripes into trapezoids, allocated once.
+ */
+struct span_t {
+    struct span_column_t *columns; /**< The stripes of the current frame, filled in by the caller. */
+    struct span_run_t *runs; /**< The runs of the current frame, in screen order. */
+    size_t nruns; /**< The number of runs of the current frame. */
+    size_t ncolumns; /**< The maximum number of columns. */
+};
+
+
+/**
+ * @brief Allocates the buffers of the coalescing.
+ *
+ * @param span The coalescing to initialize.
+ * @param ncolumns The maximum number of columns.
+ * @return 0 on success, -1 on error.
+ */
+int span_create(struct span_t *span, size_t ncolumns);
+
+/**
+ * @brief Frees the buffers of the coalescing.
+ * @param span The coalescing to destroy.
+ */
+void span_destroy(struct span_t *span);
+
+/**
+ * @brief Merges the stripes of neighbouring columns on the same wall into runs.
+ *
+ * A run is extended as long as the trapezoid between its first and its last column stays within the tolerances
+ * of every column in between. The admissible slopes of the trapezoid are narrowed down column by column, so each
+ * column is only visited once.
+ *
+ * @param span The coalescing, with the stripes of the first @p ncolumns columns filled in.
+ * @param ncolumns The number of columns.
+ * @param tolerance The maximum distance, in pixels, between an edge of a stripe and the edge of its trapezoid.
+ * @param color_tolerance The maximum difference of any channel of the color of a stripe and the interpolated
+ *                        color of its trapezoid.
+ * @return The number of runs, or 0 if there are no stripes or too many columns.
+ */
+size_t span_coalesce(struct span_t *span, size_t ncolumns, float tolerance, float color_tolerance);
+
+
+#endif //RAY_SPAN_H
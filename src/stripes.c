@@ -0,0 +1,85 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "logger.h"
+
+#include "stripes.h"
+
+
+int stripes_create(struct stripes_t *const stripes, const size_t ncolumns) {
+    const size_t n = SDL_max(ncolumns, 1);
+
+    memset(stripes, 0, sizeof *stripes);
+
+    stripes->walls = malloc(n * sizeof *stripes->walls);
+    stripes->dist = malloc(n * sizeof *stripes->dist);
+    stripes->correction = malloc(n * sizeof *stripes->correction);
+    stripes->depth = malloc(n * sizeof *stripes->depth);
+    stripes->height = malloc(n * sizeof *stripes->height);
+    stripes->top = malloc(n * sizeof *stripes->top);
+    stripes->level = malloc(n * sizeof *stripes->level);
+    stripes->shade = malloc(n * sizeof *stripes->shade);
+
+    if (stripes->walls == NULL || stripes->dist == NULL || stripes->correction == NULL || stripes->depth == NULL ||
+        stripes->height == NULL || stripes->top == NULL || stripes->level == NULL || stripes->shade == NULL) {
+        logger_print(LOG_LEVEL_ERROR, "unable to allocate stripe buffers");
+        stripes_destroy(stripes);
+        return -1;
+    }
+
+    stripes->ncolumns = ncolumns;
+    return 0;
+}
+
+void stripes_destroy(struct stripes_t *const stripes) {
+    free(stripes->walls);
+    free(stripes->dist);
+    free(stripes->correction);
+    free(stripes->depth);
+    free(stripes->height);
+    free(stripes->top);
+    free(stripes->level);
+    free(stripes->shade);
+    memset(stripes, 0, sizeof *stripes);
+}
+
+static void correct_depth(const float *const restrict dist, const float *const restrict correction,
+                          float *const restrict depth, const size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        depth[i] = dist[i] * correction[i];
+    }
+}
+
+static void project_height(const float *const restrict depth, float *const restrict height,
+                           float *const restrict top, const size_t n, const float scale, const float horizon) {
+    for (size_t i = 0; i < n; i++) {
+        height[i] = scale / depth[i];
+        top[i] = horizon - height[i] / 2.0F;
+    }
+}
+
+/**
+ * @brief Looks up the shades of the columns; the only pass which cannot be vectorized, as it gathers from the
+ *        colormap.
+ */
+static void look_up_shades(const struct colormap_t *const restrict colormap,
+                           const struct wall_t *const *const restrict walls,
+                           const uint32_t *const restrict level,
+                           Uint32 *const restrict shade,
+                           const size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (walls[i] != NULL) {
+            shade[i] = colormap->shades[level[i] * colormap->ncolors + walls[i]->shade];
+        }
+    }
+}
+
+void stripes_shade(struct stripes_t *const restrict stripes, const size_t ncolumns,
+                   const struct colormap_t *const restrict colormap, const float scale, const float horizon) {
+    const size_t n = SDL_min(ncolumns, stripes->ncolumns);
+
+    correct_depth(stripes->dist, stripes->correction, stripes->depth, n);
+    project_height(stripes->depth, stripes->height, stripes->top, n, scale, horizon);
+    colormap_levels(stripes->dist, stripes->level, n);
+    look_up_shades(colormap, stripes->walls, stripes->level, stripes->shade, n);
+}
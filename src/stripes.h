@@ -0,0 +1,61 @@
+#ifndef RAY_STRIPES_H
+#define RAY_STRIPES_H
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <SDL2/SDL.h>
+
+#include "colormap.h"
+#include "world.h"
+
+
+/**
+ * @brief The wall stripes of the screen columns of a frame, one array per quantity.
+ *
+ * The inputs of every column are gathered from the rays first. stripes_shade() then derives the other
+ * quantities in separate passes over whole arrays, which the compiler can vectorize, before anything is drawn.
+ */
+struct stripes_t {
+    const struct wall_t **walls; /**< The wall hit in every column, or NULL if the column is empty. */
+    float *dist; /**< The distance to the wall of every column. */
+    float *correction; /**< The factor applied to the distance of every column for the fish-eye correction. */
+    float *depth; /**< The distance of every column after the fish-eye correction. */
+    float *height; /**< The height of the stripe of every column. */
+    float *top; /**< The top edge of the stripe of every column. */
+    uint32_t *level; /**< The light level of every column in the colormap. */
+    Uint32 *shade; /**< The shaded color of every column, as an ARGB8888 pixel; undefined for empty columns. */
+    size_t ncolumns; /**< The maximum number of columns. */
+};
+
+
+/**
+ * @brief Allocates the arrays of the stripes.
+ *
+ * @param stripes The stripes to initialize.
+ * @param ncolumns The maximum number of columns.
+ * @return 0 on success, -1 on error.
+ */
+int stripes_create(struct stripes_t *stripes, size_t ncolumns);
+
+/**
+ * @brief Frees the arrays of the stripes.
+ * @param stripes The stripes to destroy.
+ */
+void stripes_destroy(struct stripes_t *stripes);
+
+/**
+ * @brief Computes the depth, the height, the top edge, the light level and the shade of the stripes.
+ *
+ * @param stripes The stripes, with the walls, distances and corrections of the first @p ncolumns columns filled in.
+ * @param ncolumns The number of columns, at most the maximum number of columns.
+ * @param colormap The colormap the walls were assigned their colors in.
+ * @param scale The height of a stripe at a depth of one unit.
+ * @param horizon The row the stripes are centered on.
+ */
+void stripes_shade(struct stripes_t *stripes, size_t ncolumns, const struct colormap_t *colormap, float scale,
+                   float horizon);
+
+
+#endif //RAY_STRIPES_H
@@ -0,0 +1,304 @@
+#include <math.h>
+#include <stdlib.h>
+
+#include "logger.h"
+#include "math.h"
+
+#include "sweep.h"
+
+
+/**
+ * Angle within which a ray is considered to lie on the edge between two spans, in radians.
+ */
+#define SWEEP_EPSILON 1e-4F
+
+
+/**
+ * @brief Computes the distance to a wall along the ray from the origin of the sweep at the given angle.
+ * @return The distance, or INFINITY if the ray is parallel to the wall.
+ */
+static float wall_dist(const struct sweep_t *const sweep, const size_t wall, const float angle) {
+    const struct wall_table_t *const walls = sweep->walls;
+    const struct vec_t dir = vfromangle(sweep->angle + angle);
+    const float wx = walls->ax[wall] - sweep->pos.x;
+    const float wy = walls->ay[wall] - sweep->pos.y;
+    const float den = walls->ex[wall] * dir.y - walls->ey[wall] * dir.x;
+
+    if (isclose(den, 0.0F)) {
+        return INFINITY;
+    }
+
+    return (walls->ex[wall] * wy - walls->ey[wall] * wx) / den;
+}
+
+/**
+ * @brief Decides which of two pieces crossed by the sweep line is nearer to the origin.
+ *
+ * Since walls do not cross, the order of two pieces is the same everywhere in the angle they have in
+ * common; the middle of that angle is used to stay clear of shared endpoints.
+ */
+static bool nearer(const struct sweep_t *const sweep, const uint32_t p, const uint32_t q) {
+    const struct sweep_piece_t *const a = &sweep->pieces[p];
+    const struct sweep_piece_t *const b = &sweep->pieces[q];
+    const float mid = (fmaxf(a->lo, b->lo) + fminf(a->hi, b->hi)) / 2.0F;
+
+    return wall_dist(sweep, a->wall, mid) < wall_dist(sweep, b->wall, mid);
+}
+
+static void heap_swap(struct sweep_t *const sweep, const size_t i, const size_t j) {
+    const uint32_t tmp = sweep->heap[i];
+
+    sweep->heap[i] = sweep->heap[j];
+    sweep->heap[j] = tmp;
+    sweep->slots[sweep->heap[i]] = (uint32_t) i;
+    sweep->slots[sweep->heap[j]] = (uint32_t) j;
+}
+
+static void sift_up(struct sweep_t *const sweep, size_t i) {
+    while (i > 0 && nearer(sweep, sweep->heap[i], sweep->heap[(i - 1) / 2])) {
+        heap_swap(sweep, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+static void sift_down(struct sweep_t *const sweep, size_t i) {
+    for (;;) {
+        const size_t left = 2 * i + 1;
+        const size_t right = left + 1;
+        size_t best = i;
+
+        if (left < sweep->nheap && nearer(sweep, sweep->heap[left], sweep->heap[best])) {
+            best = left;
+        }
+
+        if (right < sweep->nheap && nearer(sweep, sweep->heap[right], sweep->heap[best])) {
+            best = right;
+        }
+
+        if (best == i) {
+            return;
+        }
+
+        heap_swap(sweep, i, best);
+        i = best;
+    }
+}
+
+static void heap_push(struct sweep_t *const sweep, const uint32_t piece) {
+    sweep->heap[sweep->nheap] = piece;
+    sweep->slots[piece] = (uint32_t) sweep->nheap;
+    sift_up(sweep, sweep->nheap++);
+}
+
+static void heap_remove(struct sweep_t *const sweep, const uint32_t piece) {
+    const size_t i = sweep->slots[piece];
+
+    if (i == SWEEP_NONE) {
+        return;
+    }
+
+    sweep->slots[piece] = SWEEP_NONE;
+
+    if (i == --sweep->nheap) {
+        return;
+    }
+
+    const uint32_t moved = sweep->heap[sweep->nheap];
+
+    sweep->heap[i] = moved;
+    sweep->slots[moved] = (uint32_t) i;
+    sift_up(sweep, i);
+    sift_down(sweep, sweep->slots[moved]);
+}
+
+static int compare_events(const void *const a, const void *const b) {
+    const struct sweep_event_t *const x = a;
+    const struct sweep_event_t *const y = b;
+
+    return (x->angle > y->angle) - (x->angle < y->angle);
+}
+
+static void add_piece(struct sweep_t *const sweep, const size_t wall, const float lo, const float hi,
+                      const float span) {
+    const uint32_t piece = (uint32_t) sweep->npieces++;
+
+    sweep->pieces[piece] = (struct sweep_piece_t) {.lo = lo, .hi = hi, .wall = (uint32_t) wall};
+    sweep->slots[piece] = SWEEP_NONE;
+    sweep->events[sweep->nevents++] = (struct sweep_event_t) {.angle = lo, .piece = piece, .start = true};
+
+    if (hi < span) {
+        sweep->events[sweep->nevents++] = (struct sweep_event_t) {.angle = hi, .piece = piece, .start = false};
+    }
+}
+
+/**
+ * @brief Splits the walls into pieces within the swept angle and creates their events.
+ */
+static void add_pieces(struct sweep_t *const sweep, const float span) {
+    const struct wall_table_t *const walls = sweep->walls;
+
+    for (size_t i = 0; i < walls->count; i++) {
+        const struct vec_t a = {walls->ax[i] - sweep->pos.x, walls->ay[i] - sweep->pos.y};
+        const struct vec_t b = {a.x + walls->ex[i], a.y + walls->ey[i]};
+        const float area = a.x * b.y - a.y * b.x;
+
+        /* the wall is seen edge-on */
+        if (isclose(area, 0.0F)) {
+            continue;
+        }
+
+        const struct vec_t start = area > 0.0F ? a : b;
+        const float arc = atan2f(fabsf(area), a.x * b.x + a.y * b.y);
+        float lo = fmodf(atan2f(start.y, start.x) - sweep->angle, 2.0F * PI);
+
+        if (lo < 0.0F) {
+            lo += 2.0F * PI;
+        }
+
+        const float hi = lo + arc;
+
+        if (lo < span) {
+            add_piece(sweep, i, lo, fminf(hi, 2.0F * PI), span);
+        }
+
+        /* the wall wraps around the first ray */
+        if (hi > 2.0F * PI) {
+            add_piece(sweep, i, 0.0F, hi - 2.0F * PI, span);
+        }
+    }
+}
+
+static void add_span(struct sweep_t *const sweep, const float angle) {
+    const uint32_t wall = sweep->nheap == 0 ? SWEEP_NONE : sweep->pieces[sweep->heap[0]].wall;
+
+    if (sweep->nspans > 0 && sweep->spans[sweep->nspans - 1].wall == wall) {
+        return;
+    }
+
+    sweep->spans[sweep->nspans++] = (struct sweep_span_t) {.angle = angle, .wall = wall};
+}
+
+int sweep_create(struct sweep_t *const sweep, const size_t nwalls) {
+    const size_t npieces = SDL_max(2 * nwalls, 1);
+
+    memset(sweep, 0, sizeof *sweep);
+    sweep->pieces = malloc(npieces * sizeof *sweep->pieces);
+    sweep->events = malloc(2 * npieces * sizeof *sweep->events);
+    sweep->heap = malloc(npieces * sizeof *sweep->heap);
+    sweep->slots = malloc(npieces * sizeof *sweep->slots);
+    sweep->spans = malloc((2 * npieces + 1) * sizeof *sweep->spans);
+
+    if (sweep->pieces == NULL || sweep->events == NULL || sweep->heap == NULL || sweep->slots == NULL ||
+        sweep->spans == NULL || nwalls > UINT32_MAX / 4) {
+        logger_print(LOG_LEVEL_ERROR, "unable to allocate sweep buffers");
+        sweep_destroy(sweep);
+        return -1;
+    }
+
+    sweep->capacity = nwalls;
+    return 0;
+}
+
+void sweep_destroy(struct sweep_t *const sweep) {
+    free(sweep->pieces);
+    free(sweep->events);
+    free(sweep->heap);
+    free(sweep->slots);
+    free(sweep->spans);
+    memset(sweep, 0, sizeof *sweep);
+}
+
+/**
+ * @brief Tests a ray against the wall visible in a span, keeping the hit if it is nearer than @p dist.
+ */
+static void cast_span(const struct sweep_t *const restrict sweep,
+                      const size_t span,
+                      const struct hits_t *const restrict hits,
+                      const size_t i,
+                      float *const restrict dist) {
+    const uint32_t wall = sweep->spans[span].wall;
+
+    if (wall == SWEEP_NONE) {
+        return;
+    }
+
+    hits->tested[i]++;
+
+    if (ray_cast(sweep->walls, wall, wall + 1, hits->pos, hits->dir[i], dist) == RAY_NO_HIT) {
+        return;
+    }
+
+    hits->dist[i] = *dist;
+    hits->wall[i] = wall;
+}
+
+size_t sweep_cast_rays(struct sweep_t *const restrict sweep,
+                       const struct wall_table_t *const restrict walls,
+                       const struct hits_t *const restrict hits,
+                       const float angle,
+                       const float step) {
+    if (hits->count == 0 || walls->count > sweep->capacity) {
+        return 0;
+    }
+
+    /* the sweep starts a little before the first ray, so that the first ray has a span on either side of it */
+    const float span = (float) hits->count * step + SWEEP_EPSILON;
+
+    sweep->walls = walls;
+    sweep->pos = hits->pos;
+    sweep->angle = angle - SWEEP_EPSILON;
+    sweep->npieces = 0;
+    sweep->nevents = 0;
+    sweep->nheap = 0;
+    sweep->nspans = 0;
+
+    add_pieces(sweep, span);
+    qsort(sweep->events, sweep->nevents, sizeof *sweep->events, compare_events);
+    add_span(sweep, 0.0F);
+
+    for (size_t i = 0; i < sweep->nevents;) {
+        const float event_angle = sweep->events[i].angle;
+
+        /* the polygon only changes once all events at the same angle are processed */
+        for (; i < sweep->nevents && !(sweep->events[i].angle > event_angle); i++) {
+            if (sweep->events[i].start) {
+                heap_push(sweep, sweep->events[i].piece);
+            } else {
+                heap_remove(sweep, sweep->events[i].piece);
+            }
+        }
+
+        if (event_angle > 0.0F) {
+            add_span(sweep, event_angle);
+        } else {
+            sweep->nspans = 0;
+            add_span(sweep, 0.0F);
+        }
+    }
+
+    hits_clear(hits);
+
+    for (size_t i = 0, j = 0; i < hits->count; i++) {
+        const float offset = (float) i * step + SWEEP_EPSILON;
+        const size_t prev = j;
+        float dist = INFINITY;
+
+        while (j + 1 < sweep->nspans && !(sweep->spans[j + 1].angle > offset)) {
+            j++;
+        }
+
+        hits->edge[i] = i > 0 && j != prev;
+        cast_span(sweep, j, hits, i, &dist);
+
+        /* on the edge of a span, rounding errors decide which side the ray falls on, so try both */
+        if (j > 0 && offset - sweep->spans[j].angle < SWEEP_EPSILON) {
+            cast_span(sweep, j - 1, hits, i, &dist);
+        }
+
+        if (j + 1 < sweep->nspans && sweep->spans[j + 1].angle - offset < SWEEP_EPSILON) {
+            cast_span(sweep, j + 1, hits, i, &dist);
+        }
+    }
+
+    return sweep->nspans;
+}
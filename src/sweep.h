@@ -0,0 +1,104 @@
+#ifndef RAY_SWEEP_H
+#define RAY_SWEEP_H
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hits.h"
+#include "ray.h"
+#include "vector.h"
+
+
+/**
+ * @brief Index of the wall in a span in which no wall is visible.
+ */
+#define SWEEP_NONE UINT32_MAX
+
+
+/**
+ * @brief The part of a wall covering an angular interval, relative to the start of the sweep.
+ */
+struct sweep_piece_t {
+    float lo; /**< The angle at which the piece starts. */
+    float hi; /**< The angle at which the piece ends. */
+    uint32_t wall; /**< The index of the wall in the wall table. */
+};
+
+/**
+ * @brief A point at which the sweep line starts or stops crossing a piece.
+ */
+struct sweep_event_t {
+    float angle; /**< The angle of the event, relative to the start of the sweep. */
+    uint32_t piece; /**< The index of the piece. */
+    bool start; /**< true if the piece starts at the event, false if it ends. */
+};
+
+/**
+ * @brief An edge of the visibility polygon: the angular interval in which a single wall is visible.
+ */
+struct sweep_span_t {
+    float angle; /**< The angle at which the span starts, relative to the start of the sweep; it ends at the next. */
+    uint32_t wall; /**< The index of the visible wall in the wall table, or SWEEP_NONE. */
+};
+
+/**
+ * @brief Buffers of the angular sweep, allocated once for a given number of walls.
+ */
+struct sweep_t {
+    struct sweep_piece_t *pieces; /**< The pieces of the walls in the swept angle. */
+    struct sweep_event_t *events; /**< The events, sorted by angle. */
+    uint32_t *heap; /**< The pieces crossed by the sweep line, as a binary heap with the nearest piece on top. */
+    uint32_t *slots; /**< For every piece, its position in the heap, or SWEEP_NONE. */
+    struct sweep_span_t *spans; /**< The edges of the visibility polygon, in the order of the sweep. */
+    size_t npieces; /**< The number of pieces. */
+    size_t nevents; /**< The number of events. */
+    size_t nheap; /**< The number of pieces in the heap. */
+    size_t nspans; /**< The number of spans. */
+    size_t capacity; /**< The maximum number of walls. */
+    const struct wall_table_t *walls; /**< The walls of the current sweep. */
+    struct vec_t pos; /**< The origin of the current sweep. */
+    float angle; /**< The angle at which the current sweep starts, slightly before its first ray. */
+};
+
+
+/**
+ * @brief Allocates the buffers of an angular sweep.
+ *
+ * @param sweep The sweep to initialize.
+ * @param nwalls The maximum number of walls to sweep.
+ * @return 0 on success, -1 on error.
+ */
+int sweep_create(struct sweep_t *sweep, size_t nwalls);
+
+/**
+ * @brief Frees the buffers of an angular sweep.
+ * @param sweep The sweep to destroy.
+ */
+void sweep_destroy(struct sweep_t *sweep);
+
+/**
+ * @brief Computes the visibility polygon over a fan of rays by sweeping the wall endpoints by angle, then
+ *        reads the hit of every ray off the polygon.
+ *
+ * The endpoints are sorted by angle and swept with a heap of the walls crossed by the sweep line, which
+ * takes O(n log n) time for n walls regardless of the number of rays. Every ray is then tested only
+ * against the wall visible in its direction. The result is exact as long as no two walls cross.
+ *
+ * Besides the intersections, the edge flag of every ray is set if the visible wall changes between the
+ * ray and the previous one.
+ *
+ * @param sweep The sweep buffers, allocated for at least @p walls->count walls.
+ * @param walls The walls.
+ * @param hits The rays. The direction of ray i must be at the angle @p angle + i * @p step (in radians). The hits,
+ *             the numbers of tested walls and the edge flags are overwritten; the hit parameters are not
+ *             computed. The rays must not span more than a full turn.
+ * @param angle The angle of the first ray.
+ * @param step The angle between two neighbouring rays. Must be positive.
+ * @return The number of edges of the visibility polygon within the rays.
+ */
+size_t sweep_cast_rays(struct sweep_t *sweep, const struct wall_table_t *walls, const struct hits_t *hits,
+                       float angle, float step);
+
+
+#endif //RAY_SWEEP_H
@@ -1,4 +1,10 @@
+#include <ctype.h>
 #include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <SDL2/SDL.h>
 
@@ -10,106 +16,291 @@
 
 
 /**
- * Maximum number of columns in a record (line).
+ * Size of the smallest part of a world specification worth parsing on a thread of its own, in bytes.
  */
-#define PARSER_MAX_COLS 256
+#define PARSER_CHUNK_MIN 65536
 
+/**
+ * Maximum length of an error message of the parser, including the terminating null character.
+ */
+#define PARSER_ERROR_MAX 256
+
+/**
+ * Maximum number of significant digits of a coordinate converted without strtof(). The integer they make up fits
+ * into 64 bits, so that converting it rounds to the nearest float just like strtof() does.
+ */
+#define PARSER_FAST_DIGITS 19
+
+/**
+ * Maximum number of significant digits of a coordinate; a float overflows long before.
+ */
+#define PARSER_COORD_MAX 64
+
+/**
+ * Number of objects a pool is allocated for when the first object is added to it.
+ */
+#define WORLD_POOL_CAPACITY 16
+
+
+/**
+ * Checks whether a token is the given string literal.
+ */
+#define token_is(token, literal) \
+    ((token).length == sizeof (literal) - 1 && memcmp((token).str, (literal), sizeof (literal) - 1) == 0)
+
+/**
+ * Expands to the arguments printing a token with "%.*s", cut to the length of an error message.
+ */
+#define token_args(token) (int) SDL_min((token).length, PARSER_ERROR_MAX), (token).str
 
-#define parse_coord(dst, token)                                                     \
-do {                                                                                \
-    if (parse_coordinate((dst), (token)) != 0) {                                    \
-        logger_printf(LOG_LEVEL_ERROR, "unable to parse coordinate '%s'\n", token); \
-        return -1;                                                                  \
-    }                                                                               \
+#define parse_coord(dst, token, error)                      \
+do {                                                        \
+    if (parse_coordinate((dst), (token), (error)) != 0) {   \
+        return -1;                                          \
+    }                                                       \
 } while (0)
 
 
-static int parse_coordinate(float *const restrict dst, const char *const restrict token) {
-    if (token == NULL) {
-        return -1;
+/**
+ * @brief A token of a record: a run of characters other than spaces, which is not null-terminated.
+ */
+struct token_t {
+    const char *str; /**< The first character of the token. */
+    size_t length; /**< The number of characters of the token. */
+};
+
+/**
+ * @brief A part of the world specification made of whole lines, which is parsed into a slice of the pools of the
+ *        world.
+ */
+struct chunk_t {
+    const char *begin; /**< The first character of the part, at the start of a line. */
+    const char *end; /**< The character after the last one of the part, at the start of a line or the end. */
+    size_t nlines; /**< The number of lines parsed, including the line of the error if there is one. */
+    struct world_t world; /**< The slices of the pools, whose capacities are the numbers of records counted. */
+    bool failed; /**< Whether a line could not be parsed or its object could not be added to the world. */
+    char error[PARSER_ERROR_MAX]; /**< The message of the error, or an empty string if it was logged already. */
+};
+
+/**
+ * @brief A world specification parsed in parallel, the argument of count_chunks() and parse_chunks().
+ */
+struct parse_t {
+    struct chunk_t *chunks; /**< The parts of the specification. */
+};
+
+
+/**
+ * @brief Formats the message of a parser error.
+ * @return -1.
+ */
+__attribute__((__format__(__printf__, 2, 3)))
+static int fail(char *const restrict error, const char *const restrict fmt, ...) {
+    va_list args;
+
+    va_start(args, fmt);
+    vsnprintf(error, PARSER_ERROR_MAX, fmt, args);
+    va_end(args);
+
+    return -1;
+}
+
+/**
+ * @brief Finds the next token of a record.
+ * @param cursor the position to start looking at, moved past the token.
+ * @param end the end of the record.
+ * @param token pointer to store the token.
+ * @return true if a token was found, false at the end of the record.
+ */
+static bool next_token(const char **const restrict cursor, const char *const restrict end,
+                       struct token_t *const restrict token) {
+    const char *p = *cursor;
+
+    while (p < end && *p == ' ') {
+        p++;
     }
 
-    float result;
+    if (p == end) {
+        return false;
+    }
 
-    if (strcmp(token, "WIDTH") == 0) {
-        result = SCREEN_WIDTH;
-    } else if (strcmp(token, "HEIGHT") == 0) {
-        result = SCREEN_HEIGHT;
-    } else if (is_decimal(token)) {
-        errno = 0;
-        result = (float) strtof(token, NULL);
+    token->str = p;
 
-        if (errno != 0) {
-            logger_perror("strtof");
-            return -1;
+    while (p < end && *p != ' ') {
+        p++;
+    }
+
+    token->length = (size_t) (p - token->str);
+    *cursor = p;
+    return true;
+}
+
+/**
+ * @brief Checks whether a line consists of whitespace only.
+ */
+static bool is_blank(const char *const begin, const char *const end) {
+    for (const char *p = begin; p < end; p++) {
+        if (!isspace((unsigned char) *p)) {
+            return false;
         }
-    } else {
-        logger_printf(LOG_LEVEL_ERROR, "unexpected non-decimal token: '%s'\n", token);
-        return -1;
     }
 
-    if (dst != NULL) {
-        *dst = result;
+    return true;
+}
+
+/**
+ * @brief Parses a coordinate: a decimal integer, WIDTH or HEIGHT.
+ * @param dst pointer to store the parsed coordinate.
+ * @param token the token to parse.
+ * @param error buffer of PARSER_ERROR_MAX characters to store the error message in.
+ * @return 0 on success, -1 on error (dst is not modified in this case).
+ */
+static int parse_coordinate(float *const restrict dst, const struct token_t token, char *const restrict error) {
+    if (token_is(token, "WIDTH")) {
+        *dst = SCREEN_WIDTH;
+        return 0;
+    }
+
+    if (token_is(token, "HEIGHT")) {
+        *dst = SCREEN_HEIGHT;
+        return 0;
     }
 
+    size_t first = 0;
+    uint64_t value = 0;
+
+    /* leading zeros do not count towards the significant digits */
+    while (first + 1 < token.length && token.str[first] == '0') {
+        first++;
+    }
+
+    for (size_t i = first; i < token.length; i++) {
+        const unsigned int digit = (unsigned int) (token.str[i] - '0');
+
+        if (digit > 9) {
+            return fail(error, "unexpected non-decimal token: '%.*s'", token_args(token));
+        }
+
+        value = value * 10 + digit;
+    }
+
+    const size_t ndigits = token.length - first;
+
+    if (ndigits <= PARSER_FAST_DIGITS) {
+        *dst = (float) value;
+        return 0;
+    }
+
+    /* the value wrapped around, but coordinates this large are rare enough to leave them to strtof() */
+    char digits[PARSER_COORD_MAX + 1];
+
+    if (ndigits > PARSER_COORD_MAX) {
+        return fail(error, "unable to parse coordinate '%.*s'", token_args(token));
+    }
+
+    memcpy(digits, token.str + first, ndigits);
+    digits[ndigits] = '\0';
+    errno = 0;
+
+    const float result = strtof(digits, NULL);
+
+    if (errno != 0) {
+        return fail(error, "unable to parse coordinate '%.*s': %s", token_args(token), strerror(errno));
+    }
+
+    *dst = result;
     return 0;
 }
 
 /**
- * @brief Parses a color string.
- * @param colorstr a string containing a color in hexadecimal format (e.g. #ff0000 for red).
- * @param dst pointer to a SDL_Color struct to store the parsed color, or NULL, if the color should not be stored.
+ * @brief Parses a sector identifier.
+ * @param dst pointer to store the parsed identifier.
+ * @param token the token to parse.
+ * @param error buffer of PARSER_ERROR_MAX characters to store the error message in.
  * @return 0 on success, -1 on error (dst is not modified in this case).
  */
-static int parse_color(const char *const colorstr, SDL_Color *const dst) {
-    if (strlen(colorstr) != 7 || *colorstr != '#') {
+static int parse_sector_id(unsigned int *const restrict dst, const struct token_t token, char *const restrict error) {
+    unsigned long long id = 0;
+
+    for (size_t i = 0; i < token.length; i++) {
+        const unsigned int digit = (unsigned int) (token.str[i] - '0');
+
+        if (digit > 9) {
+            return fail(error, "invalid sector id: %.*s", token_args(token));
+        }
+
+        id = id * 10 + digit;
+
+        if (id > UINT_MAX) {
+            return fail(error, "sector id out of range: %.*s", token_args(token));
+        }
+    }
+
+    *dst = (unsigned int) id;
+    return 0;
+}
+
+/**
+ * @brief Parses a color token.
+ * @param token a token containing a color in hexadecimal format (e.g. #ff0000 for red).
+ * @param dst pointer to a SDL_Color struct to store the parsed color.
+ * @return 0 on success, -1 on error (dst is not modified in this case).
+ */
+static int parse_color(const struct token_t token, SDL_Color *const dst) {
+    if (token.length != 7 || *token.str != '#') {
         return -1;
     }
 
-    const int r1 = hex_to_dec(colorstr[1]), r2 = hex_to_dec(colorstr[2]);
-    const int g1 = hex_to_dec(colorstr[3]), g2 = hex_to_dec(colorstr[4]);
-    const int b1 = hex_to_dec(colorstr[5]), b2 = hex_to_dec(colorstr[6]);
+    const char *const hex = token.str;
+    const int r1 = hex_to_dec(hex[1]), r2 = hex_to_dec(hex[2]);
+    const int g1 = hex_to_dec(hex[3]), g2 = hex_to_dec(hex[4]);
+    const int b1 = hex_to_dec(hex[5]), b2 = hex_to_dec(hex[6]);
 
     if (r1 == -1 || r2 == -1 || g1 == -1 || g2 == -1 || b1 == -1 || b2 == -1) {
         return -1;
     }
 
-    if (dst != NULL) {
-        dst->r = (Uint8) (r1 * 16 + r2);
-        dst->g = (Uint8) (g1 * 16 + g2);
-        dst->b = (Uint8) (b1 * 16 + b2);
-        dst->a = 255;
-    }
+    dst->r = (Uint8) (r1 * 16 + r2);
+    dst->g = (Uint8) (g1 * 16 + g2);
+    dst->b = (Uint8) (b1 * 16 + b2);
+    dst->a = 255;
 
     return 0;
 }
 
 /**
- * @brief Parses a record (line) in the world specification.
- * @param record the record to parse. Must be a null-terminated string with at most PARSER_MAX_COLS characters.
- * @param dst pointer to a wobject_t struct to store the parsed object, or NULL, if the object should not be stored.
+ * @brief Parses a record (line) in the world specification in place, without copying it.
+ * @param record the first character of the record.
+ * @param end the character after the last one of the record, e.g. its newline.
+ * @param dst pointer to a wobject_t struct to store the parsed object.
+ * @param error buffer of PARSER_ERROR_MAX characters to store the error message in.
  * @return 0 on success, -1 on error (dst is not modified in this case).
  */
-static int parse_record(const char *const restrict record, struct wobject_t *const dst) {
-    if (record == NULL) {
-        return -1;
-    }
-
-    char *const line = strncpy(stack_alloc(char, PARSER_MAX_COLS), record, PARSER_MAX_COLS);
-    const char *token;
+static int parse_record(const char *const restrict record, const char *const restrict end,
+                        struct wobject_t *const restrict dst, char *const restrict error) {
+    const char *cursor = record;
+    struct token_t token;
     size_t tokenno = 0;
     struct wobject_t object = {0};
 
-    for (token = strtok(line, " "); token != NULL; token = strtok(NULL, " "), tokenno++) {
+    for (; next_token(&cursor, end, &token); tokenno++) {
         if (tokenno == 0) { /* type */
-            if (strcmp(token, "wall") == 0) {
+            if (token_is(token, "wall")) {
                 object.type = WALL;
-                memset(&object.data.wall, 0, sizeof object.data.wall);
                 continue;
             }
 
-            logger_printf(LOG_LEVEL_ERROR, "invalid object type: %s\n", token);
-            return -1;
+            if (token_is(token, "sector")) {
+                object.type = SECTOR;
+                continue;
+            }
+
+            if (token_is(token, "portal")) {
+                object.type = PORTAL;
+                continue;
+            }
+
+            return fail(error, "invalid object type: %.*s", token_args(token));
         }
 
         switch (object.type) {
@@ -117,102 +308,393 @@ static int parse_record(const char *const restrict record, struct wobject_t *con
                 switch (tokenno) {
                     /* 1-4: wall coordinates */
                     case 1: /* a.x */
-                        parse_coord(&object.data.wall.a.x, token);
+                        parse_coord(&object.data.wall.a.x, token, error);
                         break;
                     case 2:  /* a.y */
-                        parse_coord(&object.data.wall.a.y, token);
+                        parse_coord(&object.data.wall.a.y, token, error);
                         break;
                     case 3:  /* b.x */
-                        parse_coord(&object.data.wall.b.x, token);
+                        parse_coord(&object.data.wall.b.x, token, error);
                         break;
                     case 4:  /* b.y */
-                        parse_coord(&object.data.wall.b.y, token);
+                        parse_coord(&object.data.wall.b.y, token, error);
                         break;
                     case 5:  /* wall color */
                         if (parse_color(token, &object.data.wall.color) != 0) {
-                            logger_printf(LOG_LEVEL_ERROR, "invalid color: %s\n", token);
-                            return -1;
+                            return fail(error, "invalid color: %.*s", token_args(token));
                         }
                         break;
                     case 6: /* wall type/material */
-                        if (strcmp(token, "solid") == 0) {
+                        if (token_is(token, "solid")) {
                             object.data.wall.type = WALL_TYPE_SOLID;
                             break;
                         }
-                        if (strcmp(token, "nonsolid") == 0) {
+                        if (token_is(token, "nonsolid")) {
                             object.data.wall.type = WALL_TYPE_NONSOLID;
                             break;
                         }
                         // TODO: add more wall types
                         break;
                     default:
-                        logger_printf(LOG_LEVEL_ERROR, "unexpected token '%s' starting at position %zu\n",
-                                      token, (size_t) (token - line) + 1);
+                        return fail(error, "unexpected token '%.*s' starting at position %zu", token_args(token),
+                                    (size_t) (token.str - record) + 1);
+                }
+                break;
+            }
+
+            case SECTOR: {
+                struct sector_t *const sector = &object.data.sector;
+
+                if (tokenno == 1) { /* sector id */
+                    if (parse_sector_id(&sector->id, token, error) != 0) {
                         return -1;
+                    }
+                    break;
+                }
+
+                /* 2...: vertex coordinates, x and y alternately */
+                const size_t vertex = (tokenno - 2) / 2;
+
+                if (vertex >= WORLD_SECTOR_VERTICES_MAX) {
+                    return fail(error, "too many sector vertices, at most %d are allowed",
+                                WORLD_SECTOR_VERTICES_MAX);
+                }
+
+                if (tokenno % 2 == 0) {
+                    parse_coord(&sector->vertices[vertex].x, token, error);
+                } else {
+                    parse_coord(&sector->vertices[vertex].y, token, error);
+                    sector->nvertices = vertex + 1;
+                }
+                break;
+            }
+
+            case PORTAL: {
+                struct portal_t *const portal = &object.data.portal;
+
+                switch (tokenno) {
+                    /* 1-4: portal coordinates */
+                    case 1: /* a.x */
+                        parse_coord(&portal->a.x, token, error);
+                        break;
+                    case 2: /* a.y */
+                        parse_coord(&portal->a.y, token, error);
+                        break;
+                    case 3: /* b.x */
+                        parse_coord(&portal->b.x, token, error);
+                        break;
+                    case 4: /* b.y */
+                        parse_coord(&portal->b.y, token, error);
+                        break;
+                    case 5: /* first sector id */
+                    case 6: /* second sector id */
+                        if (parse_sector_id(&portal->sectors[tokenno - 5], token, error) != 0) {
+                            return -1;
+                        }
+                        break;
+                    default:
+                        return fail(error, "unexpected token '%.*s' starting at position %zu", token_args(token),
+                                    (size_t) (token.str - record) + 1);
                 }
                 break;
             }
         }
     }
 
-    if (dst != NULL) {
-        memcpy(dst, &object, sizeof object);
+    switch (object.type) {
+        case WALL:
+            break;
+
+        case SECTOR:
+            if (object.data.sector.nvertices < 3 || tokenno != 2 + 2 * object.data.sector.nvertices) {
+                return fail(error, "a sector needs an id and at least 3 vertices");
+            }
+            break;
+
+        case PORTAL:
+            if (tokenno != 7) {
+                return fail(error, "a portal needs 2 endpoints and 2 sector ids");
+            }
+            break;
+    }
+
+    *dst = object;
+    return 0;
+}
+
+/**
+ * @brief Makes room for one more item in a pool of the arena, doubling its capacity if it is full.
+ * @return 0 on success, -1 on error (the pool is not modified in this case).
+ */
+static int reserve(struct arena_t *const restrict arena, void **const restrict items, size_t *const restrict capacity,
+                   const size_t count, const size_t size) {
+    if (count < *capacity) {
+        return 0;
+    }
+
+    const size_t new_capacity = *capacity == 0 ? WORLD_POOL_CAPACITY : 2 * *capacity;
+    void *const new_items = arena_grow(arena, *items, *capacity * size, new_capacity * size);
+
+    if (new_items == NULL) {
+        logger_printf(LOG_LEVEL_ERROR, "world exceeds the memory budget of %zu bytes\n", arena->size);
+        return -1;
+    }
+
+    *items = new_items;
+    *capacity = new_capacity;
+    return 0;
+}
+
+void world_update_wall(struct wall_t *const wall) {
+    const struct vec_t e = vsub(wall->b, wall->a);
+
+    wall->length = vlen(e);
+    wall->dir = wall->length > 0.0F ? vmul(e, 1.0F / wall->length) : (struct vec_t) {0.0F, 0.0F};
+    wall->min = (struct vec_t) {fminf(wall->a.x, wall->b.x), fminf(wall->a.y, wall->b.y)};
+    wall->max = (struct vec_t) {fmaxf(wall->a.x, wall->b.x), fmaxf(wall->a.y, wall->b.y)};
+}
+
+int world_create(struct world_t *const world, const size_t budget) {
+    memset(world, 0, sizeof *world);
+    return arena_create(&world->arena, budget);
+}
+
+int world_add(struct world_t *const restrict world, const struct wobject_t *const restrict object) {
+    switch (object->type) {
+        case WALL:
+            if (reserve(&world->arena, (void **) &world->walls, &world->wall_capacity, world->nwalls,
+                        sizeof *world->walls) != 0) {
+                return -1;
+            }
+
+            world->walls[world->nwalls] = object->data.wall;
+            world_update_wall(&world->walls[world->nwalls++]);
+            break;
+
+        case SECTOR:
+            if (reserve(&world->arena, (void **) &world->sectors, &world->sector_capacity, world->nsectors,
+                        sizeof *world->sectors) != 0) {
+                return -1;
+            }
+
+            world->sectors[world->nsectors++] = object->data.sector;
+            break;
+
+        case PORTAL:
+            if (reserve(&world->arena, (void **) &world->portals, &world->portal_capacity, world->nportals,
+                        sizeof *world->portals) != 0) {
+                return -1;
+            }
+
+            world->portals[world->nportals++] = object->data.portal;
+            break;
+    }
+
+    return 0;
+}
+
+void world_destroy(struct world_t *const world) {
+    arena_destroy(&world->arena);
+    unmap_file(world->map, world->map_size);
+    memset(world, 0, sizeof *world);
+}
+
+/**
+ * @brief Splits a world specification into parts of about the same size, which end at line boundaries.
+ * @return The number of parts, at most @p nchunks.
+ */
+static size_t split_chunks(const char *const restrict data, const size_t size, const size_t nchunks,
+                           struct chunk_t *const restrict chunks) {
+    const char *const end = data + size;
+    const char *begin = data;
+    size_t count = 0;
+
+    for (size_t i = 1; i <= nchunks && begin < end; i++) {
+        const char *const target = SDL_max(data + size / nchunks * i, begin);
+        const char *const newline = memchr(target, '\n', (size_t) (end - target));
+        const char *const stop = i < nchunks && newline != NULL ? newline + 1 : end;
+
+        memset(&chunks[count], 0, sizeof chunks[count]);
+        chunks[count].begin = begin;
+        chunks[count++].end = stop;
+        begin = stop;
+    }
+
+    return count;
+}
+
+/**
+ * @brief Parses the lines of a part of the world specification into its world, up to the first error.
+ */
+static void parse_lines(struct chunk_t *const chunk) {
+    for (const char *line = chunk->begin; line < chunk->end && !chunk->failed; chunk->nlines++) {
+        const char *const newline = memchr(line, '\n', (size_t) (chunk->end - line));
+        const char *const eol = newline != NULL ? newline : chunk->end;
+        struct wobject_t object;
+
+        if (!is_blank(line, eol)) {
+            if (parse_record(line, eol, &object, chunk->error) != 0) {
+                chunk->failed = true;
+            } else if (world_add(&chunk->world, &object) != 0) {
+                /* the error was logged by world_add() */
+                chunk->failed = true;
+                chunk->error[0] = '\0';
+            }
+        }
+
+        line = newline != NULL ? newline + 1 : chunk->end;
+    }
+}
+
+/**
+ * @brief Counts the records of every type in the parts [begin, end) of a world specification, as the capacities of
+ *        the slices of their pools. Records of an invalid type are left to the parser to report.
+ */
+static void count_chunks(const void *const arg, const size_t begin, const size_t end) {
+    const struct parse_t *const parse = arg;
+
+    for (size_t i = begin; i < end; i++) {
+        struct chunk_t *const chunk = &parse->chunks[i];
+
+        for (const char *line = chunk->begin; line < chunk->end;) {
+            const char *const newline = memchr(line, '\n', (size_t) (chunk->end - line));
+            const char *const eol = newline != NULL ? newline : chunk->end;
+            const char *cursor = line;
+            struct token_t token;
+
+            if (!next_token(&cursor, eol, &token)) {
+                /* a blank line */
+            } else if (token_is(token, "wall")) {
+                chunk->world.wall_capacity++;
+            } else if (token_is(token, "sector")) {
+                chunk->world.sector_capacity++;
+            } else if (token_is(token, "portal")) {
+                chunk->world.portal_capacity++;
+            }
+
+            line = newline != NULL ? newline + 1 : chunk->end;
+        }
+    }
+}
+
+/**
+ * @brief Parses the parts [begin, end) of a world specification, each into its slices of the pools of the world.
+ */
+static void parse_chunks(const void *const arg, const size_t begin, const size_t end) {
+    const struct parse_t *const parse = arg;
+
+    for (size_t i = begin; i < end; i++) {
+        parse_lines(&parse->chunks[i]);
+    }
+}
+
+/**
+ * @brief Allocates the pools of the world for the records counted in the parts of a world specification, and hands
+ *        every part its slice of them, in the order of the parts.
+ * @return 0 on success, -1 on error (the world is destroyed in this case).
+ */
+static int allocate_chunks(struct world_t *const restrict world, struct chunk_t *const restrict chunks,
+                           const size_t nchunks, const size_t budget) {
+    if (world_create(world, budget) != 0) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < nchunks; i++) {
+        world->wall_capacity += chunks[i].world.wall_capacity;
+        world->sector_capacity += chunks[i].world.sector_capacity;
+        world->portal_capacity += chunks[i].world.portal_capacity;
+    }
+
+    world->walls = arena_alloc(&world->arena, world->wall_capacity * sizeof *world->walls);
+    world->sectors = arena_alloc(&world->arena, world->sector_capacity * sizeof *world->sectors);
+    world->portals = arena_alloc(&world->arena, world->portal_capacity * sizeof *world->portals);
+
+    if (world->walls == NULL || world->sectors == NULL || world->portals == NULL) {
+        logger_printf(LOG_LEVEL_ERROR, "world exceeds the memory budget of %zu bytes\n", budget);
+        world_destroy(world);
+        return -1;
+    }
+
+    /* the slices have no arena, so a part can never outgrow them */
+    for (size_t i = 0, walls = 0, sectors = 0, portals = 0; i < nchunks; i++) {
+        struct world_t *const part = &chunks[i].world;
+
+        part->walls = world->walls + walls;
+        part->sectors = world->sectors + sectors;
+        part->portals = world->portals + portals;
+        walls += part->wall_capacity;
+        sectors += part->sector_capacity;
+        portals += part->portal_capacity;
     }
 
     return 0;
 }
 
 int load_world(const char *const restrict path,
-               struct wobject_t *const restrict *const restrict objects,
-               size_t *const restrict nobjects) {
+               struct world_t *const restrict world,
+               const size_t budget,
+               struct pool_t *const restrict pool) {
+    memset(world, 0, sizeof *world);
+
     if (path == NULL) {
         return -1;
     }
 
-    FILE *const stream = open_file(path, "r");
+    size_t size = 0;
+    char *const data = map_file(path, &size);
 
-    if (stream == NULL) {
+    if (data == NULL) {
+        logger_printf(LOG_LEVEL_ERROR, "unable to map '%s', it may be missing\n", path);
         return -1;
     }
 
-    if (nobjects != NULL) {
-        *nobjects = 0;
+    struct chunk_t chunks[POOL_THREADS_MAX];
+    struct parse_t parse = {.chunks = chunks};
+
+    /* every thread parses a part of its own; small specifications are not worth the threads */
+    const size_t nthreads = pool == NULL ? 1 : pool->nthreads;
+    const size_t nchunks = split_chunks(data, size, SDL_min(nthreads, size / PARSER_CHUNK_MIN + 1), chunks);
+    const bool parallel = pool != NULL && nchunks > 1;
+
+    if (parallel) {
+        pool_run(pool, nchunks, 1, count_chunks, &parse);
+    } else {
+        count_chunks(&parse, 0, nchunks);
     }
 
-    char line[PARSER_MAX_COLS] = {0};
+    if (allocate_chunks(world, chunks, nchunks, budget) != 0) {
+        unmap_file(data, size);
+        return -1;
+    }
 
-    for (int i = 0, ch = fgetc(stream); ch != EOF; ch = fgetc(stream), i++) {
-        if (i == sizeof line) {
-            logger_print(LOG_LEVEL_ERROR, "line too long");
-            fclose(stream);
-            return -1;
-        }
+    if (parallel) {
+        pool_run(pool, nchunks, 1, parse_chunks, &parse);
+    } else {
+        parse_chunks(&parse, 0, nchunks);
+    }
 
-        if (ch != '\n') {
-            line[i] = (char) ch;
-            continue;
-        }
+    unmap_file(data, size);
 
-        struct wobject_t object = {0};
+    /* report the first error in the order of the lines, as a serial parser would */
+    size_t line = 0;
 
-        if (is_whitespace(line)) {
-            goto next;
-        }
+    for (size_t i = 0; i < nchunks; i++) {
+        if (chunks[i].failed) {
+            if (chunks[i].error[0] != '\0') {
+                logger_printf(LOG_LEVEL_ERROR, "%s:%zu: %s\n", path, line + chunks[i].nlines, chunks[i].error);
+            }
 
-        if (parse_record(line, &object) != 0) {
-            fclose(stream);
+            world_destroy(world);
             return -1;
         }
 
-        if (objects != NULL && nobjects != NULL) {
-            memcpy(objects[(*nobjects)++], &object, sizeof object);
-        }
-
-        next:
-        i = -1;
-        memset(line, 0, sizeof line);
+        line += chunks[i].nlines;
+        world->nwalls += chunks[i].world.nwalls;
+        world->nsectors += chunks[i].world.nsectors;
+        world->nportals += chunks[i].world.nportals;
     }
 
-    fclose(stream);
+    logger_printf(LOG_LEVEL_INFO, "loaded %zu walls, %zu sectors and %zu portals using %zu of %zu bytes\n",
+                  world->nwalls, world->nsectors, world->nportals, world->arena.used, world->arena.size);
     return 0;
 }
@@ -3,11 +3,18 @@
 
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
+#include "arena.h"
+#include "pool.h"
 #include "vector.h"
 
 
-#define WORLD_NOBJECTS_MAX 100
+/**
+ * Maximum number of vertices of a sector.
+ */
+#define WORLD_SECTOR_VERTICES_MAX 16
 
 
 #define WALL_TYPE_SOLID (1 << 0)
@@ -17,32 +24,119 @@
 struct wall_t {
     struct vec_t a;
     struct vec_t b;
+    struct vec_t dir; /**< unit vector from a to b, or the zero vector if the wall has no length. */
+    float length; /**< distance between a and b. */
+    struct vec_t min; /**< lower corner of the bounding box of the wall. */
+    struct vec_t max; /**< upper corner of the bounding box of the wall. */
     SDL_Color color;
     unsigned int type;
+    unsigned int shade; /**< index of the color of the wall in the colormap, see colormap_build(). */
+};
+
+/**
+ * Represents a convex region of the world, used to limit ray casting to the walls visible through portals.
+ */
+struct sector_t {
+    unsigned int id; /**< identifier of the sector, referred to by portals. */
+    size_t nvertices; /**< number of vertices of the sector. */
+    struct vec_t vertices[WORLD_SECTOR_VERTICES_MAX]; /**< vertices of the sector, in order along its boundary. */
+};
+
+/**
+ * Represents an opening in the boundary between two sectors.
+ */
+struct portal_t {
+    struct vec_t a; /**< first endpoint of the portal. */
+    struct vec_t b; /**< second endpoint of the portal. */
+    unsigned int sectors[2]; /**< identifiers of the sectors connected by the portal. */
 };
 
 /**
- * Represents an object in the game world.
+ * Represents a record of the world specification, as parsed before it is added to the pool of its type.
  */
 struct wobject_t {
     enum unused {
-        WALL
+        WALL, SECTOR, PORTAL
     } type; /**< type of the object. */
     union {
         struct wall_t wall;
+        struct sector_t sector;
+        struct portal_t portal;
     } data; /**< data of the object. Depends on the type. */
 };
 
 
+/**
+ * Stores the objects of the world in one contiguous pool per type.
+ *
+ * The index of an object in the pool of its type is its handle. While the world grows, objects are only ever
+ * appended, so handles stay valid whereas pointers into the pools do not. optimize_world() then removes and reorders
+ * walls, so wall handles are only stable once the world is optimized. All pools live in a single arena, whose
+ * size is the memory budget of the world, or in the mapping of a compiled world file, see worldbin_load().
+ */
+struct world_t {
+    struct wall_t *walls; /**< pool of the walls. */
+    struct sector_t *sectors; /**< pool of the sectors. */
+    struct portal_t *portals; /**< pool of the portals. */
+    size_t nwalls; /**< number of walls. */
+    size_t nsectors; /**< number of sectors. */
+    size_t nportals; /**< number of portals. */
+    size_t wall_capacity; /**< number of walls which fit into the pool of the walls. */
+    size_t sector_capacity; /**< number of sectors which fit into the pool of the sectors. */
+    size_t portal_capacity; /**< number of portals which fit into the pool of the portals. */
+    struct arena_t arena; /**< arena holding the pools. */
+    void *map; /**< mapping of the compiled world file holding the pools instead of the arena, or NULL. */
+    size_t map_size; /**< size of the mapping in bytes. */
+};
+
+
+/**
+ * @brief Creates an empty world.
+ * @param world the world to initialize.
+ * @param budget the size of the arena holding the objects, in bytes.
+ * @return 0 on success, -1 on error.
+ */
+int world_create(struct world_t *world, size_t budget);
+
+/**
+ * @brief Adds an object to the pool of its type. The derived fields of walls are computed.
+ * @param world the world to add the object to.
+ * @param object the object to add.
+ * @return 0 on success, -1 on error, e.g. if the pool does not fit into the memory budget (the world is not
+ *         modified in this case).
+ */
+int world_add(struct world_t *world, const struct wobject_t *object);
+
+/**
+ * @brief Computes the direction, the length and the bounding box of a wall from its endpoints.
+ * @param wall the wall to update.
+ */
+void world_update_wall(struct wall_t *wall);
+
+/**
+ * @brief Frees the arena or unmaps the file holding the pools of a world.
+ * @param world the world to destroy.
+ */
+void world_destroy(struct world_t *world);
+
 /**
  * @brief Parses the world specification.
- * @param stream the stream to read the world specification from.
- * @param objects pointer to an array of wobject_t structs to store the parsed objects, or NULL, if the objects should not be stored.
- * @param nobjects pointer to a size_t variable to store the number of parsed objects, or NULL, if the number of objects should not be stored.
- * @return 0 on success, -1 on error (objects and nobjects are not modified in this case).
+ *
+ * The file is mapped and its lines are parsed in place. It is split at line boundaries into one part per thread of
+ * the pool. The records of every part are counted first, so that the pools of the world are allocated once with
+ * their exact size, and every part is then parsed into its own slice of them, in the order of the lines. Lines may
+ * be of any length. Errors are logged with the number of the line they occur in; if there are several, only the
+ * first one is reported.
+ *
+ * @param path the path of the world specification.
+ * @param world the world to create and store the parsed objects in.
+ * @param budget the size of the arena holding the objects, in bytes, which is all the memory the objects take up
+ *        while parsing.
+ * @param pool the worker pool to parse the parts with, or NULL to parse the whole file on the calling thread.
+ * @return 0 on success, -1 on error (the world is destroyed in this case).
  * @see parse_record
  */
-int load_world(const char *path, struct wobject_t *const restrict *objects, size_t *nobjects);
+int load_world(const char *path, struct world_t *world, size_t budget, struct pool_t *pool);
 
 
 #endif // RAY_WORLD_H
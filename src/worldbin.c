@@ -0,0 +1,303 @@
+#include <inttypes.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "conf.h"
+#include "fs.h"
+#include "logger.h"
+
+#include "worldbin.h"
+
+
+/**
+ * Identifies a compiled world file, "RAYW" in little-endian byte order. Files written on a machine of the other
+ * byte order do not match.
+ */
+#define WORLDBIN_MAGIC 0x57594152U
+
+/**
+ * Alignment of every section of a compiled world file in bytes, enough for any structure stored in it.
+ */
+#define WORLDBIN_ALIGN 16U
+
+/**
+ * Size of the chunks in which a file is read for hashing.
+ */
+#define WORLDBIN_HASH_CHUNK 65536
+
+#define FNV_OFFSET_BASIS 0xCBF29CE484222325U
+#define FNV_PRIME 0x100000001B3U
+
+
+enum unused section_t {
+    SECTION_WALLS,
+    SECTION_SECTORS,
+    SECTION_PORTALS,
+    SECTION_NODES,
+    SECTION_IDS,
+    NSECTIONS
+};
+
+/**
+ * The header at the start of a compiled world file, followed by the sections at the given offsets.
+ *
+ * Every section is an array of structures as they are laid out in memory, so a file only fits the build which
+ * wrote it. The sizes of the structures catch most mismatches; anything else must increase WORLDBIN_VERSION.
+ */
+struct header_t {
+    uint32_t magic; /**< WORLDBIN_MAGIC, only written once the rest of the file is complete. */
+    uint32_t version; /**< WORLDBIN_VERSION. */
+    uint32_t optimized; /**< WORLD_OPTIMIZE, as the walls of a mapped world are used as they are stored. */
+    float weld_distance; /**< WORLD_WELD_DISTANCE, which the walls were optimized with. */
+    uint64_t hash; /**< The hash of the world specification the file was compiled from. */
+    uint64_t size; /**< The size of the file in bytes. */
+    uint64_t offsets[NSECTIONS]; /**< The offset of every section from the start of the file in bytes. */
+    uint64_t counts[NSECTIONS]; /**< The number of structures in every section. */
+    uint64_t item_sizes[NSECTIONS]; /**< The size of the structures of every section in bytes. */
+};
+
+
+static const uint64_t ITEM_SIZES[NSECTIONS] = {
+        [SECTION_WALLS] = sizeof(struct wall_t),
+        [SECTION_SECTORS] = sizeof(struct sector_t),
+        [SECTION_PORTALS] = sizeof(struct portal_t),
+        [SECTION_NODES] = sizeof(struct bvh_node_t),
+        [SECTION_IDS] = sizeof(uint32_t)
+};
+
+
+static inline uint64_t align(const uint64_t offset) {
+    return (offset + WORLDBIN_ALIGN - 1) & ~(uint64_t) (WORLDBIN_ALIGN - 1);
+}
+
+int worldbin_hash(const char *const restrict path, uint64_t *const restrict hash) {
+    FILE *const stream = open_file(path, "r");
+
+    if (stream == NULL) {
+        return -1;
+    }
+
+    static unsigned char chunk[WORLDBIN_HASH_CHUNK];
+    uint64_t h = FNV_OFFSET_BASIS;
+    size_t n;
+
+    while ((n = fread(chunk, 1, sizeof chunk, stream)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            h = (h ^ chunk[i]) * FNV_PRIME;
+        }
+    }
+
+    const bool failed = ferror(stream) != 0;
+
+    fclose(stream);
+
+    if (failed) {
+        logger_printf(LOG_LEVEL_ERROR, "unable to read '%s'\n", path);
+        return -1;
+    }
+
+    *hash = h;
+    return 0;
+}
+
+/**
+ * @brief Writes zeros up to an offset of the file.
+ * @return 0 on success, -1 on error.
+ */
+static int pad(FILE *const stream, const uint64_t offset) {
+    static const char zeros[WORLDBIN_ALIGN] = {0};
+    const long position = ftell(stream);
+
+    if (position < 0 || (uint64_t) position > offset) {
+        return -1;
+    }
+
+    const size_t n = (size_t) (offset - (uint64_t) position);
+
+    return n == 0 || fwrite(zeros, 1, n, stream) == n ? 0 : -1;
+}
+
+int worldbin_save(const char *const restrict path,
+                  const uint64_t hash,
+                  const struct world_t *const restrict world,
+                  const struct bvh_t *const restrict bvh) {
+    const void *const data[NSECTIONS] = {world->walls, world->sectors, world->portals, bvh->nodes, bvh->ids};
+    const size_t nids = bvh->nnodes > 0 ? world->nwalls : 0;
+    struct header_t header = {
+            .version = WORLDBIN_VERSION,
+            .optimized = WORLD_OPTIMIZE,
+            .weld_distance = WORLD_WELD_DISTANCE,
+            .hash = hash,
+            .counts = {world->nwalls, world->nsectors, world->nportals, bvh->nnodes, nids}
+    };
+    uint64_t offset = align(sizeof header);
+
+    for (size_t i = 0; i < NSECTIONS; i++) {
+        header.offsets[i] = offset;
+        header.item_sizes[i] = ITEM_SIZES[i];
+        offset = align(offset + header.counts[i] * header.item_sizes[i]);
+    }
+
+    header.size = offset;
+
+    FILE *const stream = open_file(path, "w");
+
+    if (stream == NULL) {
+        return -1;
+    }
+
+    /* the header is written without its magic first, so that an interrupted write leaves an invalid file */
+    bool failed = fwrite(&header, sizeof header, 1, stream) != 1;
+
+    for (size_t i = 0; i < NSECTIONS && !failed; i++) {
+        const size_t count = (size_t) header.counts[i];
+
+        failed = pad(stream, header.offsets[i]) != 0 ||
+                 (count > 0 && fwrite(data[i], (size_t) header.item_sizes[i], count, stream) != count);
+    }
+
+    header.magic = WORLDBIN_MAGIC;
+    failed = failed || pad(stream, header.size) != 0 || fseek(stream, 0, SEEK_SET) != 0 ||
+             fwrite(&header, sizeof header, 1, stream) != 1;
+    failed = fclose(stream) != 0 || failed;
+
+    if (failed) {
+        logger_printf(LOG_LEVEL_ERROR, "unable to write '%s'\n", path);
+        return -1;
+    }
+
+    logger_printf(LOG_LEVEL_INFO, "compiled world into '%s' (%" PRIu64 " bytes)\n", path, header.size);
+    return 0;
+}
+
+/**
+ * @brief Checks the header of a compiled world file against the current specification and build, and the
+ *        sections against the size of the file.
+ */
+static bool check_header(const struct header_t *const header, const size_t size, const uint64_t hash,
+                         const char *const path) {
+    if (size < sizeof *header || header->magic != WORLDBIN_MAGIC || header->size != size) {
+        logger_printf(LOG_LEVEL_WARN, "'%s' is not a compiled world\n", path);
+        return false;
+    }
+
+    if (header->version != WORLDBIN_VERSION || memcmp(header->item_sizes, ITEM_SIZES, sizeof ITEM_SIZES) != 0) {
+        logger_printf(LOG_LEVEL_INFO, "'%s' was compiled by another version\n", path);
+        return false;
+    }
+
+    if (header->optimized != WORLD_OPTIMIZE || header->weld_distance < WORLD_WELD_DISTANCE ||
+        header->weld_distance > WORLD_WELD_DISTANCE) {
+        logger_printf(LOG_LEVEL_INFO, "'%s' was compiled with other settings\n", path);
+        return false;
+    }
+
+    if (header->hash != hash) {
+        logger_printf(LOG_LEVEL_INFO, "'%s' is out of date\n", path);
+        return false;
+    }
+
+    for (size_t i = 0; i < NSECTIONS; i++) {
+        const uint64_t offset = header->offsets[i];
+
+        if (offset % WORLDBIN_ALIGN != 0 || offset > size ||
+            header->counts[i] > (size - offset) / header->item_sizes[i]) {
+            logger_printf(LOG_LEVEL_WARN, "'%s' is damaged\n", path);
+            return false;
+        }
+    }
+
+    if (header->counts[SECTION_IDS] != (header->counts[SECTION_NODES] > 0 ? header->counts[SECTION_WALLS] : 0)) {
+        logger_printf(LOG_LEVEL_WARN, "'%s' is damaged\n", path);
+        return false;
+    }
+
+    return true;
+}
+
+static inline bool vec_finite(const struct vec_t v) {
+    return isfinite(v.x) && isfinite(v.y);
+}
+
+/**
+ * @brief Checks the records of a mapped world, which are used as they are: sectors must have a valid number of
+ *        vertices and every coordinate must be finite.
+ */
+static bool check_records(const struct world_t *const restrict world, const char *const restrict path) {
+    bool valid = true;
+
+    for (size_t i = 0; i < world->nwalls && valid; i++) {
+        const struct wall_t *const wall = &world->walls[i];
+
+        valid = vec_finite(wall->a) && vec_finite(wall->b) && vec_finite(wall->dir) && isfinite(wall->length) &&
+                vec_finite(wall->min) && vec_finite(wall->max);
+    }
+
+    for (size_t i = 0; i < world->nsectors && valid; i++) {
+        const struct sector_t *const sector = &world->sectors[i];
+
+        valid = sector->nvertices >= 3 && sector->nvertices <= WORLD_SECTOR_VERTICES_MAX;
+
+        for (size_t j = 0; j < sector->nvertices && valid; j++) {
+            valid = vec_finite(sector->vertices[j]);
+        }
+    }
+
+    for (size_t i = 0; i < world->nportals && valid; i++) {
+        valid = vec_finite(world->portals[i].a) && vec_finite(world->portals[i].b);
+    }
+
+    if (!valid) {
+        logger_printf(LOG_LEVEL_WARN, "'%s' is damaged\n", path);
+    }
+
+    return valid;
+}
+
+int worldbin_load(const char *const restrict path,
+                  const uint64_t hash,
+                  struct world_t *const restrict world,
+                  struct worldbin_bvh_t *const restrict bvh) {
+    memset(world, 0, sizeof *world);
+    memset(bvh, 0, sizeof *bvh);
+
+    size_t size = 0;
+    char *const map = map_file(path, &size);
+
+    if (map == NULL) {
+        return -1;
+    }
+
+    const struct header_t *const header = (const struct header_t *) map;
+
+    if (!check_header(header, size, hash, path)) {
+        unmap_file(map, size);
+        return -1;
+    }
+
+    world->walls = (struct wall_t *) (map + header->offsets[SECTION_WALLS]);
+    world->sectors = (struct sector_t *) (map + header->offsets[SECTION_SECTORS]);
+    world->portals = (struct portal_t *) (map + header->offsets[SECTION_PORTALS]);
+    world->nwalls = world->wall_capacity = (size_t) header->counts[SECTION_WALLS];
+    world->nsectors = world->sector_capacity = (size_t) header->counts[SECTION_SECTORS];
+    world->nportals = world->portal_capacity = (size_t) header->counts[SECTION_PORTALS];
+    world->map = map;
+    world->map_size = size;
+
+    bvh->nodes = (const struct bvh_node_t *) (map + header->offsets[SECTION_NODES]);
+    bvh->ids = (const uint32_t *) (map + header->offsets[SECTION_IDS]);
+    bvh->nnodes = (size_t) header->counts[SECTION_NODES];
+
+    if (!check_records(world, path)) {
+        unmap_file(map, size);
+        memset(world, 0, sizeof *world);
+        memset(bvh, 0, sizeof *bvh);
+        return -1;
+    }
+
+    logger_printf(LOG_LEVEL_INFO, "mapped %zu walls, %zu sectors and %zu portals from '%s'\n",
+                  world->nwalls, world->nsectors, world->nportals, path);
+    return 0;
+}
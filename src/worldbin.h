@@ -0,0 +1,65 @@
+#ifndef RAY_WORLDBIN_H
+#define RAY_WORLDBIN_H
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "bvh.h"
+#include "world.h"
+
+
+/**
+ * @brief Version of the compiled world format. Must be increased whenever the layout of the file or of one of
+ *        the structures stored in it changes.
+ */
+#define WORLDBIN_VERSION 2
+
+
+/**
+ * @brief The BVH stored in a compiled world file, pointing into the mapping of the file.
+ */
+struct worldbin_bvh_t {
+    const struct bvh_node_t *nodes; /**< The nodes of the BVH, see bvh_t. */
+    const uint32_t *ids; /**< The ids of the table entries of the BVH, one for every wall. */
+    size_t nnodes; /**< The number of nodes, 0 if the file holds no BVH. */
+};
+
+
+/**
+ * @brief Hashes the contents of a file, to tell whether a compiled world is up to date with its specification.
+ *
+ * @param path The path of the file.
+ * @param hash Pointer to store the 64-bit FNV-1a hash of the contents of the file.
+ * @return 0 on success, -1 on error.
+ */
+int worldbin_hash(const char *path, uint64_t *hash);
+
+/**
+ * @brief Writes a compiled world file: the pools of a world and its BVH, stored as they are laid out in memory.
+ *
+ * @param path The path of the file to write.
+ * @param hash The hash of the world specification the world was loaded from, see worldbin_hash().
+ * @param world The world.
+ * @param bvh The BVH built over the walls of the world, in the order of its pool.
+ * @return 0 on success, -1 on error.
+ */
+int worldbin_save(const char *path, uint64_t hash, const struct world_t *world, const struct bvh_t *bvh);
+
+/**
+ * @brief Maps a compiled world file into memory and uses its pools in place, without parsing or copying them.
+ *
+ * Objects cannot be added to the loaded world, as its pools live in the mapping instead of an arena.
+ *
+ * @param path The path of the file.
+ * @param hash The hash of the current world specification; the file is rejected if it was compiled from
+ *        another version of it.
+ * @param world The world to store the mapped pools in.
+ * @param bvh Pointer to store the BVH of the file, which is valid as long as the world is.
+ * @return 0 on success, -1 if the file does not exist, is out of date, was written by an incompatible build, is
+ *         damaged or cannot be read (the world is empty in this case).
+ */
+int worldbin_load(const char *path, uint64_t hash, struct world_t *world, struct worldbin_bvh_t *bvh);
+
+
+#endif //RAY_WORLDBIN_H
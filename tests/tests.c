@@ -1,12 +1,34 @@
 #include <float.h>
 #include <stdio.h>
 #include <stdlib.h>
-
+#include <string.h>
+#include <unistd.h>
+
+#include "../src/arena.h"
+#include "../src/batch.h"
+#include "../src/bsp.h"
+#include "../src/bvh.h"
+#include "../src/colormap.h"
+#include "../src/cull.h"
+#include "../src/framebuffer.h"
+#include "../src/grid.h"
+#include "../src/hits.h"
 #include "../src/math.h"
+#include "../src/optimize.h"
+#include "../src/pool.h"
+#include "../src/project.h"
+#include "../src/ray.h"
+#include "../src/sector.h"
+#include "../src/span.h"
+#include "../src/stripes.h"
+#include "../src/sweep.h"
+#include "../src/world.h"
+#include "../src/worldbin.h"
 #include "runner.h"
 
 
 #define REPEATS 1e6F
+#define WORLD_BUDGET (1024 * 1024)
 
 
 static float randf(void) {
@@ -17,6 +39,38 @@ static bool colors_equal(const SDL_Color a, const SDL_Color b) {
     return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
 }
 
+static int aim_hits(struct hits_t *const hits, const struct vec_t pos, const float angle, const float step,
+                    const size_t nrays) {
+    if (hits_resize(hits, nrays) != 0) {
+        return -1;
+    }
+
+    hits->pos = pos;
+
+    for (size_t i = 0; i < nrays; i++) {
+        hits->dir[i] = vfromangle(angle + (float) i * step);
+    }
+
+    return 0;
+}
+
+static int add_wall(struct world_t *const world, const struct vec_t a, const struct vec_t b) {
+    struct wobject_t object = {.type = WALL};
+    object.data.wall = (struct wall_t) {.a = a, .b = b, .color = COLOR_WHITE, .type = WALL_TYPE_SOLID};
+    return world_add(world, &object);
+}
+
+static int add_box_sector(struct world_t *const world, const unsigned int id,
+                          const struct vec_t min, const struct vec_t max) {
+    struct wobject_t object = {.type = SECTOR};
+    object.data.sector = (struct sector_t) {
+            .id = id,
+            .nvertices = 4,
+            .vertices = {min, {max.x, min.y}, max, {min.x, max.y}}
+    };
+    return world_add(world, &object);
+}
+
 
 TEST(test_isclose, {
     assert(isclose(0.0F, 0.0F));
@@ -629,6 +683,1198 @@ TEST(test_vproject, {
     assert_is_close(vec.y, 0.0F);
 })
 
+TEST(test_ray_intersection, {
+    const struct wall_t wall_data = {.a = {0.0F, -1.0F}, .b = {0.0F, 1.0F}};
+    const struct wall_t *const wall = &wall_data;
+    struct ray_t ray = {.pos = {-1.0F, 0.0F}, .dir = {1.0F, 0.0F}};
+    struct vec_t intersection;
+
+    assert_true(ray_intersection(&ray, wall, &intersection));
+    assert_is_close(intersection.x, 0.0F);
+    assert_is_close(intersection.y, 0.0F);
+
+    ray.dir = (struct vec_t) {-1.0F, 0.0F};
+    assert_false(ray_intersection(&ray, wall, &intersection));
+
+    ray.dir = (struct vec_t) {0.0F, 1.0F};
+    assert_false(ray_intersection(&ray, wall, &intersection));
+
+    ray.pos = (struct vec_t) {-1.0F, 2.0F};
+    ray.dir = (struct vec_t) {1.0F, 0.0F};
+    assert_false(ray_intersection(&ray, wall, &intersection));
+})
+
+TEST(test_ray_cast, {
+    struct world_t world;
+    struct wall_table_t table;
+
+    assert_equals(world_create(&world, WORLD_BUDGET), 0);
+
+    for (size_t i = 0; i < 3; i++) {
+        const float x = (float) i + 1.0F;
+        assert_equals(add_wall(&world, (struct vec_t) {x, -1.0F}, (struct vec_t) {x, 1.0F}), 0);
+    }
+
+    assert_equals(wall_table_build(&table, &world), 0);
+    assert_equals(table.count, 3);
+    assert_true(table.walls[2] == &world.walls[2]);
+
+    float dist = INFINITY;
+    assert_equals(ray_cast(&table, 0, 3, vzero, (struct vec_t) {1.0F, 0.0F}, &dist), 0);
+    assert_is_close(dist, 1.0F);
+
+    dist = 0.5F;
+    assert_equals(ray_cast(&table, 0, 3, vzero, (struct vec_t) {1.0F, 0.0F}, &dist), RAY_NO_HIT);
+    assert_is_close(dist, 0.5F);
+
+    dist = INFINITY;
+    assert_equals(ray_cast(&table, 0, 3, (struct vec_t) {1.5F, 0.0F}, (struct vec_t) {1.0F, 0.0F}, &dist), 1);
+    assert_is_close(dist, 0.5F);
+
+    dist = INFINITY;
+    assert_equals(ray_cast(&table, 1, 3, vzero, (struct vec_t) {1.0F, 0.0F}, &dist), 1);
+    assert_is_close(dist, 2.0F);
+
+    dist = INFINITY;
+    assert_equals(ray_cast(&table, 0, 3, vzero, (struct vec_t) {-1.0F, 0.0F}, &dist), RAY_NO_HIT);
+    assert_inf(dist);
+
+    wall_table_destroy(&table);
+    world_destroy(&world);
+    assert_null(table.ax);
+    assert_equals(table.count, 0);
+})
+
+TEST(test_ray_cast_rand, {
+    enum unused { NWALLS = 37 };
+    struct world_t world;
+    struct wall_table_t table;
+
+    assert_equals(world_create(&world, WORLD_BUDGET), 0);
+
+    for (size_t i = 0; i < NWALLS; i++) {
+        assert_equals(add_wall(&world, (struct vec_t) {randf(), randf()}, (struct vec_t) {randf(), randf()}), 0);
+    }
+
+    assert_equals(wall_table_build(&table, &world), 0);
+
+    const struct vec_t pos = {randf(), randf()};
+    const struct vec_t dir = vfromangle(randf() * 2.0F * PI);
+
+    float dist = INFINITY;
+    const size_t hit = ray_cast(&table, 0, NWALLS, pos, dir, &dist);
+
+    /* ranges of a single entry never reach the vectorized loop */
+    float expected_dist = INFINITY;
+    size_t expected_hit = RAY_NO_HIT;
+
+    for (size_t i = 0; i < NWALLS; i++) {
+        if (ray_cast(&table, i, i + 1, pos, dir, &expected_dist) != RAY_NO_HIT) {
+            expected_hit = i;
+        }
+    }
+
+    wall_table_destroy(&table);
+    world_destroy(&world);
+
+    assert_equals(hit, expected_hit);
+    assert_true(hit == RAY_NO_HIT || isclose(dist, expected_dist));
+})
+
+TEST(test_grid_cast_rand, {
+    enum unused { NWALLS = 50 };
+    struct world_t world;
+    struct wall_table_t table;
+    struct grid_t grid;
+
+    assert_equals(world_create(&world, WORLD_BUDGET), 0);
+
+    for (size_t i = 0; i < NWALLS; i++) {
+        const struct vec_t a = {randf() * 100.0F, randf() * 100.0F};
+        const struct vec_t b = vadd(a, (struct vec_t) {randf() * 20.0F - 10.0F, randf() * 20.0F - 10.0F});
+        assert_equals(add_wall(&world, a, b), 0);
+    }
+
+    assert_equals(wall_table_build(&table, &world), 0);
+    assert_equals(grid_build(&grid, &table), 0);
+    assert_gt(grid.cols * grid.rows, 1);
+
+    for (size_t i = 0; i < 100; i++) {
+        const struct vec_t pos = {randf() * 140.0F - 20.0F, randf() * 140.0F - 20.0F};
+        const struct vec_t dir = vfromangle(randf() * 2.0F * PI);
+
+        float expected_dist = INFINITY;
+        const size_t expected = ray_cast(&table, 0, table.count, pos, dir, &expected_dist);
+
+        float dist = INFINITY;
+        size_t tested = 0;
+        const size_t hit = grid_cast(&grid, pos, dir, &dist, &tested);
+
+        assert_equals(hit == RAY_NO_HIT, expected == RAY_NO_HIT);
+        assert_true(hit == RAY_NO_HIT || isclose(dist, expected_dist));
+    }
+
+    grid_destroy(&grid);
+    wall_table_destroy(&table);
+    world_destroy(&world);
+})
+
+TEST(test_bsp_cast_rays_rand, {
+    enum unused { NWALLS = 100, NRAYS = 360 };
+    struct world_t world;
+    struct hits_t hits = {0};
+    struct wall_table_t table;
+    struct bsp_t bsp;
+
+    assert_equals(world_create(&world, WORLD_BUDGET), 0);
+
+    for (size_t i = 0; i < NWALLS; i++) {
+        const struct vec_t a = {randf() * 100.0F, randf() * 100.0F};
+        const struct vec_t b = vadd(a, (struct vec_t) {randf() * 40.0F - 20.0F, randf() * 40.0F - 20.0F});
+        assert_equals(add_wall(&world, a, b), 0);
+    }
+
+    assert_equals(wall_table_build(&table, &world), 0);
+    assert_equals(bsp_build(&bsp, &table), 0);
+    assert_equals(bsp.stats.walls, NWALLS);
+    assert_equals(bsp.stats.fragments, NWALLS + bsp.stats.splits);
+    assert_geq(bsp.stats.nodes, 1);
+
+    const struct vec_t pos = {randf() * 140.0F - 20.0F, randf() * 140.0F - 20.0F};
+    const float angle = randf() * 2.0F * PI;
+    const float step = radians(360.0F / (float) NRAYS);
+
+    assert_equals(aim_hits(&hits, pos, angle, step, NRAYS), 0);
+
+    bsp_cast_rays(&bsp, &hits, angle, step);
+
+    for (size_t i = 0; i < NRAYS; i++) {
+        float expected_dist = INFINITY;
+        const size_t expected = ray_cast(&table, 0, table.count, pos, hits.dir[i], &expected_dist);
+
+        assert_equals(hits.wall[i] == HITS_NONE, expected == RAY_NO_HIT);
+        assert_true(expected == RAY_NO_HIT || fabsf(hits.dist[i] - expected_dist) < 0.01F);
+    }
+
+    hits_destroy(&hits);
+    bsp_destroy(&bsp);
+    wall_table_destroy(&table);
+    world_destroy(&world);
+})
+
+TEST(test_sector_cast_rays_rand, {
+    /* three rooms in a row, connected by doorways, with a pillar in the last one */
+    static const float walls[][4] = {
+            {100, 100, 700, 100}, {100, 100, 100, 700}, {100, 700, 700, 700}, {700, 100, 700, 300},
+            {700, 500, 700, 880}, {300, 300, 500, 500}, {700, 200, 1200, 200}, {700, 880, 1200, 880},
+            {1200, 100, 1200, 600}, {1200, 800, 1200, 900}, {1200, 100, 1800, 100}, {1800, 100, 1800, 900},
+            {1200, 900, 1800, 900}, {1450, 400, 1550, 400}, {1550, 400, 1550, 500},
+            {1550, 500, 1450, 500}, {1450, 500, 1450, 400}
+    };
+    static const struct vec_t boxes[][2] = {{{100, 100}, {700, 700}},
+                                            {{700, 200}, {1200, 880}},
+                                            {{1200, 100}, {1800, 900}}};
+    enum unused { NWALLS = sizeof walls / sizeof *walls, NSECTORS = 3, NRAYS = 720 };
+    struct world_t world;
+    struct hits_t hits = {0};
+    struct wall_table_t table;
+    struct sector_graph_t graph;
+    struct wobject_t portals[2] = {{.type = PORTAL}, {.type = PORTAL}};
+
+    assert_equals(world_create(&world, WORLD_BUDGET), 0);
+
+    for (size_t i = 0; i < NWALLS; i++) {
+        assert_equals(add_wall(&world, (struct vec_t) {walls[i][0], walls[i][1]},
+                               (struct vec_t) {walls[i][2], walls[i][3]}), 0);
+    }
+
+    for (size_t i = 0; i < NSECTORS; i++) {
+        assert_equals(add_box_sector(&world, (unsigned int) (10 * i), boxes[i][0], boxes[i][1]), 0);
+    }
+
+    portals[0].data.portal = (struct portal_t) {{700, 300}, {700, 500}, {0, 10}};
+    portals[1].data.portal = (struct portal_t) {{1200, 600}, {1200, 800}, {10, 20}};
+    assert_equals(world_add(&world, &portals[0]), 0);
+    assert_equals(world_add(&world, &portals[1]), 0);
+
+    assert_equals(wall_table_build(&table, &world), 0);
+    assert_equals(table.count, NWALLS);
+    assert_equals(sector_graph_build(&graph, &world, &table), 0);
+    assert_equals(graph.nsectors, NSECTORS);
+    assert_equals(sector_find(&graph, (struct vec_t) {50, 50}), SIZE_MAX);
+
+    const size_t sector = (size_t) rand() % NSECTORS;
+    const struct vec_t size = vsub(boxes[sector][1], boxes[sector][0]);
+    const struct vec_t pos = vadd(boxes[sector][0], (struct vec_t) {(0.05F + 0.9F * randf()) * size.x,
+                                                                    (0.05F + 0.9F * randf()) * size.y});
+    const float angle = randf() * 2.0F * PI;
+    const float step = radians(360.0F / (float) NRAYS);
+
+    assert_equals(sector_find(&graph, pos), sector);
+
+    assert_equals(aim_hits(&hits, pos, angle, step, NRAYS), 0);
+
+    assert_geq(sector_cast_rays(&graph, &hits, angle, step), 1);
+
+    for (size_t i = 0; i < NRAYS; i++) {
+        float expected_dist = INFINITY;
+        const size_t expected = ray_cast(&table, 0, table.count, pos, hits.dir[i], &expected_dist);
+
+        assert_equals(hits.wall[i] == HITS_NONE, expected == RAY_NO_HIT);
+        assert_true(expected == RAY_NO_HIT || fabsf(hits.dist[i] - expected_dist) < 0.01F);
+    }
+
+    hits_destroy(&hits);
+    sector_graph_destroy(&graph);
+    wall_table_destroy(&table);
+    world_destroy(&world);
+})
+
+TEST(test_sweep_cast_rays_rand, {
+    /* one wall inside every cell of a 10 x 10 grid, so that no two walls cross */
+    enum unused { NCELLS = 10, NWALLS = NCELLS * NCELLS, NRAYS = 360 };
+    struct world_t world;
+    struct hits_t hits = {0};
+    struct wall_table_t table;
+    struct sweep_t sweep;
+
+    assert_equals(world_create(&world, WORLD_BUDGET), 0);
+
+    for (size_t i = 0; i < NWALLS; i++) {
+        const struct vec_t cell = {(float) (i % NCELLS) * 10.0F, (float) (i / NCELLS) * 10.0F};
+        const struct vec_t a = vadd(cell, (struct vec_t) {randf() * 10.0F, randf() * 10.0F});
+        const struct vec_t b = vadd(cell, (struct vec_t) {randf() * 10.0F, randf() * 10.0F});
+        assert_equals(add_wall(&world, a, b), 0);
+    }
+
+    assert_equals(wall_table_build(&table, &world), 0);
+    assert_equals(sweep_create(&sweep, table.count), 0);
+
+    /* the rays cover between a quarter and the whole of a full turn */
+    const struct vec_t pos = {randf() * 140.0F - 20.0F, randf() * 140.0F - 20.0F};
+    const float angle = randf() * 2.0F * PI;
+    const float step = radians((0.25F + 0.75F * randf()) * 360.0F / (float) NRAYS);
+
+    assert_equals(aim_hits(&hits, pos, angle, step, NRAYS), 0);
+
+    assert_geq(sweep_cast_rays(&sweep, &table, &hits, angle, step), 1);
+
+    for (size_t i = 0; i < NRAYS; i++) {
+        float expected_dist = INFINITY;
+        const size_t expected = ray_cast(&table, 0, table.count, pos, hits.dir[i], &expected_dist);
+
+        assert_equals(hits.wall[i] == HITS_NONE, expected == RAY_NO_HIT);
+        assert_true(expected == RAY_NO_HIT || fabsf(hits.dist[i] - expected_dist) < 0.01F);
+    }
+
+    hits_destroy(&hits);
+    sweep_destroy(&sweep);
+    wall_table_destroy(&table);
+    world_destroy(&world);
+})
+
+TEST(test_cull_cast_rand, {
+    enum unused { NWALLS = 200, NRAYS = 360 };
+    struct world_t world;
+    struct wall_table_t table;
+    struct cull_t cull;
+
+    assert_equals(world_create(&world, WORLD_BUDGET), 0);
+
+    for (size_t i = 0; i < NWALLS; i++) {
+        const struct vec_t a = {randf() * 100.0F, randf() * 100.0F};
+        const struct vec_t b = vadd(a, (struct vec_t) {randf() * 20.0F - 10.0F, randf() * 20.0F - 10.0F});
+        assert_equals(add_wall(&world, a, b), 0);
+    }
+
+    assert_equals(wall_table_build(&table, &world), 0);
+    assert_equals(cull_create(&cull, table.count, NRAYS), 0);
+
+    /* the rays cover between a quarter and the whole of a full turn, optionally with a view distance */
+    const struct vec_t pos = {randf() * 140.0F - 20.0F, randf() * 140.0F - 20.0F};
+    const float angle = randf() * 2.0F * PI;
+    const float step = radians((0.25F + 0.75F * randf()) * 360.0F / (float) NRAYS);
+    const float max_dist = rand() % 2 == 0 ? 0.0F : 50.0F;
+
+    assert_equals(cull_walls(&cull, &table, pos, NRAYS, angle, step, max_dist), 0);
+    assert_leq(cull.candidates, NWALLS);
+
+    for (size_t i = 0; i < NRAYS; i++) {
+        const struct vec_t dir = vfromangle(angle + (float) i * step);
+
+        float expected_dist = INFINITY;
+        const size_t expected = ray_cast(&table, 0, table.count, pos, dir, &expected_dist);
+
+        float dist = INFINITY;
+        size_t tested = 0;
+        const size_t hit = cull_cast(&cull, i, pos, dir, &dist, &tested);
+
+        assert_leq(tested, 2 * NWALLS);
+
+        if (max_dist > 0.0F && !(expected_dist < max_dist)) {
+            continue;
+        }
+
+        assert_equals(hit == RAY_NO_HIT, expected == RAY_NO_HIT);
+        assert_true(hit == RAY_NO_HIT || isclose(dist, expected_dist));
+    }
+
+    cull_destroy(&cull);
+    wall_table_destroy(&table);
+    world_destroy(&world);
+})
+
+TEST(test_project_walls_rand, {
+    enum unused { NWALLS = 200, NRAYS = 360 };
+    struct world_t world;
+    struct hits_t hits = {0};
+    struct wall_table_t table;
+    struct cull_t cull;
+    struct project_t project;
+
+    assert_equals(world_create(&world, WORLD_BUDGET), 0);
+
+    for (size_t i = 0; i < NWALLS; i++) {
+        const struct vec_t a = {randf() * 100.0F, randf() * 100.0F};
+        const struct vec_t b = vadd(a, (struct vec_t) {randf() * 20.0F - 10.0F, randf() * 20.0F - 10.0F});
+        assert_equals(add_wall(&world, a, b), 0);
+    }
+
+    assert_equals(wall_table_build(&table, &world), 0);
+    assert_equals(cull_create(&cull, table.count, NRAYS), 0);
+    assert_equals(project_create(&project, table.count), 0);
+
+    const struct vec_t pos = {randf() * 140.0F - 20.0F, randf() * 140.0F - 20.0F};
+    const float angle = randf() * 2.0F * PI;
+    const float step = radians((0.25F + 0.75F * randf()) * 360.0F / (float) NRAYS);
+
+    assert_equals(aim_hits(&hits, pos, angle, step, NRAYS), 0);
+
+    assert_equals(cull_walls(&cull, &table, pos, NRAYS, angle, step, 0.0F), 0);
+    assert_equals(project_walls(&project, &cull, &table, &hits), 0);
+    assert_leq(project.drawn, project.nwalls);
+
+    for (size_t i = 0; i < NRAYS; i++) {
+        float expected_dist = INFINITY;
+        const size_t expected = ray_cast(&table, 0, table.count, pos, hits.dir[i], &expected_dist);
+
+        assert_equals(hits.wall[i] == HITS_NONE, expected == RAY_NO_HIT);
+        assert_true(expected == RAY_NO_HIT || isclose(hits.dist[i], expected_dist));
+    }
+
+    hits_destroy(&hits);
+    project_destroy(&project);
+    cull_destroy(&cull);
+    wall_table_destroy(&table);
+    world_destroy(&world);
+})
+
+TEST(test_colormap_shade_rand, {
+    enum unused { NWALLS = 20 };
+    struct world_t world;
+    struct colormap_t colormap;
+    const float lightmult = randf() * 3.0F;
+
+    assert_equals(world_create(&world, WORLD_BUDGET), 0);
+
+    for (size_t i = 0; i < NWALLS; i++) {
+        assert_equals(add_wall(&world, (struct vec_t) {0.0F, 0.0F}, (struct vec_t) {1.0F, 1.0F}), 0);
+        world.walls[i].color = (SDL_Color) {(Uint8) (rand() % 4 * 85), (Uint8) (rand() % 4 * 85), 255, 255};
+    }
+
+    assert_equals(colormap_build(&colormap, &world, 1.0F), 0);
+    assert_leq(colormap.ncolors, 16);
+    colormap_set_light(&colormap, lightmult);
+
+    for (size_t i = 0; i < NWALLS; i++) {
+        const struct wall_t *const wall = &world.walls[i];
+        const float dist = 100.0F + randf() * 2000.0F;
+        const float brightness = lightmult * map(1.0F / (dist * dist), 0.0F, 0.00001F, 0.0F, 1.0F);
+        const SDL_Color expected = change_brightness(wall->color, brightness);
+        const SDL_Color shade = colormap_color(colormap_shade(&colormap, wall, dist));
+
+        /* walls share a shade index exactly if they have the same color */
+        for (size_t j = 0; j < NWALLS; j++) {
+            assert_equals(wall->shade == world.walls[j].shade, colors_equal(wall->color, world.walls[j].color));
+        }
+
+        /* half a level of rounding, plus the truncation of both colors */
+        assert_leq(abs(shade.r - expected.r), 2);
+        assert_leq(abs(shade.g - expected.g), 2);
+        assert_leq(abs(shade.b - expected.b), 2);
+        assert_equals(shade.a, expected.a);
+    }
+
+    colormap_destroy(&colormap);
+    world_destroy(&world);
+})
+
+TEST(test_hits_resolve_rand, {
+    enum unused { NWALLS = 50, NRAYS = 360 };
+    struct world_t world;
+    struct wall_table_t table;
+    struct hits_t hits = {0};
+
+    assert_equals(world_create(&world, WORLD_BUDGET), 0);
+
+    for (size_t i = 0; i < NWALLS; i++) {
+        const struct vec_t a = {randf() * 100.0F, randf() * 100.0F};
+        const struct vec_t b = vadd(a, (struct vec_t) {randf() * 40.0F - 20.0F, randf() * 40.0F - 20.0F});
+        assert_equals(add_wall(&world, a, b), 0);
+    }
+
+    assert_equals(wall_table_build(&table, &world), 0);
+
+    const struct vec_t pos = {randf() * 140.0F - 20.0F, randf() * 140.0F - 20.0F};
+    const float step = radians(360.0F / (float) NRAYS);
+
+    /* resizing to the same number of rays keeps the arrays */
+    assert_equals(aim_hits(&hits, pos, randf() * 2.0F * PI, step, NRAYS), 0);
+    const struct vec_t *const dir = hits.dir;
+    assert_equals(hits_resize(&hits, NRAYS), 0);
+    assert_true(hits.dir == dir);
+
+    hits_clear(&hits);
+
+    for (size_t i = 0; i < NRAYS; i++) {
+        const size_t hit = ray_cast(&table, 0, table.count, pos, hits.dir[i], &hits.dist[i]);
+
+        hits.wall[i] = hit == RAY_NO_HIT ? HITS_NONE : (uint32_t) hit;
+    }
+
+    /* a shifted copy of the rays resolves to the same hits */
+    const size_t shift = (size_t) rand() % NRAYS;
+    hits_move(&hits, 0, shift, NRAYS - shift);
+    const struct hits_t slice = hits_slice(&hits, 0, NRAYS - shift);
+    hits_resolve(&slice, &table);
+
+    for (size_t i = 0; i < slice.count; i++) {
+        if (slice.wall[i] == HITS_NONE) {
+            assert_false(slice.dist[i] < INFINITY);
+            continue;
+        }
+
+        const struct vec_t expected = vadd(pos, vmul(slice.dir[i], slice.dist[i]));
+        const struct vec_t hit = hits_pos(&slice, &table, i);
+
+        assert_true(slice.param[i] >= 0.0F && slice.param[i] <= 1.0F);
+        assert_leq(vdist(hit, expected), 0.01F);
+    }
+
+    hits_destroy(&hits);
+    wall_table_destroy(&table);
+    world_destroy(&world);
+})
+
+TEST(test_framebuffer_transpose_rand, {
+    enum unused { DIM_MAX = 100, PADDING = 3 };
+    static Uint32 pixels[DIM_MAX * (DIM_MAX + PADDING)];
+    struct framebuffer_t framebuffer;
+    const int width = 1 + rand() % DIM_MAX;
+    const int height = 1 + rand() % DIM_MAX;
+    const size_t pitch = (size_t) width + (size_t) (rand() % (PADDING + 1));
+    const int top = rand() % height;
+    const int bottom = top + 1 + rand() % (height - top);
+
+    assert_equals(framebuffer_create(&framebuffer, NULL, width, height), 0);
+
+    for (int x = 0; x < width; x++) {
+        for (int y = 0; y < height; y++) {
+            framebuffer_fill_column(&framebuffer, x, y, y + 1, (Uint32) rand());
+        }
+    }
+
+    memset(pixels, 0, sizeof pixels);
+    framebuffer_transpose(&framebuffer, pixels, pitch, top, bottom);
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const Uint32 expected = y >= top && y < bottom ? framebuffer.columns[x * height + y] : 0;
+            assert_equals(pixels[(size_t) y * pitch + (size_t) x], expected);
+        }
+    }
+
+    framebuffer_destroy(&framebuffer);
+})
+
+TEST(test_span_coalesce_rand, {
+    enum unused { NCOLUMNS = 500, NWALLS = 3 };
+    static const struct wall_t walls[NWALLS] = {{.color = COLOR_WHITE}, {.color = COLOR_WHITE}, {.color = COLOR_WHITE}};
+    const float tolerance = 0.5F;
+    const float color_tolerance = 2.0F;
+    const bool noisy = rand() % 2 == 0;
+    struct span_t span;
+    size_t nsegments = 0;
+
+    assert_equals(span_create(&span, NCOLUMNS), 0);
+
+    /* segments of stripes on the same wall, linear unless noisy, some of them empty */
+    for (size_t first = 0; first < NCOLUMNS; nsegments++) {
+        const size_t length = (size_t) (rand() % 50);
+        const size_t last = SDL_min(first + length, NCOLUMNS - 1);
+        const int wall = rand() % (NWALLS + 1);
+        const float top = randf() * 500.0F;
+        const float slope = randf() * 4.0F - 2.0F;
+        const Uint8 shade = (Uint8) (rand() % 256);
+
+        for (size_t i = first; i <= last; i++) {
+            const float noise = noisy ? randf() * 6.0F - 3.0F : 0.0F;
+
+            span.columns[i] = (struct span_column_t) {
+                    .wall = wall == NWALLS ? NULL : &walls[wall],
+                    .top = top + slope * (float) (i - first) + noise,
+                    .bottom = 1000.0F - top - slope * (float) (i - first),
+                    .color = {shade, shade, (Uint8) (noisy ? rand() % 256 : shade), 255}
+            };
+        }
+
+        first = last + 1;
+    }
+
+    const size_t nruns = span_coalesce(&span, NCOLUMNS, tolerance, color_tolerance);
+    size_t next = 0;
+
+    assert_equals(nruns, span.nruns);
+    assert_true(noisy || nruns <= nsegments);
+
+    for (size_t r = 0; r < nruns; r++) {
+        const struct span_run_t *const run = &span.runs[r];
+        const struct span_column_t *const first = &span.columns[run->first];
+        const struct span_column_t *const last = &span.columns[run->last];
+
+        assert_leq(run->first, run->last);
+
+        /* the runs cover every stripe exactly once, in order */
+        for (; next < run->first; next++) {
+            assert_true(span.columns[next].wall == NULL);
+        }
+
+        for (size_t i = run->first; i <= run->last; i++) {
+            const struct span_column_t *const column = &span.columns[i];
+            const float t = run->last > run->first ? (float) (i - run->first) / (float) (run->last - run->first)
+                                                   : 0.0F;
+
+            assert_true(column->wall == first->wall);
+            assert_leq(fabsf(lerp(first->top, last->top, t) - column->top), tolerance + 1e-3F);
+            assert_leq(fabsf(lerp(first->bottom, last->bottom, t) - column->bottom), tolerance + 1e-3F);
+            assert_leq(fabsf(lerp((float) first->color.b, (float) last->color.b, t) - (float) column->color.b),
+                       color_tolerance + 1e-3F);
+        }
+
+        next = run->last + 1;
+    }
+
+    for (; next < NCOLUMNS; next++) {
+        assert_true(span.columns[next].wall == NULL);
+    }
+
+    span_destroy(&span);
+})
+
+TEST(test_stripes_shade_rand, {
+    enum unused { NWALLS = 8, NCOLUMNS = 300 };
+    struct world_t world;
+    struct colormap_t colormap;
+    struct stripes_t stripes;
+    const float scale = 1000.0F + randf() * 20000.0F;
+    const float horizon = randf() * 1000.0F;
+    const size_t ncolumns = (size_t) (rand() % NCOLUMNS);
+
+    assert_equals(world_create(&world, WORLD_BUDGET), 0);
+
+    for (size_t i = 0; i < NWALLS; i++) {
+        assert_equals(add_wall(&world, (struct vec_t) {0.0F, 0.0F}, (struct vec_t) {1.0F, 1.0F}), 0);
+        world.walls[i].color = (SDL_Color) {(Uint8) rand(), (Uint8) rand(), (Uint8) rand(), 255};
+    }
+
+    assert_equals(colormap_build(&colormap, &world, randf() * 3.0F), 0);
+    assert_equals(stripes_create(&stripes, NCOLUMNS), 0);
+
+    for (size_t i = 0; i < ncolumns; i++) {
+        const bool empty = rand() % 5 == 0;
+
+        stripes.walls[i] = empty ? NULL : &world.walls[rand() % NWALLS];
+        stripes.dist[i] = empty ? INFINITY : 1.0F + randf() * 2000.0F;
+        stripes.correction[i] = 0.5F + randf() * 0.5F;
+    }
+
+    stripes_shade(&stripes, ncolumns, &colormap, scale, horizon);
+
+    /* the passes over the arrays must agree with shading every column on its own */
+    for (size_t i = 0; i < ncolumns; i++) {
+        if (stripes.walls[i] == NULL) {
+            continue;
+        }
+
+        const float height = scale / (stripes.dist[i] * stripes.correction[i]);
+
+        assert_leq(fabsf(stripes.height[i] - height), height * FLT_EPSILON);
+        assert_leq(fabsf(stripes.top[i] - (horizon - height / 2.0F)), (horizon + height) * FLT_EPSILON);
+        assert_equals(stripes.shade[i], colormap_shade(&colormap, stripes.walls[i], stripes.dist[i]));
+    }
+
+    stripes_destroy(&stripes);
+    colormap_destroy(&colormap);
+    world_destroy(&world);
+})
+
+TEST(test_world_add_rand, {
+    /* enough objects for the pools to grow several times */
+    enum unused { NWALLS = 100, NSECTORS = 40 };
+    struct world_t world;
+    struct vec_t ends[NWALLS][2];
+
+    assert_equals(world_create(&world, WORLD_BUDGET), 0);
+
+    for (size_t i = 0, j = 0; i < NWALLS || j < NSECTORS;) {
+        if (i < NWALLS && (j == NSECTORS || rand() % 2 == 0)) {
+            ends[i][0] = (struct vec_t) {randf() * 100.0F, randf() * 100.0F};
+            ends[i][1] = rand() % 10 == 0 ? ends[i][0] : (struct vec_t) {randf() * 100.0F, randf() * 100.0F};
+            assert_equals(add_wall(&world, ends[i][0], ends[i][1]), 0);
+            i++;
+        } else {
+            assert_equals(add_box_sector(&world, (unsigned int) j, vzero, (struct vec_t) {1.0F, 1.0F}), 0);
+            j++;
+        }
+    }
+
+    assert_equals(world.nwalls, NWALLS);
+    assert_equals(world.nsectors, NSECTORS);
+    assert_equals(world.nportals, 0);
+    assert_leq(world.nwalls, world.wall_capacity);
+
+    /* every handle still refers to the object added with it */
+    for (size_t i = 0; i < NWALLS; i++) {
+        const struct wall_t *const wall = &world.walls[i];
+        const struct vec_t e = vsub(ends[i][1], ends[i][0]);
+
+        assert_leq(vdist(wall->a, ends[i][0]), 0.0F);
+        assert_leq(vdist(wall->b, ends[i][1]), 0.0F);
+        assert_is_close(wall->length, vlen(e));
+        assert_leq(vdist(vmul(wall->dir, wall->length), e), 0.001F);
+        assert_true(wall->min.x <= wall->a.x && wall->a.x <= wall->max.x);
+        assert_true(wall->min.y <= wall->b.y && wall->b.y <= wall->max.y);
+        assert_true(wall->min.x <= wall->b.x && wall->b.x <= wall->max.x);
+        assert_true(wall->min.y <= wall->a.y && wall->a.y <= wall->max.y);
+    }
+
+    for (size_t j = 0; j < NSECTORS; j++) {
+        assert_equals(world.sectors[j].id, (unsigned int) j);
+    }
+
+    assert_leq(world.arena.used, world.arena.size);
+    world_destroy(&world);
+    assert_null(world.walls);
+    assert_equals(world.nwalls, 0);
+})
+
+TEST(test_world_budget, {
+    struct world_t world;
+
+    /* a world which exceeds its budget is left as it was */
+    assert_equals(world_create(&world, sizeof *world.walls), 0);
+    assert_equals(add_wall(&world, vzero, (struct vec_t) {1.0F, 1.0F}), -1);
+    assert_equals(world.nwalls, 0);
+    assert_equals(world.arena.used, 0);
+    world_destroy(&world);
+})
+
+static int add_colored_wall(struct world_t *const world, const struct vec_t a, const struct vec_t b,
+                            const SDL_Color color) {
+    struct wobject_t object = {.type = WALL};
+    object.data.wall = (struct wall_t) {.a = a, .b = b, .color = color, .type = WALL_TYPE_SOLID};
+    return world_add(world, &object);
+}
+
+TEST(test_optimize_world, {
+    struct world_t world;
+    struct optimize_stats_t stats;
+
+    assert_equals(world_create(&world, WORLD_BUDGET), 0);
+
+    /* a run of three walls, the second reversed and the third starting just off the end of the second */
+    assert_equals(add_wall(&world, vzero, (struct vec_t) {10.0F, 0.0F}), 0);
+    assert_equals(add_wall(&world, (struct vec_t) {20.0F, 0.0F}, (struct vec_t) {10.0F, 0.0F}), 0);
+    assert_equals(add_wall(&world, (struct vec_t) {20.005F, 0.0F}, (struct vec_t) {30.0F, 0.0F}), 0);
+
+    /* a wall of another color continuing the run, a wall branching off it and a wall of no length */
+    assert_equals(add_colored_wall(&world, (struct vec_t) {30.0F, 0.0F}, (struct vec_t) {40.0F, 0.0F}, COLOR_RED), 0);
+    assert_equals(add_wall(&world, (struct vec_t) {10.0F, 0.0F}, (struct vec_t) {10.0F, 10.0F}), 0);
+    assert_equals(add_wall(&world, (struct vec_t) {5.0F, 5.0F}, (struct vec_t) {5.0F, 5.0F}), 0);
+
+    assert_equals(optimize_world(&world, &stats), 0);
+    assert_equals(stats.walls, 6);
+    assert_equals(stats.welded, 1);
+    assert_equals(stats.degenerate, 1);
+    assert_equals(stats.merged, 2);
+    assert_equals(world.nwalls, 3);
+
+    size_t runs = 0;
+
+    for (size_t i = 0; i < world.nwalls; i++) {
+        const struct wall_t *const wall = &world.walls[i];
+
+        if (isclose(wall->length, 30.0F)) {
+            assert_leq(vdist(vlerp(wall->a, wall->b, 0.5F), (struct vec_t) {15.0F, 0.0F}), 0.0F);
+            assert_true(colors_equal(wall->color, COLOR_WHITE));
+            runs++;
+        } else {
+            assert_is_close(wall->length, 10.0F);
+        }
+    }
+
+    assert_equals(runs, 1);
+    world_destroy(&world);
+})
+
+TEST(test_optimize_world_rand, {
+    enum unused { NLINES = 20, NPIECES = 10 };
+    const SDL_Color colors[] = {COLOR_WHITE, COLOR_RED};
+    struct world_t world;
+    struct wall_table_t before;
+    struct wall_table_t after;
+    struct optimize_stats_t stats;
+
+    assert_equals(world_create(&world, WORLD_BUDGET), 0);
+
+    /* lines cut into pieces of random colors, on a grid so that the pieces are exactly collinear */
+    for (size_t i = 0; i < NLINES; i++) {
+        const struct vec_t dirs[] = {{1.0F, 0.0F}, {0.0F, 1.0F}, {1.0F, 1.0F}, {1.0F, -1.0F}};
+        const struct vec_t dir = dirs[rand() % 4];
+        struct vec_t a = {(float) (rand() % 100), (float) (rand() % 100)};
+
+        for (size_t j = 0; j < NPIECES; j++) {
+            const struct vec_t b = vadd(a, vmul(dir, (float) (rand() % 10)));
+            const SDL_Color color = colors[rand() % 2];
+
+            assert_equals(rand() % 2 == 0 ? add_colored_wall(&world, a, b, color)
+                                          : add_colored_wall(&world, b, a, color), 0);
+            a = b;
+        }
+    }
+
+    assert_equals(wall_table_build(&before, &world), 0);
+    assert_equals(optimize_world(&world, &stats), 0);
+    assert_equals(wall_table_build(&after, &world), 0);
+
+    assert_equals(stats.walls, NLINES * NPIECES);
+    assert_equals(world.nwalls, stats.walls - stats.degenerate - stats.merged);
+    assert_equals(stats.welded, 0);
+
+    for (size_t i = 0; i < world.nwalls; i++) {
+        assert_gt(world.walls[i].length, 0.0F);
+    }
+
+    /* the optimized walls cover the same points */
+    for (size_t i = 0; i < 100; i++) {
+        const struct vec_t pos = {randf() * 140.0F - 20.0F, randf() * 140.0F - 20.0F};
+        const struct vec_t dir = vfromangle(randf() * 2.0F * PI);
+        float expected_dist = INFINITY;
+        float dist = INFINITY;
+
+        const size_t expected = ray_cast(&before, 0, before.count, pos, dir, &expected_dist);
+        const size_t hit = ray_cast(&after, 0, after.count, pos, dir, &dist);
+
+        assert_equals(hit == RAY_NO_HIT, expected == RAY_NO_HIT);
+        assert_true(hit == RAY_NO_HIT || fabsf(dist - expected_dist) <= 0.001F);
+    }
+
+    wall_table_destroy(&after);
+    wall_table_destroy(&before);
+    world_destroy(&world);
+})
+
+TEST(test_worldbin, {
+    enum unused { NWALLS = 300, NSECTORS = 5 };
+    char path[] = "/tmp/ray-worldbin-XXXXXX";
+    struct world_t world;
+    struct world_t mapped;
+    struct world_t damaged;
+    struct wall_table_t table;
+    struct wall_table_t mapped_table;
+    struct bvh_t bvh;
+    struct bvh_t restored;
+    struct worldbin_bvh_t prebuilt;
+    struct wobject_t portal = {.type = PORTAL};
+
+    assert_equals(world_create(&world, WORLD_BUDGET), 0);
+
+    for (size_t i = 0; i < NWALLS; i++) {
+        const struct vec_t a = {randf() * 100.0F, randf() * 100.0F};
+        const struct vec_t b = vadd(a, (struct vec_t) {randf() * 20.0F - 10.0F, randf() * 20.0F - 10.0F});
+        assert_equals(add_wall(&world, a, b), 0);
+    }
+
+    for (size_t i = 0; i < NSECTORS; i++) {
+        assert_equals(add_box_sector(&world, (unsigned int) i, vzero, (struct vec_t) {1.0F, 1.0F}), 0);
+    }
+
+    portal.data.portal = (struct portal_t) {{1, 0}, {1, 1}, {0, 1}};
+    assert_equals(world_add(&world, &portal), 0);
+
+    assert_equals(wall_table_build(&table, &world), 0);
+    assert_equals(bvh_build(&bvh, &table, NULL), 0);
+
+    const int fd = mkstemp(path);
+    assert_geq(fd, 0);
+    close(fd);
+
+    assert_equals(worldbin_save(path, 42, &world, &bvh), 0);
+
+    /* a file compiled from another specification is rejected */
+    assert_equals(worldbin_load(path, 43, &mapped, &prebuilt), -1);
+    assert_null(mapped.walls);
+
+    assert_equals(worldbin_load(path, 42, &mapped, &prebuilt), 0);
+    assert_equals(mapped.nwalls, NWALLS);
+    assert_equals(mapped.nsectors, NSECTORS);
+    assert_equals(mapped.nportals, 1);
+    assert_equals(memcmp(mapped.walls, world.walls, NWALLS * sizeof *world.walls), 0);
+    assert_equals(memcmp(mapped.sectors, world.sectors, NSECTORS * sizeof *world.sectors), 0);
+    assert_equals(memcmp(mapped.portals, world.portals, sizeof *world.portals), 0);
+
+    /* the restored BVH over the mapped walls finds the same walls */
+    assert_equals(wall_table_build(&mapped_table, &mapped), 0);
+    assert_equals(bvh_restore(&restored, &mapped_table, prebuilt.nodes, prebuilt.nnodes, prebuilt.ids), 0);
+    assert_equals(restored.nleaves, bvh.nleaves);
+    assert_equals(restored.depth, bvh.depth);
+
+    for (size_t i = 0; i < 100; i++) {
+        const struct vec_t pos = {randf() * 140.0F - 20.0F, randf() * 140.0F - 20.0F};
+        const struct vec_t dir = vfromangle(randf() * 2.0F * PI);
+        float dist = INFINITY;
+        float restored_dist = INFINITY;
+        size_t tested = 0;
+
+        assert_equals(bvh_cast(&restored, pos, dir, &restored_dist, &tested), bvh_cast(&bvh, pos, dir, &dist, &tested));
+        assert_true(restored_dist >= dist && restored_dist <= dist);
+    }
+
+    /* nodes which do not form a tree over all walls are rejected */
+    struct bvh_node_t *const nodes = malloc(prebuilt.nnodes * sizeof *nodes);
+    struct bvh_t damaged_bvh;
+
+    assert_not_null(nodes);
+    memcpy(nodes, prebuilt.nodes, prebuilt.nnodes * sizeof *nodes);
+    assert_equals(nodes[0].count, 0);
+    assert_equals(nodes[1].count, 0);
+    nodes[1].offset = nodes[0].offset;
+    assert_equals(bvh_restore(&damaged_bvh, &mapped_table, nodes, prebuilt.nnodes, prebuilt.ids), -1);
+    assert_null(damaged_bvh.nodes);
+
+    memcpy(nodes, prebuilt.nodes, prebuilt.nnodes * sizeof *nodes);
+    nodes[prebuilt.nnodes - 1].count--;
+    assert_equals(bvh_restore(&damaged_bvh, &mapped_table, nodes, prebuilt.nnodes, prebuilt.ids), -1);
+    assert_null(damaged_bvh.nodes);
+    free(nodes);
+
+    /* files whose records cannot be used as they are get rejected */
+    world.sectors[0].nvertices = WORLD_SECTOR_VERTICES_MAX + 1;
+    assert_equals(worldbin_save(path, 42, &world, &bvh), 0);
+    assert_equals(worldbin_load(path, 42, &damaged, &prebuilt), -1);
+    assert_null(damaged.map);
+
+    world.sectors[0].nvertices = 4;
+    world.walls[NWALLS - 1].b.x = NAN;
+    assert_equals(worldbin_save(path, 42, &world, &bvh), 0);
+    assert_equals(worldbin_load(path, 42, &damaged, &prebuilt), -1);
+    assert_null(damaged.walls);
+
+    unlink(path);
+    bvh_destroy(&restored);
+    bvh_destroy(&bvh);
+    wall_table_destroy(&mapped_table);
+    wall_table_destroy(&table);
+    world_destroy(&mapped);
+    world_destroy(&world);
+    assert_null(mapped.map);
+})
+
+TEST(test_load_world, {
+    enum unused { NWALLS = 8000, NSECTORS = 40 };
+    char path[] = "/tmp/ray-world-XXXXXX";
+    struct world_t serial;
+    struct world_t parallel;
+    struct pool_t pool;
+    SDL_Color colors[NWALLS];
+    struct vec_t ends[NWALLS][2];
+
+    const int fd = mkstemp(path);
+    assert_geq(fd, 0);
+
+    FILE *const stream = fdopen(fd, "w");
+    assert_not_null(stream);
+
+    /* enough walls to be split among the threads, with a sector and a blank line now and then */
+    for (size_t i = 0; i < NWALLS; i++) {
+        for (size_t j = 0; j < 2; j++) {
+            ends[i][j] = (struct vec_t) {(float) (rand() % 100000), (float) (rand() % 100000)};
+        }
+
+        colors[i] = (SDL_Color) rgb((Uint8) rand(), (Uint8) rand(), (Uint8) rand());
+        fprintf(stream, "wall %.0f %.0f %.0f %.0f #%02x%02X%02x solid\n", (double) ends[i][0].x,
+                (double) ends[i][0].y, (double) ends[i][1].x, (double) ends[i][1].y, colors[i].r, colors[i].g,
+                colors[i].b);
+
+        if (i % (NWALLS / NSECTORS) == 0) {
+            fprintf(stream, "sector %zu 0 0 000010 0 10 10\n\n", i);
+        }
+    }
+
+    /* lines are not limited in length, and the last one needs no newline */
+    fprintf(stream, "portal 0 0 10 10 %*s 0 1", 1000, "");
+    fclose(stream);
+
+    assert_equals(load_world(path, &serial, WORLD_BUDGET, NULL), 0);
+    assert_equals(pool_create(&pool, 4), 0);
+    assert_equals(load_world(path, &parallel, WORLD_BUDGET, &pool), 0);
+
+    assert_equals(serial.nwalls, NWALLS);
+    assert_equals(serial.nsectors, NSECTORS);
+    assert_equals(serial.nportals, 1);
+    assert_equals(parallel.nwalls, serial.nwalls);
+    assert_equals(parallel.nsectors, serial.nsectors);
+    assert_equals(parallel.nportals, serial.nportals);
+
+    for (size_t i = 0; i < NWALLS; i++) {
+        const struct wall_t *const wall = &parallel.walls[i];
+
+        assert_is_close(wall->a.x, ends[i][0].x);
+        assert_is_close(wall->a.y, ends[i][0].y);
+        assert_is_close(wall->b.x, ends[i][1].x);
+        assert_is_close(wall->b.y, ends[i][1].y);
+        assert_true(colors_equal(wall->color, colors[i]));
+        assert_equals(wall->type, WALL_TYPE_SOLID);
+        assert_equals(memcmp(wall, &serial.walls[i], sizeof *wall), 0);
+    }
+
+    for (size_t i = 0; i < NSECTORS; i++) {
+        assert_equals(parallel.sectors[i].id, i * (NWALLS / NSECTORS));
+        assert_equals(parallel.sectors[i].nvertices, 3);
+        assert_is_close(parallel.sectors[i].vertices[1].x, 10.0F);
+    }
+
+    assert_equals(parallel.portals[0].sectors[1], 1);
+
+    /* the objects take up a single arena within the budget, however many threads parse them */
+    const size_t used = parallel.arena.used;
+
+    assert_equals(parallel.arena.size, WORLD_BUDGET);
+    assert_equals(serial.arena.used, used);
+    assert_leq(used, NWALLS * sizeof *serial.walls + NSECTORS * sizeof *serial.sectors + sizeof *serial.portals +
+                     2 * ARENA_ALIGN);
+
+    world_destroy(&parallel);
+    assert_equals(load_world(path, &parallel, used, &pool), 0);
+    world_destroy(&parallel);
+    assert_equals(load_world(path, &parallel, used - 1, &pool), -1);
+    assert_null(parallel.walls);
+    assert_equals(load_world(path, &parallel, used - 1, NULL), -1);
+    assert_null(parallel.walls);
+
+    /* a bad record fails the whole world */
+    FILE *const bad = fopen(path, "a");
+    assert_not_null(bad);
+    fprintf(bad, "\nwall 1 2 3 x\n");
+    fclose(bad);
+
+    assert_equals(load_world(path, &parallel, WORLD_BUDGET, &pool), -1);
+    assert_null(parallel.walls);
+
+    /* an empty specification is an empty world */
+    assert_equals(truncate(path, 0), 0);
+    assert_equals(load_world(path, &parallel, WORLD_BUDGET, &pool), 0);
+    assert_equals(parallel.nwalls + parallel.nsectors + parallel.nportals, 0);
+
+    unlink(path);
+    pool_destroy(&pool);
+    world_destroy(&parallel);
+    world_destroy(&serial);
+})
+
+TEST(test_arena_grow_rand, {
+    enum unused { NBLOCKS = 20, SIZE = 4096 };
+    struct arena_t arena;
+    unsigned char *blocks[NBLOCKS];
+    size_t sizes[NBLOCKS];
+
+    assert_equals(arena_create(&arena, SIZE), 0);
+
+    /* grow random blocks by random amounts, checking that their contents survive */
+    for (size_t i = 0; i < NBLOCKS; i++) {
+        sizes[i] = 1 + (size_t) rand() % 32;
+        blocks[i] = arena_alloc(&arena, sizes[i]);
+        assert_not_null(blocks[i]);
+        assert_equals((uintptr_t) blocks[i] % ARENA_ALIGN, 0);
+        memset(blocks[i], (int) i, sizes[i]);
+    }
+
+    for (size_t k = 0; k < NBLOCKS; k++) {
+        const size_t i = (size_t) rand() % NBLOCKS;
+        const size_t size = sizes[i] + (size_t) rand() % 64;
+        const bool last = blocks[i] == arena.last;
+        unsigned char *const block = arena_grow(&arena, blocks[i], sizes[i], size);
+
+        if (block == NULL) {
+            break;
+        }
+
+        assert_equals(block == blocks[i], last);
+
+        for (size_t j = 0; j < sizes[i]; j++) {
+            assert_equals(block[j], (unsigned char) i);
+        }
+
+        memset(block, (int) i, size);
+        blocks[i] = block;
+        sizes[i] = size;
+    }
+
+    assert_leq(arena.used, arena.size);
+    assert_null(arena_alloc(&arena, SIZE));
+    assert_null(arena_grow(&arena, arena.last, 0, SIZE));
+
+    arena_destroy(&arena);
+    assert_null(arena.base);
+})
+
+TEST(test_bvh_cast_rand, {
+    enum unused { NWALLS = 500 };
+    struct world_t world;
+    static struct pool_t pool;
+    struct wall_table_t table;
+    struct bvh_t serial;
+    struct bvh_t parallel;
+
+    assert_equals(world_create(&world, WORLD_BUDGET), 0);
+
+    for (size_t i = 0; i < NWALLS; i++) {
+        const struct vec_t a = {randf() * 100.0F, randf() * 100.0F};
+        const struct vec_t b = vadd(a, (struct vec_t) {randf() * 20.0F - 10.0F, randf() * 20.0F - 10.0F});
+        assert_equals(add_wall(&world, a, b), 0);
+    }
+
+    assert_equals(wall_table_build(&table, &world), 0);
+    assert_equals(pool_create(&pool, 4), 0);
+    assert_equals(bvh_build(&serial, &table, NULL), 0);
+    assert_equals(bvh_build(&parallel, &table, &pool), 0);
+    pool_destroy(&pool);
+
+    assert_gt(serial.nleaves, 1);
+    assert_equals(serial.nnodes, 2 * serial.nleaves - 1);
+    assert_equals(parallel.nnodes, 2 * parallel.nleaves - 1);
+
+    for (size_t i = 0; i < 100; i++) {
+        const struct vec_t pos = {randf() * 140.0F - 20.0F, randf() * 140.0F - 20.0F};
+        const struct vec_t dir = vfromangle(randf() * 2.0F * PI);
+
+        float expected_dist = INFINITY;
+        const size_t expected = ray_cast(&table, 0, table.count, pos, dir, &expected_dist);
+
+        const struct bvh_t *const bvhs[] = {&serial, &parallel};
+
+        for (size_t j = 0; j < 2; j++) {
+            float dist = INFINITY;
+            size_t tested = 0;
+            const size_t hit = bvh_cast(bvhs[j], pos, dir, &dist, &tested);
+
+            assert_equals(hit == RAY_NO_HIT, expected == RAY_NO_HIT);
+            assert_true(hit == RAY_NO_HIT || isclose(dist, expected_dist));
+            assert_leq(tested, table.count);
+        }
+    }
+
+    bvh_destroy(&parallel);
+    bvh_destroy(&serial);
+    wall_table_destroy(&table);
+    world_destroy(&world);
+})
+
+static void count_items(const void *const arg, const size_t begin, const size_t end) {
+    int *const counts = *(int *const *) arg;
+
+    for (size_t i = begin; i < end; i++) {
+        counts[i]++;
+    }
+}
+
+TEST(test_batch, {
+    enum unused { NCOLORS = 64 };
+    static const SDL_Color red = rgba(255, 0, 0, 255);
+    static const SDL_Color blue = rgba(0, 0, 255, 255);
+    static struct batch_t batch;
+    SDL_Surface *const surface = SDL_CreateRGBSurfaceWithFormat(0, 16, 16, 32, SDL_PIXELFORMAT_RGBA8888);
+    SDL_Renderer *const renderer = SDL_CreateSoftwareRenderer(surface);
+    SDL_Color old;
+
+    assert_not_null(renderer);
+    SDL_SetRenderDrawColor(renderer, 1, 2, 3, 4);
+
+    batch_fill_rect(&batch, &(SDL_FRect) {.x = 1.0F, .y = 1.0F, .w = 2.0F, .h = 2.0F}, red);
+    batch_draw_line(&batch, 0.0F, 0.0F, 1.0F, 0.0F, red);
+    batch_draw_line(&batch, 5.0F, 5.0F, 6.0F, 6.0F, blue);
+    batch_draw_line(&batch, 1.0F, 0.0F, 1.0F, 1.0F, red);
+    batch_draw_line(&batch, 9.0F, 9.0F, 10.0F, 10.0F, red);
+    batch_draw_line(&batch, 6.0F, 6.0F, 7.0F, 7.0F, blue);
+    batch_flush(&batch, renderer);
+
+    // the quads, then two red polylines and a blue one, each color set once
+    assert_equals(batch.calls, 6);
+    assert_equals(batch.nquads, 0);
+    assert_equals(batch.nlines, 0);
+
+    const size_t orders[] = {0, 2, 3, 1, 4};
+
+    for (size_t i = 0; i < sizeof orders / sizeof *orders; i++) {
+        assert_equals(batch.sorted[i].order, orders[i]);
+    }
+
+    SDL_GetRenderDrawColor(renderer, &old.r, &old.g, &old.b, &old.a);
+    assert_true(colors_equal(old, (SDL_Color) rgba(1, 2, 3, 4)));
+
+    // too many colors to group in linear time, the lines are sorted instead
+    for (size_t i = 0; i < 2 * NCOLORS; i++) {
+        const float x = (float) (i % NCOLORS);
+        const float y = (float) (i / NCOLORS);
+
+        batch_draw_line(&batch, x, y, x, y + 1.0F, (SDL_Color) rgba((Uint8) (i % NCOLORS), 0, 0, 255));
+    }
+
+    batch_flush(&batch, renderer);
+    assert_equals(batch.calls, 2 * NCOLORS);
+
+    for (size_t i = 0; i < 3; i++) {
+        assert_is_close(batch.points[i].x, (float) (NCOLORS - 1));
+        assert_is_close(batch.points[i].y, (float) i);
+    }
+
+    batch_destroy(&batch);
+    SDL_DestroyRenderer(renderer);
+    SDL_FreeSurface(surface);
+})
+
+TEST(test_pool, {
+    enum unused { NITEMS = 1001, NJOBS = 50 };
+    static struct pool_t pool;
+    static int counts[NITEMS];
+    int *const arg = counts;
+
+    memset(counts, 0, sizeof counts);
+    assert_equals(pool_create(&pool, 4), 0);
+    assert_geq(pool.nthreads, 1);
+
+    for (size_t job = 0; job < NJOBS; job++) {
+        pool_run(&pool, NITEMS, 7, count_items, &arg);
+    }
+
+    pool_run(&pool, 0, 7, count_items, &arg);
+    pool_destroy(&pool);
+
+    for (size_t i = 0; i < NITEMS; i++) {
+        assert_equals(counts[i], NJOBS);
+    }
+})
+
 static const struct {
     const SDL_Color input;
     const uint32_t output;
@@ -753,6 +1999,21 @@ TEST(test_hex_to_dec, {
 
 RUN_TESTS(
         ADD_TEST(test_is_decimal_valid_rand, REPEATS),
+        ADD_TEST(test_arena_grow_rand, REPEATS / 1000),
+        ADD_TEST(test_bsp_cast_rays_rand, REPEATS / 1000),
+        ADD_TEST(test_bvh_cast_rand, REPEATS / 1000),
+        ADD_TEST(test_colormap_shade_rand, REPEATS / 1000),
+        ADD_TEST(test_cull_cast_rand, REPEATS / 1000),
+        ADD_TEST(test_framebuffer_transpose_rand, REPEATS / 1000),
+        ADD_TEST(test_hits_resolve_rand, REPEATS / 1000),
+        ADD_TEST(test_grid_cast_rand, REPEATS / 1000),
+        ADD_TEST(test_optimize_world_rand, REPEATS / 1000),
+        ADD_TEST(test_project_walls_rand, REPEATS / 1000),
+        ADD_TEST(test_ray_cast_rand, REPEATS / 100),
+        ADD_TEST(test_sector_cast_rays_rand, REPEATS / 1000),
+        ADD_TEST(test_span_coalesce_rand, REPEATS / 1000),
+        ADD_TEST(test_stripes_shade_rand, REPEATS / 1000),
+        ADD_TEST(test_sweep_cast_rays_rand, REPEATS / 1000),
         ADD_TEST(test_vadd_rand, REPEATS),
         ADD_TEST(test_vdiv_rand, REPEATS),
         ADD_TEST(test_vlen2_rand, REPEATS),
@@ -762,6 +2023,8 @@ RUN_TESTS(
         ADD_TEST(test_vnorm_weak_rand, REPEATS),
         ADD_TEST(test_vprod_rand, REPEATS),
         ADD_TEST(test_vsub_rand, REPEATS),
+        ADD_TEST(test_world_add_rand, REPEATS / 1000),
+        ADD_TEST(test_batch),
         ADD_TEST(test_change_brightness),
         ADD_TEST(test_color_to_int),
         ADD_TEST(test_constrain),
@@ -772,8 +2035,13 @@ RUN_TESTS(
         ADD_TEST(test_is_whitespace),
         ADD_TEST(test_isclose),
         ADD_TEST(test_lerp),
+        ADD_TEST(test_load_world),
         ADD_TEST(test_map),
+        ADD_TEST(test_optimize_world),
+        ADD_TEST(test_pool),
         ADD_TEST(test_radians),
+        ADD_TEST(test_ray_cast),
+        ADD_TEST(test_ray_intersection),
         ADD_TEST(test_vangle),
         ADD_TEST(test_vdist),
         ADD_TEST(test_vdist2),
@@ -784,4 +2052,6 @@ RUN_TESTS(
         ADD_TEST(test_vrotate),
         ADD_TEST(test_vscale),
         ADD_TEST(test_vzero),
+        ADD_TEST(test_world_budget),
+        ADD_TEST(test_worldbin),
 )
@@ -0,0 +1,247 @@
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/bvh.h"
+#include "../src/conf.h"
+#include "../src/logger.h"
+#include "../src/math.h"
+#include "../src/optimize.h"
+#include "../src/ray.h"
+#include "../src/sector.h"
+#include "../src/world.h"
+#include "../src/worldbin.h"
+
+
+/**
+ * Number of random rays cast to estimate the number of walls tested per ray.
+ */
+#define WORLDC_SAMPLE_RAYS 10000
+
+/**
+ * Seed of the random rays, so that the estimate of a world is the same on every run.
+ */
+#define WORLDC_SAMPLE_SEED 1
+
+
+/**
+ * @brief The options of the compiler.
+ */
+struct options_t {
+    const char *spec; /**< The path of the world specification. */
+    const char *output; /**< The path of the compiled world, or NULL to write it next to the specification. */
+    size_t budget; /**< The memory budget of the world in bytes. */
+};
+
+
+static inline void usage(const char *const argv0) {
+    static const char *const fmt = "usage: %s [-h|--help] [-m|--memory BYTES] [-o|--output PATH] SPEC\n"
+                                   "\t-h, --help\t\tprint this help message and exit\n"
+                                   "\t-m, --memory BYTES\tload the world within BYTES of memory instead of %d\n"
+                                   "\t-o, --output PATH\twrite the compiled world to PATH instead of SPEC%s\n"
+                                   "\nThe game only picks up a compiled world next to its specification.\n";
+
+    fprintf(stderr, fmt, argv0, WORLD_MEMORY_BUDGET, WORLD_COMPILED_SUFFIX);
+}
+
+static bool parse_size(const char *const restrict str, size_t *const restrict dst) {
+    char *end = NULL;
+    const unsigned long long value = strtoull(str, &end, 10);
+
+    if (end == str || *end != '\0' || value > SIZE_MAX) {
+        return false;
+    }
+
+    *dst = (size_t) value;
+    return true;
+}
+
+/**
+ * @brief Parses the command line.
+ * @return 0 on success, 1 if the help was requested, -1 on error.
+ */
+static int parse_options(const int argc, char *const *const restrict argv, struct options_t *const restrict options) {
+    *options = (struct options_t) {.budget = WORLD_MEMORY_BUDGET};
+
+    for (int i = 1; i < argc; i++) {
+        const char *const arg = argv[i];
+        const char *const value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
+            return 1;
+        }
+
+        if (arg[0] != '-') {
+            if (options->spec != NULL) {
+                logger_printf(LOG_LEVEL_ERROR, "unexpected argument: %s\n", arg);
+                return -1;
+            }
+
+            options->spec = arg;
+            continue;
+        }
+
+        if (value == NULL) {
+            logger_printf(LOG_LEVEL_ERROR, "missing value of option %s\n", arg);
+            return -1;
+        }
+
+        if (strcmp(arg, "-m") == 0 || strcmp(arg, "--memory") == 0) {
+            if (!parse_size(value, &options->budget) || options->budget == 0) {
+                logger_printf(LOG_LEVEL_ERROR, "invalid memory budget: %s\n", value);
+                return -1;
+            }
+        } else if (strcmp(arg, "-o") == 0 || strcmp(arg, "--output") == 0) {
+            options->output = value;
+        } else {
+            logger_printf(LOG_LEVEL_ERROR, "unknown option: %s\n", arg);
+            return -1;
+        }
+
+        i++;
+    }
+
+    if (options->spec == NULL) {
+        logger_print(LOG_LEVEL_ERROR, "missing world specification");
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Appends a suffix to a path.
+ * @return 0 on success, -1 on error.
+ */
+static int append_suffix(const char *const restrict path, const char *const restrict suffix,
+                         char *const restrict dst) {
+    const int n = snprintf(dst, PATH_MAX, "%s%s", path, suffix);
+
+    if (n < 0 || n >= PATH_MAX) {
+        logger_printf(LOG_LEVEL_ERROR, "path too long: %s\n", path);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Computes the bounding box of the walls of a world.
+ */
+static void world_bounds(const struct world_t *const world, struct vec_t *const min, struct vec_t *const max) {
+    *min = (struct vec_t) {INFINITY, INFINITY};
+    *max = (struct vec_t) {-INFINITY, -INFINITY};
+
+    for (size_t i = 0; i < world->nwalls; i++) {
+        *min = (struct vec_t) {fminf(min->x, world->walls[i].min.x), fminf(min->y, world->walls[i].min.y)};
+        *max = (struct vec_t) {fmaxf(max->x, world->walls[i].max.x), fmaxf(max->y, world->walls[i].max.y)};
+    }
+}
+
+/**
+ * @brief Estimates the number of walls the BVH tests per ray, by casting rays in random directions from random
+ *        points within the bounding box of the walls.
+ */
+static double walls_per_ray(const struct bvh_t *const bvh, const struct vec_t min, const struct vec_t max) {
+    size_t tested = 0;
+
+    srand(WORLDC_SAMPLE_SEED);
+
+    for (size_t i = 0; i < WORLDC_SAMPLE_RAYS; i++) {
+        const float u = (float) rand() / (float) RAND_MAX;
+        const float v = (float) rand() / (float) RAND_MAX;
+        const float angle = (float) rand() / (float) RAND_MAX * 2.0F * PI;
+        const struct vec_t pos = {min.x + u * (max.x - min.x), min.y + v * (max.y - min.y)};
+        float dist = INFINITY;
+
+        bvh_cast(bvh, pos, vfromangle(angle), &dist, &tested);
+    }
+
+    return (double) tested / WORLDC_SAMPLE_RAYS;
+}
+
+/**
+ * @brief Validates a world by building everything the game builds from it, and compiles it. Everything runs on
+ *        the calling thread, as the compiler does not link the SDL library.
+ * @return 0 on success, -1 on error.
+ */
+static int compile(const struct options_t *const options, const char *const output) {
+    struct world_t world;
+    struct wall_table_t walls;
+    struct sector_graph_t graph;
+    struct bvh_t bvh;
+    uint64_t hash;
+
+    if (worldbin_hash(options->spec, &hash) != 0 || load_world(options->spec, &world, options->budget, NULL) != 0) {
+        logger_printf(LOG_LEVEL_ERROR, "unable to load world '%s'\n", options->spec);
+        return -1;
+    }
+
+    struct optimize_stats_t optimized = {.walls = world.nwalls};
+
+    if ((WORLD_OPTIMIZE && optimize_world(&world, &optimized) != 0) || wall_table_build(&walls, &world) != 0) {
+        world_destroy(&world);
+        return -1;
+    }
+
+    /* the sectors and portals are checked by building the graph, which is not stored */
+    if (sector_graph_build(&graph, &world, &walls) != 0) {
+        logger_printf(LOG_LEVEL_ERROR, "invalid sectors or portals in '%s'\n", options->spec);
+        wall_table_destroy(&walls);
+        world_destroy(&world);
+        return -1;
+    }
+
+    sector_graph_destroy(&graph);
+
+    if (bvh_build(&bvh, &walls, NULL) != 0 || worldbin_save(output, hash, &world, &bvh) != 0) {
+        bvh_destroy(&bvh);
+        wall_table_destroy(&walls);
+        world_destroy(&world);
+        return -1;
+    }
+
+    struct vec_t min, max;
+
+    world_bounds(&world, &min, &max);
+
+    printf("walls:          %zu (%zu removed: %zu of zero length, %zu merged; %zu endpoints welded)\n",
+           world.nwalls, optimized.walls - world.nwalls, optimized.degenerate, optimized.merged, optimized.welded);
+    printf("sectors:        %zu\n", world.nsectors);
+    printf("portals:        %zu\n", world.nportals);
+
+    if (world.nwalls > 0) {
+        printf("bounds:         (%g, %g) - (%g, %g)\n", (double) min.x, (double) min.y, (double) max.x,
+               (double) max.y);
+        printf("bvh:            %zu nodes, %zu leaves, depth %zu\n", bvh.nnodes, bvh.nleaves, bvh.depth);
+        printf("walls per ray:  %.1f (of %zu, estimated from %d rays)\n", walls_per_ray(&bvh, min, max),
+               world.nwalls, WORLDC_SAMPLE_RAYS);
+    }
+
+    bvh_destroy(&bvh);
+    wall_table_destroy(&walls);
+    world_destroy(&world);
+    return 0;
+}
+
+int main(const int argc, char **const argv) {
+    struct options_t options;
+    const int parsed = parse_options(argc, argv, &options);
+
+    if (parsed != 0) {
+        usage(argv[0]);
+        return parsed > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    char output[PATH_MAX];
+
+    if (options.output == NULL && append_suffix(options.spec, WORLD_COMPILED_SUFFIX, output) != 0) {
+        return EXIT_FAILURE;
+    }
+
+    return compile(&options, options.output == NULL ? output : options.output) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,527 @@
+#include <inttypes.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/logger.h"
+
+
+/**
+ * Bounds of the number of walls of a generated world.
+ */
+#define WORLDGEN_WALLS_MIN 10
+#define WORLDGEN_WALLS_MAX 10000000
+
+/**
+ * Number of walls generated unless requested otherwise.
+ */
+#define WORLDGEN_WALLS_DEFAULT 1000
+
+/**
+ * Width of a cell of a maze, in world units.
+ */
+#define MAZE_CELL 100
+
+/**
+ * Width of a lot of a city, and of the streets between the lots, in world units.
+ */
+#define CITY_LOT 400
+#define CITY_STREET 100
+
+/**
+ * Distance between the centers of the pillars of a cave, in world units.
+ */
+#define CAVE_CELL 400
+
+/**
+ * Bounds of the number of vertices and of the radius of a pillar of a cave.
+ */
+#define CAVE_VERTICES_MIN 6
+#define CAVE_VERTICES_MAX 18
+#define CAVE_RADIUS_MIN 60
+#define CAVE_RADIUS_MAX 150
+
+/**
+ * Number of directions around the center of a pillar its vertices may lie in, a multiple of 4.
+ */
+#define CAVE_ANGLES 256
+
+/**
+ * Area per wall of a cluttered world, in square world units, and the maximum length of most of its walls.
+ */
+#define CLUTTER_AREA 400
+#define CLUTTER_LENGTH 100
+
+/**
+ * One in this many walls of a cluttered world is long, reaching up to a quarter of the world across.
+ */
+#define CLUTTER_LONG 20
+
+/**
+ * Size of the buffer of the output stream, in bytes.
+ */
+#define WORLDGEN_BUFFER (1 << 20)
+
+
+/**
+ * @brief The state of a generator: the output, the random number generator and the number of walls written.
+ *
+ * The random numbers come from SplitMix64 rather than rand(), so that a seed yields the same world everywhere.
+ */
+struct gen_t {
+    FILE *stream; /**< The stream the walls are written to. */
+    uint64_t state; /**< The state of the random number generator. */
+    size_t nwalls; /**< The number of walls written so far. */
+    size_t limit; /**< The number of walls to write. */
+};
+
+/**
+ * @brief A kind of world and the function generating it, which writes walls until the limit is reached.
+ */
+struct kind_t {
+    const char *name; /**< The name of the kind on the command line. */
+    const char *description; /**< A description of the kind for the help message. */
+    int (*generate)(struct gen_t *gen); /**< Generates the world; returns 0 on success, -1 on error. */
+};
+
+/**
+ * @brief The options of the generator.
+ */
+struct options_t {
+    const struct kind_t *kind; /**< The kind of world to generate. */
+    const char *output; /**< The path of the world specification to write, or NULL to write to stdout. */
+    uint64_t seed; /**< The seed of the random number generator. */
+    size_t nwalls; /**< The number of walls to generate. */
+};
+
+
+static const uint32_t MAZE_COLORS[] = {0xB0B0B0, 0x707070};
+static const uint32_t CITY_COLORS[] = {0x8C6E5A, 0xA0A0A0, 0xC8B48C, 0x5A6E82, 0xB45A46, 0xDCDCD2};
+static const uint32_t CAVE_COLORS[] = {0x5A4632, 0x6E5A3C, 0x78644B, 0x4B4137};
+
+/**
+ * The sine of the directions of the first quadrant, in units of 1/65536. The pillars are computed from this table
+ * rather than sinf() and cosf(), whose results differ between C libraries.
+ */
+static const int32_t CAVE_SINES[CAVE_ANGLES / 4 + 1] = {
+        0, 1608, 3216, 4821, 6424, 8022, 9616, 11204, 12785, 14359, 15924, 17479, 19024, 20557, 22078, 23586, 25080,
+        26558, 28020, 29466, 30893, 32303, 33692, 35062, 36410, 37736, 39040, 40320, 41576, 42806, 44011, 45190,
+        46341, 47464, 48559, 49624, 50660, 51665, 52639, 53581, 54491, 55368, 56212, 57022, 57798, 58538, 59244,
+        59914, 60547, 61145, 61705, 62228, 62714, 63162, 63572, 63944, 64277, 64571, 64827, 65043, 65220, 65358,
+        65457, 65516, 65536
+};
+
+
+static inline uint64_t next_random(struct gen_t *const gen) {
+    uint64_t z = (gen->state += 0x9E3779B97F4A7C15U);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9U;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBU;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief Returns a random number in [0, n), n > 0.
+ */
+static inline uint32_t random_below(struct gen_t *const gen, const uint32_t n) {
+    return (uint32_t) (next_random(gen) % n);
+}
+
+/**
+ * @brief Writes a wall, unless the limit is reached.
+ * @return true if the wall was written, false if the limit is reached.
+ */
+static bool emit(struct gen_t *const gen, const uint32_t x1, const uint32_t y1, const uint32_t x2, const uint32_t y2,
+                 const uint32_t color, const bool solid) {
+    if (gen->nwalls >= gen->limit) {
+        return false;
+    }
+
+    fprintf(gen->stream, "wall %" PRIu32 " %" PRIu32 " %" PRIu32 " %" PRIu32 " #%06" PRIX32 " %s\n",
+            x1, y1, x2, y2, color, solid ? "solid" : "nonsolid");
+    gen->nwalls++;
+    return true;
+}
+
+/**
+ * @brief Generates a perfect maze on a square grid, carved by a randomized depth-first search.
+ *
+ * The walls are written one per cell side, so that long corridors are made of many collinear walls.
+ */
+static int generate_maze(struct gen_t *const gen) {
+    enum unused { EAST = 1 << 0, SOUTH = 1 << 1, VISITED = 1 << 2 };
+
+    /* a maze of n x n cells keeps n * n + 2 * n + 1 of its walls */
+    const uint32_t n = (uint32_t) ceil(sqrt((double) gen->limit));
+    const size_t ncells = (size_t) n * n;
+    uint8_t *const cells = malloc(ncells * sizeof *cells);
+    uint32_t *const stack = malloc(ncells * sizeof *stack);
+
+    if (cells == NULL || stack == NULL) {
+        logger_perror("malloc");
+        free(stack);
+        free(cells);
+        return -1;
+    }
+
+    memset(cells, EAST | SOUTH, ncells * sizeof *cells);
+
+    size_t depth = 0;
+    stack[depth++] = (uint32_t) (ncells / 2);
+    cells[ncells / 2] |= VISITED;
+
+    while (depth > 0) {
+        const uint32_t cell = stack[depth - 1];
+        const uint32_t x = cell % n;
+        const uint32_t y = cell / n;
+        uint32_t neighbours[4];
+        uint32_t count = 0;
+
+        if (x > 0 && (cells[cell - 1] & VISITED) == 0) {
+            neighbours[count++] = cell - 1;
+        }
+
+        if (x + 1 < n && (cells[cell + 1] & VISITED) == 0) {
+            neighbours[count++] = cell + 1;
+        }
+
+        if (y > 0 && (cells[cell - n] & VISITED) == 0) {
+            neighbours[count++] = cell - n;
+        }
+
+        if (y + 1 < n && (cells[cell + n] & VISITED) == 0) {
+            neighbours[count++] = cell + n;
+        }
+
+        if (count == 0) {
+            depth--;
+            continue;
+        }
+
+        /* remove the wall between the cell and the neighbour, which is stored with the cell to the west or north */
+        const uint32_t next = neighbours[random_below(gen, count)];
+        const uint32_t first = cell < next ? cell : next;
+
+        cells[first] &= (uint8_t) ~(next == cell + 1 || next + 1 == cell ? EAST : SOUTH);
+        cells[next] |= VISITED;
+        stack[depth++] = next;
+    }
+
+    bool open = true;
+
+    for (uint32_t i = 0; i < n && open; i++) {
+        open = emit(gen, i * MAZE_CELL, 0, (i + 1) * MAZE_CELL, 0, MAZE_COLORS[0], true) &&
+               emit(gen, 0, i * MAZE_CELL, 0, (i + 1) * MAZE_CELL, MAZE_COLORS[1], true);
+    }
+
+    for (size_t i = 0; i < ncells && open; i++) {
+        const uint32_t x = (uint32_t) (i % n) * MAZE_CELL;
+        const uint32_t y = (uint32_t) (i / n) * MAZE_CELL;
+
+        open = ((cells[i] & SOUTH) == 0 || emit(gen, x, y + MAZE_CELL, x + MAZE_CELL, y + MAZE_CELL,
+                                                MAZE_COLORS[0], true)) &&
+               ((cells[i] & EAST) == 0 || emit(gen, x + MAZE_CELL, y, x + MAZE_CELL, y + MAZE_CELL,
+                                               MAZE_COLORS[1], true));
+    }
+
+    free(stack);
+    free(cells);
+    return 0;
+}
+
+/**
+ * @brief Writes the walls of an axis-aligned rectangle.
+ * @return true if all walls were written, false if the limit is reached.
+ */
+static bool emit_box(struct gen_t *const gen, const uint32_t x1, const uint32_t y1, const uint32_t x2,
+                     const uint32_t y2, const uint32_t color) {
+    return emit(gen, x1, y1, x2, y1, color, true) && emit(gen, x2, y1, x2, y2, color, true) &&
+           emit(gen, x2, y2, x1, y2, color, true) && emit(gen, x1, y2, x1, y1, color, true);
+}
+
+/**
+ * @brief Generates a city: a grid of lots separated by streets, with one to four rectangular buildings per lot.
+ *
+ * The city is about as many lots wide as it is deep; rows of lots are added until the limit is reached.
+ */
+static int generate_city(struct gen_t *const gen) {
+    enum unused { PITCH = CITY_LOT + CITY_STREET, BUILDINGS_PER_LOT = 2, WALLS_PER_LOT = 4 * BUILDINGS_PER_LOT };
+
+    const uint32_t columns = (uint32_t) ceil(sqrt((double) gen->limit / WALLS_PER_LOT));
+    bool open = true;
+
+    for (uint32_t lot = 0; open; lot++) {
+        const uint32_t x = CITY_STREET + lot % columns * PITCH;
+        const uint32_t y = CITY_STREET + lot / columns * PITCH;
+
+        /* every lot is split into 1 or 2 parcels along each axis, with a building set back on every parcel */
+        const uint32_t nx = 1 + random_below(gen, 2);
+        const uint32_t ny = 1 + random_below(gen, 2);
+        const uint32_t width = CITY_LOT / nx;
+        const uint32_t depth = CITY_LOT / ny;
+
+        for (uint32_t i = 0; i < nx * ny && open; i++) {
+            const uint32_t px = x + i % nx * width;
+            const uint32_t py = y + i / nx * depth;
+            const uint32_t left = 10 + random_below(gen, width / 4);
+            const uint32_t right = 10 + random_below(gen, width / 4);
+            const uint32_t front = 10 + random_below(gen, depth / 4);
+            const uint32_t back = 10 + random_below(gen, depth / 4);
+            const uint32_t color = CITY_COLORS[random_below(gen, sizeof CITY_COLORS / sizeof *CITY_COLORS)];
+
+            open = emit_box(gen, px + left, py + front, px + width - right, py + depth - back, color);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Returns the sine of a direction around the center of a pillar, in units of 1/65536.
+ */
+static inline int32_t cave_sine(const uint32_t angle) {
+    const uint32_t quadrant = angle / (CAVE_ANGLES / 4) % 4;
+    const uint32_t step = angle % (CAVE_ANGLES / 4);
+    const int32_t sine = CAVE_SINES[quadrant % 2 == 0 ? step : CAVE_ANGLES / 4 - step];
+
+    return quadrant < 2 ? sine : -sine;
+}
+
+/**
+ * @brief Offsets a coordinate by radius * sine / 65536, rounded to the nearest integer.
+ */
+static inline uint32_t cave_offset(const uint32_t coord, const uint32_t radius, const int32_t sine) {
+    const int64_t product = (int64_t) radius * sine;
+
+    return (uint32_t) ((int64_t) coord + (product + (product < 0 ? -32768 : 32768)) / 65536);
+}
+
+/**
+ * @brief Generates a cave: random star-shaped pillars of rock on a jittered grid, enclosed by the cave wall.
+ *
+ * Four walls are kept for the enclosure, which is written last around all pillars.
+ */
+static int generate_caves(struct gen_t *const gen) {
+    enum unused { WALLS_PER_PILLAR = (CAVE_VERTICES_MIN + CAVE_VERTICES_MAX) / 2, ENCLOSURE = 4 };
+
+    const size_t limit = gen->limit;
+    const uint32_t columns = (uint32_t) ceil(sqrt((double) limit / WALLS_PER_PILLAR));
+    uint32_t rows = 0;
+
+    gen->limit -= ENCLOSURE;
+
+    for (uint32_t cell = 0; gen->nwalls < gen->limit; cell++) {
+        const uint32_t jitter = CAVE_CELL / 2 - CAVE_RADIUS_MAX;
+        const uint32_t cx = cell % columns * CAVE_CELL + CAVE_CELL / 2 - jitter + random_below(gen, 2 * jitter + 1);
+        const uint32_t cy = cell / columns * CAVE_CELL + CAVE_CELL / 2 - jitter + random_below(gen, 2 * jitter + 1);
+        const uint32_t nvertices = CAVE_VERTICES_MIN + random_below(gen, CAVE_VERTICES_MAX - CAVE_VERTICES_MIN + 1);
+        const uint32_t color = CAVE_COLORS[random_below(gen, sizeof CAVE_COLORS / sizeof *CAVE_COLORS)];
+        uint32_t vertices[CAVE_VERTICES_MAX][2];
+
+        /* the vertices lie at increasing angles around the center, so the pillar does not intersect itself */
+        for (uint32_t i = 0; i < nvertices; i++) {
+            const uint32_t angle = (CAVE_ANGLES * i + random_below(gen, CAVE_ANGLES * 4 / 5)) / nvertices;
+            const uint32_t radius = CAVE_RADIUS_MIN + random_below(gen, CAVE_RADIUS_MAX - CAVE_RADIUS_MIN + 1);
+
+            vertices[i][0] = cave_offset(cx, radius, cave_sine(angle + CAVE_ANGLES / 4));
+            vertices[i][1] = cave_offset(cy, radius, cave_sine(angle));
+        }
+
+        for (uint32_t i = 0; i < nvertices; i++) {
+            const uint32_t *const a = vertices[i];
+            const uint32_t *const b = vertices[(i + 1) % nvertices];
+
+            emit(gen, a[0], a[1], b[0], b[1], color, true);
+        }
+
+        rows = cell / columns + 1;
+    }
+
+    gen->limit = limit;
+    emit_box(gen, 0, 0, columns * CAVE_CELL, rows * CAVE_CELL, CAVE_COLORS[0]);
+    return 0;
+}
+
+/**
+ * @brief Offsets a coordinate by delta - bias, clamped to [0, size].
+ */
+static inline uint32_t clamp(const uint32_t coord, const uint32_t delta, const uint32_t bias, const uint32_t size) {
+    const int64_t value = (int64_t) coord + delta - bias;
+    return value < 0 ? 0 : value > size ? size : (uint32_t) value;
+}
+
+/**
+ * @brief Generates the worst case for the acceleration structures: randomly placed walls of random lengths and
+ *        colors, crossing each other everywhere, with a few long walls spanning many cells.
+ */
+static int generate_clutter(struct gen_t *const gen) {
+    const uint32_t size = (uint32_t) ceil(sqrt((double) gen->limit * CLUTTER_AREA));
+
+    while (gen->nwalls < gen->limit) {
+        const uint32_t length = random_below(gen, CLUTTER_LONG) == 0 ? size / 4 + 1 : CLUTTER_LENGTH;
+        const uint32_t x1 = random_below(gen, size + 1);
+        const uint32_t y1 = random_below(gen, size + 1);
+        const uint32_t dx = random_below(gen, 2 * length + 1);
+        const uint32_t dy = random_below(gen, 2 * length + 1);
+
+        /* the other endpoint is clamped to the world, and moved if it coincides with the first one */
+        uint32_t x2 = clamp(x1, dx, length, size);
+        const uint32_t y2 = clamp(y1, dy, length, size);
+
+        if (x2 == x1 && y2 == y1) {
+            x2 = x1 > 0 ? x1 - 1 : x1 + 1;
+        }
+
+        emit(gen, x1, y1, x2, y2, (uint32_t) next_random(gen) & 0xFFFFFF, random_below(gen, 10) > 0);
+    }
+
+    return 0;
+}
+
+
+static const struct kind_t KINDS[] = {
+        {"maze", "a perfect maze on a square grid", generate_maze},
+        {"city", "rectangular buildings on lots separated by streets", generate_city},
+        {"caves", "random polygonal pillars within a cave", generate_caves},
+        {"clutter", "randomly placed walls crossing each other, the worst case", generate_clutter}
+};
+
+
+static inline void usage(const char *const argv0) {
+    static const char *const fmt = "usage: %s [-h|--help] [-n|--walls N] [-o|--output PATH] [-s|--seed SEED] KIND\n"
+                                   "\t-h, --help\t\tprint this help message and exit\n"
+                                   "\t-n, --walls N\t\tgenerate N walls instead of %d (%d to %d)\n"
+                                   "\t-o, --output PATH\twrite the world specification to PATH instead of stdout\n"
+                                   "\t-s, --seed SEED\t\tseed the random number generator with SEED instead of 1\n"
+                                   "\nKinds of worlds:\n";
+
+    fprintf(stderr, fmt, argv0, WORLDGEN_WALLS_DEFAULT, WORLDGEN_WALLS_MIN, WORLDGEN_WALLS_MAX);
+
+    for (size_t i = 0; i < sizeof KINDS / sizeof *KINDS; i++) {
+        fprintf(stderr, "\t%-8s  %s\n", KINDS[i].name, KINDS[i].description);
+    }
+
+    fputs("\nLarge worlds need a larger memory budget than the game's default, see its --memory option.\n", stderr);
+}
+
+static bool parse_number(const char *const restrict str, uint64_t *const restrict dst) {
+    char *end = NULL;
+    const unsigned long long value = strtoull(str, &end, 10);
+
+    if (end == str || *end != '\0' || str[0] == '-') {
+        return false;
+    }
+
+    *dst = (uint64_t) value;
+    return true;
+}
+
+/**
+ * @brief Parses the command line.
+ * @return 0 on success, 1 if the help was requested, -1 on error.
+ */
+static int parse_options(const int argc, char *const *const restrict argv, struct options_t *const restrict options) {
+    *options = (struct options_t) {.seed = 1, .nwalls = WORLDGEN_WALLS_DEFAULT};
+
+    for (int i = 1; i < argc; i++) {
+        const char *const arg = argv[i];
+        const char *const value = i + 1 < argc ? argv[i + 1] : NULL;
+        uint64_t number = 0;
+
+        if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) {
+            return 1;
+        }
+
+        if (arg[0] != '-') {
+            if (options->kind != NULL) {
+                logger_printf(LOG_LEVEL_ERROR, "unexpected argument: %s\n", arg);
+                return -1;
+            }
+
+            for (size_t j = 0; j < sizeof KINDS / sizeof *KINDS; j++) {
+                options->kind = strcmp(arg, KINDS[j].name) == 0 ? &KINDS[j] : options->kind;
+            }
+
+            if (options->kind == NULL) {
+                logger_printf(LOG_LEVEL_ERROR, "unknown kind of world: %s\n", arg);
+                return -1;
+            }
+
+            continue;
+        }
+
+        if (value == NULL) {
+            logger_printf(LOG_LEVEL_ERROR, "missing value of option %s\n", arg);
+            return -1;
+        }
+
+        if (strcmp(arg, "-n") == 0 || strcmp(arg, "--walls") == 0) {
+            if (!parse_number(value, &number) || number < WORLDGEN_WALLS_MIN || number > WORLDGEN_WALLS_MAX) {
+                logger_printf(LOG_LEVEL_ERROR, "invalid number of walls: %s\n", value);
+                return -1;
+            }
+
+            options->nwalls = (size_t) number;
+        } else if (strcmp(arg, "-o") == 0 || strcmp(arg, "--output") == 0) {
+            options->output = value;
+        } else if (strcmp(arg, "-s") == 0 || strcmp(arg, "--seed") == 0) {
+            if (!parse_number(value, &options->seed)) {
+                logger_printf(LOG_LEVEL_ERROR, "invalid seed: %s\n", value);
+                return -1;
+            }
+        } else {
+            logger_printf(LOG_LEVEL_ERROR, "unknown option: %s\n", arg);
+            return -1;
+        }
+
+        i++;
+    }
+
+    if (options->kind == NULL) {
+        logger_print(LOG_LEVEL_ERROR, "missing kind of world");
+        return -1;
+    }
+
+    return 0;
+}
+
+int main(const int argc, char **const argv) {
+    struct options_t options;
+    const int parsed = parse_options(argc, argv, &options);
+
+    if (parsed != 0) {
+        usage(argv[0]);
+        return parsed > 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    FILE *const stream = options.output == NULL ? stdout : fopen(options.output, "w");
+
+    if (stream == NULL) {
+        logger_perror("fopen");
+        return EXIT_FAILURE;
+    }
+
+    static char buffer[WORLDGEN_BUFFER];
+    setvbuf(stream, buffer, _IOFBF, sizeof buffer);
+
+    struct gen_t gen = {
+            .stream = stream,
+            .state = options.seed,
+            .limit = options.nwalls
+    };
+
+    const int ret = options.kind->generate(&gen);
+    const bool failed = ret != 0 || ferror(stream) != 0;
+
+    if ((stream != stdout ? fclose(stream) : fflush(stream)) != 0 || failed) {
+        logger_printf(LOG_LEVEL_ERROR, "unable to write '%s'\n", options.output == NULL ? "stdout" : options.output);
+        return EXIT_FAILURE;
+    }
+
+    fprintf(stderr, "generated %s world of %zu walls (seed %" PRIu64 ")\n", options.kind->name, gen.nwalls,
+            options.seed);
+    return EXIT_SUCCESS;
+}